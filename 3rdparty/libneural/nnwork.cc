@@ -115,6 +115,22 @@ int nnwork::get_layersize (int layer)
 	}
 }
 
+float nnwork::get_weight (int layer, int node, int index)
+{
+	switch (layer) {
+		case (HIDDEN):
+			return hidden_nodes -> nodes [node].weights [index];
+
+		case (OUTPUT):
+			return output_nodes -> nodes [node].weights [index];
+
+		default: {
+			cerr << "Warning: no weights for layer: " << layer << endl;
+			return 0;
+		}
+	}
+}
+
 // Training routine for the network. Uses data as input, compares output with
 // desired output, computes errors, adjusts weights attached to each node,
 // then repeats until the mean squared error at the output is less than 
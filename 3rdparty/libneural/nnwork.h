@@ -51,6 +51,12 @@ public:
 
 	int get_layersize (int);
 
+// returns a connection weight - arguments are the layer (HIDDEN or OUTPUT),
+// the node within that layer and the node of the previous layer it connects
+// to. Useful for evaluating the network outside of run (e.g. in batches).
+
+	float get_weight (int, int, int);
+
 // Training args are input, desired output, minimum error, learning rate
 
 	void train (float [], float [], float, float);
@@ -1,7 +1,12 @@
 #include "cstdlib"
+#include <algorithm>
+#include <cfloat>
 #include <iostream>
+#include <vector>
 #include "string.h"
 
+#include <Eigen>
+
 #include "dynprog.h"
 #include "vec.h"
 #include "mat.h"
@@ -16,6 +21,9 @@
 
 using namespace VEC;
 
+typedef Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> RowMajorMatF;
+typedef Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> RowMajorMatD;
+
 int pngCnt = 0;
 float _LOG2 = logf(2);
 
@@ -25,6 +33,9 @@ float _LOG2 = logf(2);
 float sum(MatF &mat, int rowNum);
 float sumXSquared(MatF &mat, int rowNum);
 float sumOfProducts(MatF &mat1, int rowNum1, MatF &mat2, int rowNum2);
+void productsOfRows(MatF &mCoords, MatF &nCoords, std::vector<float> &products);
+void productsOfRowsBanded(MatF &mCoords, MatF &nCoords, DynProgBand &band, std::vector<float> &products);
+void rowMoments(MatF &mat, std::vector<double> &sums, std::vector<double> &sumSquares);
 void _subtract(MatF &mat, int rowNum, float val, MatF &minused);
 float entropy(MatF &mat, int rowNum, int numBins, float minVal, float scaleFactor, MatI &indArray);
 void entropyXY(MatI &binIndX, MatI &binIndY, VecF &entropyX, VecF &entropyY, MatF &scores, int numBins);
@@ -717,23 +728,12 @@ float DynProg::sum_sq_res_yeqx(VecF &m_tm, VecF &n_tm, VecI &mWarpMap, VecI &nWa
 }
 
 void DynProg::score_product(MatF &mCoords, MatF &nCoords, MatF &scores) {
-    int i;
     int s_mlen = mCoords.rows();// s_cols = length_n
     int s_nlen = nCoords.rows();// s_rows = length_m  // Both rows and cols derived from # rows
-    int cols = mCoords.cols();
-    assert(cols == nCoords.cols());
-    MatF tmp(s_mlen, s_nlen);
-    for (int m = 0; m < s_mlen; ++m) {
-        for (int n = 0; n < s_nlen; ++n) {
-            float sum = 0.0;
-            for (i = 0; i < cols; ++i) {
-                sum += mCoords(m,i) * nCoords(n,i);
-            }
-            tmp(m,n) = sum;
-            //printf("M: %d N: %d sum: %f\n", m, n, sum);
-        }
-    }
-    scores.take(tmp);
+    assert(mCoords.cols() == nCoords.cols());
+    std::vector<float> tmp;
+    productsOfRows(mCoords, nCoords, tmp);
+    scores.take(s_mlen, s_nlen, std::move(tmp));
 }
 
 void DynProg::score_covariance(MatF &mCoords, MatF &nCoords, MatF &scores) {
@@ -744,29 +744,21 @@ void DynProg::score_covariance(MatF &mCoords, MatF &nCoords, MatF &scores) {
     int s_nlen = nCoords.rows();// s_rows = length_m  // Both rows and cols derived from # rows
     int cols = mCoords.cols();
     assert(cols == nCoords.cols());
-    //printf("WORKING IN COVARIANCE\n");
-    MatF tmp(s_mlen, s_nlen);
 
-    double *sum_x = new double[s_nlen];
-    double *sum_y = new double[s_mlen];
-    int i;
-    for (i = 0; i < s_nlen; ++i) {
-        sum_x[i] = nCoords.sum(i);
-    }
-    for (i = 0; i < s_mlen; ++i) {
-        sum_y[i] = mCoords.sum(i);
-    }
+    std::vector<double> sum_x, sum_y, sumsq_x, sumsq_y;
+    rowMoments(nCoords, sum_x, sumsq_x);
+    rowMoments(mCoords, sum_y, sumsq_y);
 
-    // CALCULATE ALL PAIR calculations
-    for (int n = 0; n < s_nlen; ++n) {
-        for (int m = 0; m < s_mlen; ++m) {
-            tmp(m,n) = (sumOfProducts(mCoords, m, nCoords, n) -
-                ((sum_x[n] * sum_y[m])/cols))/cols;
+    // CALCULATE ALL PAIR calculations, starting from all sums of products
+    std::vector<float> tmp;
+    productsOfRows(mCoords, nCoords, tmp);
+    for (int m = 0; m < s_mlen; ++m) {
+        float* row = &tmp[(size_t)m * s_nlen];
+        for (int n = 0; n < s_nlen; ++n) {
+            row[n] = (row[n] - ((sum_x[n] * sum_y[m])/cols))/cols;
         }
     }
-    delete[] sum_x;
-    delete[] sum_y;
-    scores.take(tmp);
+    scores.take(s_mlen, s_nlen, std::move(tmp));
 }
 
 void DynProg::score_pearsons_r(MatF &mCoords, MatF &nCoords, MatF &scores) {
@@ -775,44 +767,38 @@ void DynProg::score_pearsons_r(MatF &mCoords, MatF &nCoords, MatF &scores) {
     int s_mlen = mCoords.rows();// s_rows = length_m  // Both rows and cols derived from # rows
     int cols = mCoords.cols();
     assert(cols == nCoords.cols());
-    MatF tmp(s_mlen, s_nlen);
 
     //printf("WORKING IN PEARSONS_R\n");
-    float *bot_x = new float[s_nlen]; 
-    float *bot_y = new float[s_mlen]; 
-    // Sum(x^2)
-    float *sum_x = new float[s_nlen]; 
-    float *sum_y = new float[s_mlen]; 
-
-    int i;
-    for (i = 0; i < s_nlen; ++i) {
-        sum_x[i] = nCoords.sum(i);
-        //         sum(x^2)                  -    ((sum_x)^2/num_elements
-        bot_x[i] = ( sumXSquared(nCoords,i) ) - ( ((sum_x[i])*sum_x[i])/cols);
+    std::vector<double> sum_x, sum_y, bot_x, bot_y;
+    rowMoments(nCoords, sum_x, bot_x);
+    rowMoments(mCoords, sum_y, bot_y);
+    for (int i = 0; i < s_nlen; ++i) {
+        //         sum(x^2)   -    ((sum_x)^2/num_elements
+        bot_x[i] = bot_x[i] - ((sum_x[i] * sum_x[i]) / cols);
     }
-    for (i = 0; i < s_mlen; ++i) {
-        sum_y[i] = mCoords.sum(i);
-        //         sum(y^2)                  -    ((sum_y)^2/num_elements
-        bot_y[i] = ( sumXSquared(mCoords,i) ) - ( ((sum_y[i])*sum_y[i])/cols );
+    for (int i = 0; i < s_mlen; ++i) {
+        //         sum(y^2)   -    ((sum_y)^2/num_elements
+        bot_y[i] = bot_y[i] - ((sum_y[i] * sum_y[i]) / cols);
     }
 
-    // CALCULATE ALL PAIR calculations
-    for (int n = 0; n < s_nlen; ++n) {
-        for (int m = 0; m < s_mlen; ++m) {
+    // CALCULATE ALL PAIR calculations, starting from all sums of products
+    std::vector<float> tmp;
+    productsOfRows(mCoords, nCoords, tmp);
+    for (int m = 0; m < s_mlen; ++m) {
+        float* row = &tmp[(size_t)m * s_nlen];
+        for (int n = 0; n < s_nlen; ++n) {
             double bot = sqrt(bot_x[n] * bot_y[m]);
             if (bot == 0) {
                 // no undefined
-                tmp(m, n) = 0;
+                row[n] = 0;
             } else {
                 // sum(X * Y) - (sum(x) * sum(y))/num_elements
-                double top = sumOfProducts(mCoords, m, nCoords, n)
-                             - ((sum_x[n] * sum_y[m]) / cols);
-                tmp(m, n) = static_cast<float>(top / bot);
+                double top = row[n] - ((sum_x[n] * sum_y[m]) / cols);
+                row[n] = static_cast<float>(top / bot);
             }
         }
     }
-    delete[] bot_x; delete[] bot_y; delete[] sum_x; delete[] sum_y;
-    scores.take(tmp);
+    scores.take(s_mlen, s_nlen, std::move(tmp));
 }
 
 
@@ -959,6 +945,163 @@ void DynProg::score(MatF &mCoords, MatF &nCoords, MatF &scores, const char *type
 }
 
 
+void DynProgBand::set(std::vector<int> &rowStart, std::vector<int> &rowEnd, int numCols) {
+    int rows = rowStart.size();
+    assert(rows == (int)rowEnd.size());
+    cols = numCols;
+    start.resize(rows);
+    end.resize(rows);
+    offset.resize(rows);
+    int size = 0;
+    for (int m = 0; m < rows; ++m) {
+        int s = max(0, min(rowStart[m], cols - 1));
+        int e = min(cols, rowEnd[m]);
+        if (m == 0) {
+            s = 0;
+        }
+        else {
+            // keep every row reachable from the one above it
+            s = max(s, start[m - 1]);
+            s = min(s, end[m - 1]);
+            e = max(e, end[m - 1]);
+        }
+        if (m == rows - 1) { e = cols; }
+        e = max(e, s + 1);
+        start[m] = s;
+        end[m] = e;
+        offset[m] = size;
+        size += e - s;
+    }
+}
+
+bool DynProgBand::on_edge(int m, int n) const {
+    return (n == start[m] && n > 0) || (n == end[m] - 1 && n < cols - 1);
+}
+
+bool DynProg::score_banded(MatF &mCoords, MatF &nCoords, DynProgBand &band, VecF &scores, const char *type) {
+    bool product = !strcmp(type,"prd");
+    bool covariance = !strcmp(type,"cov");
+    bool pearsons_r = !strcmp(type,"cor");
+    if (!product && !covariance && !pearsons_r) {
+        return false;
+    }
+
+    int s_mlen = mCoords.rows();
+    int s_nlen = nCoords.rows();
+    int cols = mCoords.cols();
+    assert(cols == nCoords.cols());
+    assert(s_mlen == band.rows() && s_nlen == band.cols);
+
+    std::vector<float> tmp;
+    productsOfRowsBanded(mCoords, nCoords, band, tmp);
+    if (product) {
+        scores.take(band.size(), std::move(tmp));
+        return true;
+    }
+
+    // same as score_covariance and score_pearsons_r, for in-band cells only
+    std::vector<double> sum_x, sum_y, bot_x, bot_y;
+    rowMoments(nCoords, sum_x, bot_x);
+    rowMoments(mCoords, sum_y, bot_y);
+    for (int i = 0; i < s_nlen; ++i) {
+        bot_x[i] = bot_x[i] - ((sum_x[i] * sum_x[i]) / cols);
+    }
+    for (int i = 0; i < s_mlen; ++i) {
+        bot_y[i] = bot_y[i] - ((sum_y[i] * sum_y[i]) / cols);
+    }
+    for (int m = 0; m < s_mlen; ++m) {
+        float* row = &tmp[band.offset[m]] - band.start[m];
+        for (int n = band.start[m]; n < band.end[m]; ++n) {
+            if (covariance) {
+                row[n] = (row[n] - ((sum_x[n] * sum_y[m])/cols))/cols;
+                continue;
+            }
+            double bot = sqrt(bot_x[n] * bot_y[m]);
+            if (bot == 0) {
+                row[n] = 0;
+            } else {
+                double top = row[n] - ((sum_x[n] * sum_y[m]) / cols);
+                row[n] = static_cast<float>(top / bot);
+            }
+        }
+    }
+    scores.take(band.size(), std::move(tmp));
+    return true;
+}
+
+bool DynProg::score_gram(MatF &coords, DynProgGram &gram, const char *type) {
+    bool product = !strcmp(type,"prd");
+    bool covariance = !strcmp(type,"cov");
+    bool pearsons_r = !strcmp(type,"cor");
+    if (!product && !covariance && !pearsons_r) {
+        return false;
+    }
+
+    // rows are centered for covariance and correlation, then scaled so that
+    // their dot products are the scores of score_banded
+    const int blockRows = 256;
+    int rows = coords.rows();
+    int cols = coords.cols();
+    std::vector<double> sums, sumSquares;
+    rowMoments(coords, sums, sumSquares);
+
+    gram.rows = rows;
+    gram.sum.assign(cols, 0.0);
+    gram.gram.assign((size_t)cols * cols, 0.0);
+    Eigen::Map<RowMajorMatD> out(gram.gram.data(), cols, cols);
+    RowMajorMatD block;
+    for (int m0 = 0; m0 < rows; m0 += blockRows) {
+        int m1 = min(m0 + blockRows, rows);
+        block.resize(m1 - m0, cols);
+        for (int m = m0; m < m1; ++m) {
+            double shift = 0;
+            double scale = 1;
+            if (covariance) {
+                shift = sums[m] / cols;
+                scale = 1 / sqrt((double)cols);
+            } else if (pearsons_r) {
+                shift = sums[m] / cols;
+                double bot = sumSquares[m] - ((sums[m] * sums[m]) / cols);
+                scale = bot > 0 ? 1 / sqrt(bot) : 0;
+            }
+            float* ptr = coords.rowData(m);
+            for (int i = 0; i < cols; ++i) {
+                double val = (ptr[i] - shift) * scale;
+                block(m - m0, i) = val;
+                gram.sum[i] += val;
+            }
+        }
+        out.selfadjointView<Eigen::Lower>().rankUpdate(block.transpose());
+    }
+    return true;
+}
+
+void DynProg::score_moments(const DynProgGram &mGram, const DynProgGram &nGram, double &mean, double &stdev) {
+    assert(mGram.sum.size() == nGram.sum.size());
+    // every score is the dot product of an m row and an n row, so the sum of
+    // all scores is that of the row sums, and the sum of their squares that
+    // of the Gram matrices
+    double cells = (double)mGram.rows * nGram.rows;
+    double sum = 0;
+    double sumSq = 0;
+    for (size_t i = 0; i < mGram.sum.size(); ++i) {
+        sum += mGram.sum[i] * nGram.sum[i];
+    }
+    int cols = mGram.sum.size();
+    for (int i = 0; i < cols; ++i) {
+        const double* mRow = &mGram.gram[(size_t)i * cols];
+        const double* nRow = &nGram.gram[(size_t)i * cols];
+        sumSq += mRow[i] * nRow[i];
+        for (int j = 0; j < i; ++j) {
+            sumSq += 2 * mRow[j] * nRow[j];
+        }
+    }
+    mean = cells > 0 ? sum / cells : 0;
+    double var = sumSq - ((sum * sum) / cells);
+    var /= cells > 1 ? cells - 1 : 1;
+    stdev = var > 0 ? sqrt(var) : 0;
+}
+
 void DynProg::expandFlag(MatI &flagged, int flag, int numSteps, MatI &expanded) {
     int m_length = flagged.rows();
     int n_length = flagged.cols();
@@ -1083,6 +1226,71 @@ float sumOfProducts(MatF &mat1, int rowNum1, MatF &mat2, int rowNum2) {
     return sum;
 }
 
+// Sums of products of every row of mCoords with every row of nCoords, as an
+// (mCoords rows x nCoords rows) row-major matrix. This is the bulk of the
+// covariance and correlation scores, so it is done as a single blocked
+// matrix product instead of one dot product per pair. Both matrices are
+// mapped in place, the reference matrix in particular is never copied.
+void productsOfRows(MatF &mCoords, MatF &nCoords, std::vector<float> &products) {
+    int s_mlen = mCoords.rows();
+    int s_nlen = nCoords.rows();
+    int cols = mCoords.cols();
+    products.assign((size_t)s_mlen * s_nlen, 0.0f);
+    if (s_mlen == 0 || s_nlen == 0 || cols == 0)
+        return;
+
+    Eigen::Map<RowMajorMatF> mMat(mCoords.rowData(0), s_mlen, cols);
+    Eigen::Map<RowMajorMatF> nMat(nCoords.rowData(0), s_nlen, cols);
+    Eigen::Map<RowMajorMatF> out(products.data(), s_mlen, s_nlen);
+    out.noalias() = mMat * nMat.transpose();
+}
+
+// Same as productsOfRows, for the cells of a band only. Rows are processed in
+// blocks, each one a matrix product over the columns that the block spans.
+void productsOfRowsBanded(MatF &mCoords, MatF &nCoords, DynProgBand &band, std::vector<float> &products) {
+    const int blockRows = 64;
+    int s_mlen = mCoords.rows();
+    int s_nlen = nCoords.rows();
+    int cols = mCoords.cols();
+    products.assign(band.size(), 0.0f);
+    if (s_mlen == 0 || s_nlen == 0 || cols == 0)
+        return;
+
+    Eigen::Map<RowMajorMatF> mMat(mCoords.rowData(0), s_mlen, cols);
+    Eigen::Map<RowMajorMatF> nMat(nCoords.rowData(0), s_nlen, cols);
+    RowMajorMatF block;
+    for (int m0 = 0; m0 < s_mlen; m0 += blockRows) {
+        int m1 = min(m0 + blockRows, s_mlen);
+        int n0 = band.start[m0];
+        int n1 = band.end[m1 - 1];
+        block.noalias() = mMat.middleRows(m0, m1 - m0)
+                          * nMat.middleRows(n0, n1 - n0).transpose();
+        for (int m = m0; m < m1; ++m) {
+            const float* rowPtr = block.data() + (size_t)(m - m0) * (n1 - n0);
+            std::copy(rowPtr + (band.start[m] - n0),
+                      rowPtr + (band.end[m] - n0),
+                      products.begin() + band.offset[m]);
+        }
+    }
+}
+
+// Sum and sum of squares of every row, accumulated in double precision
+void rowMoments(MatF &mat, std::vector<double> &sums, std::vector<double> &sumSquares) {
+    sums.assign(mat.rows(), 0.0);
+    sumSquares.assign(mat.rows(), 0.0);
+    for (int m = 0; m < mat.rows(); ++m) {
+        float* ptr = mat.rowData(m);
+        double sum = 0;
+        double sumSq = 0;
+        for (int i = 0; i < mat.cols(); ++i) {
+            sum += ptr[i];
+            sumSq += (double)ptr[i] * ptr[i];
+        }
+        sums[m] = sum;
+        sumSquares[m] = sumSq;
+    }
+}
+
 // Returns the sum of the square of the values in the row number
 // could increase the speed here by getting the oneD version and doing pointer
 // math(?)
@@ -1315,3 +1523,164 @@ void DynProg::find_path(MatF& smat, VecF &gap_penalty, int minimize, float diag_
     _bestScore = tmp_asmat(_mCoords[_equivLastInd],_nCoords[_equivLastInd]);
 }
 
+bool DynProg::find_path_banded(DynProgBand &band, VecF &smat, VecF &gap_penalty, int minimize, float diag_factor, float gap_factor, int local, float init_penalty) {
+    int length_m = band.rows();
+    int length_n = band.cols;
+    assert(smat.len() == band.size());
+    assert(gap_penalty.len() > 0);
+
+    // Cells are indexed as laid out by the band; moves from outside of the
+    // band get a score that is never chosen.
+    VecF tmp_asmat(band.size());
+    VecI tmp_tb(band.size());
+    VecI tmp_gapmat(band.size());
+    float outside = minimize ? FLT_MAX : -FLT_MAX;
+
+    // ********************************************************
+    // * BEGIN CALC ADDITIVE SCORE MATRIX
+    // ********************************************************
+    // Initialize top left cell:
+    tmp_asmat[0]  = smat[0];
+    tmp_gapmat[0] = 0;
+    tmp_tb[0]     = 0;
+
+    // the left and top sides, as far as they lie within the band
+    int left_side_len = 1;
+    while (left_side_len < length_m && band.start[left_side_len] == 0) {
+        ++left_side_len;
+    }
+    int top_side_len = band.end[0];
+
+    for (int m = 1; m < left_side_len; ++m) {
+        int i = band.index(m, 0);
+        int above = band.index(m - 1, 0);
+        float top = (smat[i] * gap_factor) + tmp_asmat[above] - gap_penalty[tmp_gapmat[above]];
+        float best_val = top;
+        int best_pos = 1;  // path is from above
+        if (local) {
+            float diag = (smat[i] * diag_factor) - init_penalty;  // drop in from left side
+            if (minimize) { DynProg::_min(diag, top, outside, best_val, best_pos); }
+            else { DynProg::_max(diag, top, outside, best_val, best_pos); }
+        }
+        if (best_pos == 1) { tmp_gapmat[i] = tmp_gapmat[above] + 1; }
+        else { tmp_gapmat[i] = 0; }
+        tmp_asmat[i] = best_val; tmp_tb[i] = best_pos;
+    }
+    for (int n = 1; n < top_side_len; ++n) {
+        float left = (smat[n] * gap_factor) + tmp_asmat[n - 1] - gap_penalty[tmp_gapmat[n - 1]];
+        float best_val = left;
+        int best_pos = 2;  // path is from left
+        if (local) {
+            float diag = (smat[n] * diag_factor) - init_penalty;  // drop in from top
+            if (minimize) { DynProg::_min(diag, outside, left, best_val, best_pos); }
+            else { DynProg::_max(diag, outside, left, best_val, best_pos); }
+        }
+        if (best_pos == 2) { tmp_gapmat[n] = tmp_gapmat[n - 1] + 1; }
+        else { tmp_gapmat[n] = 0; }
+        tmp_asmat[n] = best_val; tmp_tb[n] = best_pos;
+    }
+
+    // COMPLETE the tmp_asmat:
+    for (int m = 1; m < length_m; ++m) {
+        for (int n = max(1, band.start[m]); n < band.end[m]; ++n) {
+            int i = band.index(m, n);
+            float smat_at_ind = smat[i];
+            float smat_at_ind_times_gap_factor = smat_at_ind * gap_factor;
+            float diag = outside;
+            float top = outside;
+            float left = outside;
+            if (band.contains(m - 1, n - 1)) {
+                diag = (smat_at_ind * diag_factor) + tmp_asmat[band.index(m - 1, n - 1)];
+            }
+            if (band.contains(m - 1, n)) {
+                int above = band.index(m - 1, n);
+                top = smat_at_ind_times_gap_factor + tmp_asmat[above] - gap_penalty[tmp_gapmat[above]];
+            }
+            if (band.contains(m, n - 1)) {
+                left = smat_at_ind_times_gap_factor + tmp_asmat[i - 1] - gap_penalty[tmp_gapmat[i - 1]];
+            }
+
+            float best_val; int best_pos;
+            if (minimize) { DynProg::_min(diag, top, left, best_val, best_pos); }
+            else { DynProg::_max(diag, top, left, best_val, best_pos); }
+
+            // SET the gap_length_matrix
+            if (best_pos == 1) { tmp_gapmat[i] = tmp_gapmat[band.index(m - 1, n)] + 1; }
+            else if (best_pos == 2) { tmp_gapmat[i] = tmp_gapmat[i - 1] + 1; }
+            else { tmp_gapmat[i] = 0; }
+            tmp_tb[i] = best_pos; tmp_asmat[i] = best_val;
+        }
+    }
+    //  ************************************************************
+    //  * END CALC ADD SCORE MATRIX
+    //  ************************************************************
+
+    int optimal_m = length_m - 1;
+    int optimal_n = length_n - 1;
+    if (local) {
+        // best of the right and bottom sides, with ties resolved as in
+        // _global_max and _global_min
+        float best_right = 0;
+        float best_bottom = 0;
+        int right_m = -1;
+        int bottom_n = -1;
+        for (int m = 0; m < length_m; ++m) {
+            if (band.end[m] != length_n) { continue; }
+            float val = tmp_asmat[band.index(m, length_n - 1)];
+            if (right_m == -1 || (minimize ? val <= best_right : val >= best_right)) {
+                best_right = val;
+                right_m = m;
+            }
+        }
+        for (int n = band.start[length_m - 1]; n < length_n; ++n) {
+            float val = tmp_asmat[band.index(length_m - 1, n)];
+            if (bottom_n == -1 || (minimize ? val <= best_bottom : val >= best_bottom)) {
+                best_bottom = val;
+                bottom_n = n;
+            }
+        }
+        if (minimize ? best_right < best_bottom : best_right > best_bottom) {
+            optimal_m = right_m;
+        }
+        else {
+            optimal_n = bottom_n;
+        }
+    }
+
+    // traceback, noting whether the path touches the edge of the band
+    bool within_band = true;
+    std::vector<int> m_eqr;
+    std::vector<int> n_eqr;
+    std::vector<float> score_pathr;
+    int m = optimal_m;
+    int n = optimal_n;
+    while (m != -1 && n != -1) {
+        int i = band.index(m, n);
+        if (band.on_edge(m, n)) { within_band = false; }
+        m_eqr.push_back(m);
+        n_eqr.push_back(n);
+        score_pathr.push_back(smat[i]);
+
+        int val = tmp_tb[i];
+        if (val == 0) { // Diag
+            m -= 1;
+            n -= 1;
+        }
+        else if (val == 1) { // UP
+            m -= 1;
+        }
+        else {  // val == 2  // Left
+            n -= 1;
+        }
+    }
+    std::reverse(m_eqr.begin(), m_eqr.end());
+    std::reverse(n_eqr.begin(), n_eqr.end());
+    std::reverse(score_pathr.begin(), score_pathr.end());
+    int cnt = m_eqr.size();
+    _mCoords.take(cnt, std::move(m_eqr));
+    _nCoords.take(cnt, std::move(n_eqr));
+    _sCoords.take(cnt, std::move(score_pathr));
+    _bestScore = tmp_asmat[band.index(optimal_m, optimal_n)];
+    _smat = nullptr;
+    return within_band;
+}
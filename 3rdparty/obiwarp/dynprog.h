@@ -2,12 +2,45 @@
 #define _DYNPROG_H
 
 #include "math.h"
+#include <vector>
 
 #include "vec.h"
 #include "mat.h"
 
 using namespace VEC;
 
+// Cells of a score matrix that a banded alignment may pass through: row m
+// spans columns [start[m], end[m]), and its cells are stored contiguously
+// from offset[m] (row-major, in-band cells only).
+struct DynProgBand {
+    std::vector<int> start;
+    std::vector<int> end;
+    std::vector<int> offset;
+    int cols;
+
+    // Set the column range of every row. Ranges are made monotonic and
+    // widened where needed, so that the band always connects the first and
+    // the last cell of the matrix.
+    void set(std::vector<int> &rowStart, std::vector<int> &rowEnd, int numCols);
+    int rows() const { return start.size(); }
+    int size() const { return offset.empty() ? 0 : offset.back() + end.back() - start.back(); }
+    bool contains(int m, int n) const { return n >= start[m] && n < end[m]; }
+    int index(int m, int n) const { return offset[m] + n - start[m]; }
+    // true if the cell is on a side of the band that is not also a side of
+    // the matrix
+    bool on_edge(int m, int n) const;
+};
+
+// Rows of one side of a score matrix, transformed so that the score of two
+// rows is their dot product: their sum and their Gram matrix (cols x cols,
+// row-major, lower triangle only). Together with those of the other side they give the moments
+// of the whole score matrix without computing it.
+struct DynProgGram {
+    std::vector<double> sum;
+    std::vector<double> gram;
+    int rows;
+};
+
 
 class DynProg {
     private:
@@ -32,6 +65,12 @@ class DynProg {
         // average matrix score will be used
         // neither diag or gap factor can be 0.0 for minimization
         void find_path(MatF &smat, VecF &gap_penalty, int minimize=0, float diag_factor=2.f, float gap_factor=1.f, int local=0, float init_penalty=0.0f);
+        // Same as find_path, but only cells within the band are computed.
+        // smat holds the scores of the band's cells (see score_banded) and
+        // gap_penalty must be given. Returns false if the best path touches
+        // an edge of the band, in which case a better path may lie outside
+        // of it and the full matrix should be aligned instead.
+        bool find_path_banded(DynProgBand &band, VecF &smat, VecF &gap_penalty, int minimize=0, float diag_factor=2.f, float gap_factor=1.f, int local=0, float init_penalty=0.0f);
         // If gap_penalty array len = 0, then a linear gap penalty based on the
         // average matrix score will be used
         // a gap is introduced without adding in the score of the matrix
@@ -92,6 +131,15 @@ class DynProg {
         void score_euclidean(MatF &mCoords, MatF &nCoords, MatF &scores);
         // convenience method for scoring
         void score(MatF &mCoords, MatF &nCoords, MatF &scores, const char *type, int mi_num_bins=2);
+        // Scores of the band's cells only, stored as laid out by the band.
+        // Supports "prd", "cov" and "cor"; returns false for other types.
+        bool score_banded(MatF &mCoords, MatF &nCoords, DynProgBand &band, VecF &scores, const char *type);
+        // Gram matrix of the rows of coords for the given score type, same
+        // types as score_banded; returns false for other types.
+        bool score_gram(MatF &coords, DynProgGram &gram, const char *type);
+        // Mean and sample standard deviation of all cells of the score matrix
+        // of mCoords and nCoords, from the score_gram of both
+        void score_moments(const DynProgGram &mGram, const DynProgGram &nGram, double &mean, double &stdev);
 							 
 //   DynProg::expandFlag(mat1, 2, 1)
 //   
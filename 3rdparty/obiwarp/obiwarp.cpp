@@ -1,7 +1,9 @@
+#include <algorithm>
+
 #include "obiwarp.h"
 
 ObiParams::ObiParams(string score,bool local, float factor_diag, float factor_gap, float gap_init,float gap_extend,
-            float init_penalty, float response, bool nostdnrm, float binSize){
+            float init_penalty, float response, bool nostdnrm, float binSize, float maxRtShift){
 
     this->score = score;
     this->local = local;
@@ -13,11 +15,12 @@ ObiParams::ObiParams(string score,bool local, float factor_diag, float factor_ga
     this->response = response;
     this->nostdnrm = nostdnrm;
     this->binSize = binSize;
+    this->maxRtShift = maxRtShift;
 }
 
 ObiWarp::ObiWarp(ObiParams *obiParams){
 
-    this->score = &obiParams->score[0];
+    this->score = obiParams->score;
     this->local = obiParams->local;
     this->factor_diag = obiParams->factor_diag;
     this->factor_gap = obiParams->factor_gap;
@@ -26,13 +29,14 @@ ObiWarp::ObiWarp(ObiParams *obiParams){
     this->init_penalty = obiParams->init_penalty;
     this->response = obiParams->response;
     this->nostdnrm = obiParams->nostdnrm;
+    this->max_rt_shift = obiParams->maxRtShift;
 }
 
 ObiWarp::~ObiWarp(){
 
 }
 
-void ObiWarp::setReferenceData(vector<float> &rtPoints, vector<float> &mzPoints, vector<vector<float> >& intMat){
+void ObiWarp::setReferenceData(vector<float> &rtPoints, vector<float> &mzPoints, vector<float> intMat){
     tmPoint = rtPoints;
     _tm_vals = tmPoint.size();
     _tm.take(_tm_vals, tmPoint);
@@ -41,18 +45,22 @@ void ObiWarp::setReferenceData(vector<float> &rtPoints, vector<float> &mzPoints,
     _mz_vals = mzPoint.size();
     _mz.take(_mz_vals, mzPoint);
 
-    assert(_tm_vals == intMat.size());
-    MatF mat(_tm_vals, _mz_vals);
-    for(int i=0; i < _tm_vals; ++i){
-        assert(_mz_vals == intMat[i].size());
-        for(int j = 0; j < _mz_vals; ++j)
-            mat(i,j) = intMat[i][j];
-    }
-    _mat.take(mat);
+    assert(_tm_vals * _mz_vals == intMat.size());
+    _mat.take(_tm_vals, _mz_vals, std::move(intMat));
 
+    // banded scores are normalised with the moments of the full score
+    // matrix, which take a (mz x mz) Gram matrix of each side; beyond as many
+    // mz points as rt points it would outgrow the score matrix itself
+    _gram = DynProgGram();
+    if (banded() && !nostdnrm && _mz_vals <= _tm_vals) {
+        DynProg dyn;
+        dyn.score_gram(_mat, _gram, score.c_str());
+    }
+    if (banded())
+        resample(_tm, _mat, _coarse_tm, _coarse_mat);
 }
 
-vector<float> ObiWarp::align(vector<float> &rtPoints, vector<float> &mzPoints, vector<vector<float> >& intMat){
+vector<float> ObiWarp::align(vector<float> &rtPoints, vector<float> &mzPoints, vector<float> intMat) const {
     
     VecF tm;
     vector<float> tmPoint(rtPoints);
@@ -64,30 +72,26 @@ vector<float> ObiWarp::align(vector<float> &rtPoints, vector<float> &mzPoints, v
     int mz_vals = mzPoint.size();
     mz.take(mz_vals, mzPoint);
 
-    assert(tm_vals = intMat.size());
-    MatF mat(tm_vals, mz_vals);
-    for(int i = 0; i < tm_vals; ++i){
-        assert(mz_vals == intMat[i].size());
-        for(int j = 0; j < mz_vals; ++j)
-            mat(i,j)=intMat[i][j];
-    }
-
-    MatF smat;
-    dyn.score(_mat, mat, smat, score);
-
-    if (!nostdnrm) {
-        if (!smat.all_equal()) { 
-            smat.std_normal();
-        }
-    }
-
-    int gp_length = smat.rows() + smat.cols();
-
-    VecF gp_array;
-    dyn.linear_less_before(gap_extend,gap_init,gp_length,gp_array);
-
+    assert(tm_vals * mz_vals == intMat.size());
+    MatF mat;
+    mat.take(tm_vals, mz_vals, std::move(intMat));
+
+    // fall back to the full matrices if the band could have cut off the
+    // path, resampled to as many rt points as alignment without a band uses
+    VecF coarseTm;
+    MatF coarseMat;
+    const VecF* refTm = &_tm;
+    const VecF* sampleTm = &tm;
+    DynProg dyn;
     int minimize = 0;
-    dyn.find_path(smat, gp_array, minimize, factor_diag, factor_gap, local, init_penalty);
+    if (!banded()) {
+        align_full(dyn, reference_mat(), mat, minimize);
+    } else if (!align_banded(dyn, tm, mat, minimize)) {
+        resample(tm, mat, coarseTm, coarseMat);
+        align_full(dyn, coarse_reference_mat(), coarseMat, minimize);
+        refTm = &_coarse_tm;
+        sampleTm = &coarseTm;
+    }
 
     VecI mOut;
     VecI nOut;
@@ -96,8 +100,8 @@ vector<float> ObiWarp::align(vector<float> &rtPoints, vector<float> &mzPoints, v
     VecF nOutF;
     VecF mOutF;
     vector<float> alignedRts;
-    if (!tm_axis_vals(mOut, mOutF, _tm,_tm_vals) ||
-        !tm_axis_vals(nOut, nOutF, tm,tm_vals))
+    if (!tm_axis_vals(mOut, mOutF, *refTm, refTm->length()) ||
+        !tm_axis_vals(nOut, nOutF, *sampleTm, sampleTm->length()))
         return alignedRts;
     warp_tm(nOutF, mOutF, tm);
 
@@ -111,7 +115,80 @@ vector<float> ObiWarp::align(vector<float> &rtPoints, vector<float> &mzPoints, v
 }
 
 
-bool ObiWarp::tm_axis_vals(VecI &tmCoords, VecF &tmVals,VecF &_tm ,int _tm_vals){
+bool ObiWarp::align_banded(DynProg &dyn, VecF &tm, MatF &mat, int minimize) const {
+    // cells of every reference row whose sample rt is within the allowed shift
+    int tm_vals = tm.length();
+    float* sampleTimes = tm.data();
+    vector<int> rowStart(_tm_vals);
+    vector<int> rowEnd(_tm_vals);
+    for(int m = 0; m < _tm_vals; ++m){
+        rowStart[m] = lower_bound(sampleTimes, sampleTimes + tm_vals, _tm[m] - max_rt_shift) - sampleTimes;
+        rowEnd[m] = upper_bound(sampleTimes, sampleTimes + tm_vals, _tm[m] + max_rt_shift) - sampleTimes;
+    }
+    DynProgBand band;
+    band.set(rowStart, rowEnd, tm_vals);
+
+    VecF smat;
+    if (!dyn.score_banded(reference_mat(), mat, band, smat, score.c_str()))
+        return false;
+
+    // standard normal over all cells of the matrix, as align_full does;
+    // the in-band cells alone would have other moments and give other paths
+    if (!nostdnrm) {
+        DynProgGram gram;
+        if (_gram.sum.empty() || !dyn.score_gram(mat, gram, score.c_str()))
+            return false;
+        double mean, stdev;
+        dyn.score_moments(_gram, gram, mean, stdev);
+        if (stdev > 0) {
+            smat -= static_cast<float>(mean);
+            smat /= static_cast<float>(stdev);
+        }
+    }
+
+    VecF gp_array;
+    dyn.linear_less_before(gap_extend,gap_init,_tm_vals + tm_vals,gp_array);
+
+    return dyn.find_path_banded(band, smat, gp_array, minimize, factor_diag, factor_gap, local, init_penalty);
+}
+
+void ObiWarp::align_full(DynProg &dyn, MatF &reference, MatF &mat, int minimize) const {
+    MatF smat;
+    dyn.score(reference, mat, smat, score.c_str());
+
+    if (!nostdnrm) {
+        if (!smat.all_equal()) {
+            smat.std_normal();
+        }
+    }
+
+    int gp_length = smat.rows() + smat.cols();
+
+    VecF gp_array;
+    dyn.linear_less_before(gap_extend,gap_init,gp_length,gp_array);
+
+    dyn.find_path(smat, gp_array, minimize, factor_diag, factor_gap, local, init_penalty);
+}
+
+void ObiWarp::resample(VecF &tm, MatF &mat, VecF &coarseTm, MatF &coarseMat) const {
+    // every step-th rt point and the last one, for about 500 rt points
+    int rows = tm.length();
+    int cols = mat.cols();
+    int step = max(1, rows / 500 - 1);
+    vector<float> times;
+    vector<float> intensities;
+    for (int m = 0; m < rows; ++m) {
+        if (m % step != 0 && m != rows - 1)
+            continue;
+        times.push_back(tm[m]);
+        intensities.insert(intensities.end(), mat.rowData(m), mat.rowData(m) + cols);
+    }
+    int coarseRows = times.size();
+    coarseTm.take(coarseRows, std::move(times));
+    coarseMat.take(coarseRows, cols, std::move(intensities));
+}
+
+bool ObiWarp::tm_axis_vals(VecI &tmCoords, VecF &tmVals, const VecF &_tm, int _tm_vals) const {
     VecF tmp(tmCoords.length());
     for (int i = 0; i < tmCoords.length(); ++i) {
         if (tmCoords[i] < _tm_vals) {
@@ -126,7 +203,7 @@ bool ObiWarp::tm_axis_vals(VecI &tmCoords, VecF &tmVals,VecF &_tm ,int _tm_vals)
     return(true);
 }
 
-void ObiWarp::warp_tm(VecF &selfTimes, VecF &equivTimes, VecF &_tm){
+void ObiWarp::warp_tm(VecF &selfTimes, VecF &equivTimes, VecF &_tm) const {
     VecF out;
     VecF::chfe(selfTimes, equivTimes, _tm, out, 1);  // run with sort option
     _tm.take(out);
@@ -13,7 +13,7 @@ using namespace std;
 
 struct ObiParams{
     ObiParams(string score,bool local, float factor_diag, float factor_gap, float gap_init,float gap_extend,
-            float init_penalty, float response, bool nostdnrm, float binSize);
+            float init_penalty, float response, bool nostdnrm, float binSize, float maxRtShift = 0);
 
     string score;
     bool local;
@@ -25,27 +25,47 @@ struct ObiParams{
     float response;
     bool nostdnrm;
     float binSize;
+    // largest expected rt shift between a sample and the reference; if
+    // positive, alignment is restricted to a band of this half-width around
+    // the reference rt instead of computing the full score matrix
+    float maxRtShift;
 };
 
+// Aligns samples to a reference. Once the reference data is set, an ObiWarp
+// is not modified by align(): every call works in its own DynProg, so a
+// single instance may be shared by threads aligning different samples.
 class ObiWarp{
 public:
     ObiWarp(ObiParams *obiParams);
     ~ObiWarp();
-    void setReferenceData(vector<float> &rtPoints, vector<float> &mzPoints, vector<vector<float> >& intMat);
-    vector<float> align(vector<float> &rtPoints, vector<float> &mzPoints, vector<vector<float> >& intMat);
+    // intMat holds the intensities of all rt points (rows) by all mz points
+    // (columns) in row-major order; its buffer is taken over without copying
+    void setReferenceData(vector<float> &rtPoints, vector<float> &mzPoints, vector<float> intMat);
+    vector<float> align(vector<float> &rtPoints, vector<float> &mzPoints, vector<float> intMat) const;
+    bool banded() const { return max_rt_shift > 0; }
 private:
-    bool tm_axis_vals(VecI &tmCoords, VecF &tmVals,VecF &_tm ,int _tm_vals);
-    void warp_tm(VecF &selfTimes, VecF &equivTimes, VecF &_tm);
+    bool align_banded(DynProg &dyn, VecF &tm, MatF &mat, int minimize) const;
+    void align_full(DynProg &dyn, MatF &reference, MatF &mat, int minimize) const;
+    void resample(VecF &tm, MatF &mat, VecF &coarseTm, MatF &coarseMat) const;
+    bool tm_axis_vals(VecI &tmCoords, VecF &tmVals, const VecF &_tm, int _tm_vals) const;
+    void warp_tm(VecF &selfTimes, VecF &equivTimes, VecF &_tm) const;
+    // DynProg takes matrices by non-const reference, but only reads them
+    MatF& reference_mat() const { return const_cast<MatF&>(_mat); }
+    MatF& coarse_reference_mat() const { return const_cast<MatF&>(_coarse_mat); }
     VecF _tm;
     VecF _mz;
     MatF _mat;
+    DynProgGram _gram;
+    // the reference resampled for when banded alignment falls back
+    VecF _coarse_tm;
+    MatF _coarse_mat;
     int _tm_vals;
     int _mz_vals;
     std::vector<float> tmPoint;
     std::vector<float> mzPoint;
-    DynProg dyn;
 
-    char* score;
+    // copied, since an ObiWarp may outlive the parameters it was made from
+    string score;
     bool local;
     float factor_diag;
     float factor_gap;
@@ -54,6 +74,7 @@ private:
     float init_penalty;
     float response;
     bool nostdnrm;
+    float max_rt_shift;
 
 };
 
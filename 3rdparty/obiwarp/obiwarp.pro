@@ -15,6 +15,8 @@ QMAKE_CXXFLAGS += -DOMP_PARALLEL
 
 TARGET = obiwarp
 
+INCLUDEPATH += $$top_srcdir/3rdparty/Eigen/
+
 linux: QMAKE_CXXFLAGS += -Ofast -ffast-math
 win32: QMAKE_CXXFLAGS += -Ofast -ffast-math
 macx: QMAKE_CXXFLAGS += -O3
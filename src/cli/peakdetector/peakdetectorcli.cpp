@@ -16,6 +16,10 @@ PeakDetectorCLI::PeakDetectorCLI()
     quantitationType = PeakGroup::AreaTop;
     clsfModelFilename = "default.model";
     alignMode = AlignmentMode::None;
+    mavenParameters->alignmentCacheDir =
+        (QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation)
+         + QDir::separator() + "El-MAVEN" + QDir::separator() + "alignments")
+            .toStdString();
     _reduceGroupsFlag = true;
     _parseOptions = new ParseOptions();
     _dlManager = new DownloadManager;
@@ -52,6 +56,9 @@ void PeakDetectorCLI::processOptions(int argc, char* argv[])
             else if (atoi(optarg) == 2)
                 alignMode = AlignmentMode::PolyFit;
 
+            else if (atoi(optarg) == 3)
+                alignMode = AlignmentMode::Landmarks;
+
             else {
                 alignMode = AlignmentMode::None;
                 mavenParameters->alignSamplesFlag = false;
@@ -67,6 +74,15 @@ void PeakDetectorCLI::processOptions(int argc, char* argv[])
             } else {
                 _currentPollyApp = PollyApp::None;
             }
+            break;
+
+        case 'R':
+            mavenParameters->alignmentCacheDir = optarg;
+            break;
+
+        case 'W':
+            mavenParameters->obiWarpMaxRtShift = atof(optarg);
+            break;
 
         case 'b':
             mavenParameters->minGoodGroupCount = atoi(optarg);
@@ -486,11 +502,22 @@ void PeakDetectorCLI::_processGeneralArgsXML(xml_node& generalArgs)
                 alignMode = AlignmentMode::PolyFit;
                 break;
 
+            case 3:
+                alignMode = AlignmentMode::Landmarks;
+                break;
+
             default:
                 mavenParameters->alignSamplesFlag = false;
                 alignMode = AlignmentMode::None;
                 break;
             }
+        } else if (strcmp(node.name(), "alignmentCache") == 0) {
+            mavenParameters->alignmentCacheDir = node.attribute("value").value();
+
+        } else if (strcmp(node.name(), "obiWarpMaxRtShift") == 0) {
+            mavenParameters->obiWarpMaxRtShift =
+                atof(node.attribute("value").value());
+
         } else if (strcmp(node.name(), "saveEicJson") == 0) {
             saveJsonEIC = true;
             if (atoi(node.attribute("value").value()) == 0)
@@ -55,7 +55,8 @@ public:
     enum class AlignmentMode {
         None,
         ObiWarp,
-        PolyFit
+        PolyFit,
+        Landmarks
     };
 
     bool status;
@@ -146,7 +147,7 @@ public:
     inline const vector<char*> getOptions()
     {
         const vector<char*> options = {
-            "a?alignSamples: Enter 1 for Obi-Warp alignment, 2 for Polyfit.",
+            "a?alignSamples: Enter 1 for Obi-Warp alignment, 2 for Polyfit, 3 for landmark alignment.",
             "b?minGoodGroupCount: Enter minimum number of good peaks per group. <int>",
             "c?matchRtFlag: Enter non-zero integer to match retention time to the database values. <int>",
             "C?compoundPPMWindow: Enter ppm window for m/z. <float>",
@@ -166,6 +167,8 @@ public:
             "q?minQuality: Enter min peak quality threshold for a group. <float>",
             "Q?quantileQuality: Specify required percentage of peaks above quality threshold. <float>",
             "r?rtStepSize: Enter retention time window for untargeted peak detection. <float>",
+            "R?alignmentCache: Enter full path to the folder where alignments are cached, or an empty string to always align again. <string>",
+            "W?obiWarpMaxRtShift: Enter the largest expected rt shift from the reference in minutes, to only align within it with Obi-Warp. 0 aligns over the whole run. <float>",
             "v?ionizationMode: Enter 0, -1 or 1 ionization mode. <int>",
             "w?minPeakWidth: Enter min peak width threshold in a group. <int>",
             "x?xml: Enter full path to the config file. <string>",
@@ -253,6 +256,7 @@ struct Arguments
 
     void populateArgs() {
         generalArgs << "int" << "alignSamples" << "0";
+        generalArgs << "float" << "obiWarpMaxRtShift" << "0";
         generalArgs << "int" << "saveEicJson" << "0";
         generalArgs << "string" << "outputdir" << "0";
         generalArgs << "string" << "pollyExtra" << "";
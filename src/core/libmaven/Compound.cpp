@@ -97,7 +97,8 @@ Compound::Type Compound::type() const {
 
 FragmentationMatchScore Compound::scoreCompoundHit(Fragment* expFrag,
                                                    float productPpmTolr,
-                                                   bool searchProton)
+                                                   bool searchProton,
+                                                   string scoringAlgo)
 {
     FragmentationMatchScore s;
 
@@ -120,6 +121,6 @@ FragmentationMatchScore Compound::scoreCompoundHit(Fragment* expFrag,
     //theory fragmentation or library fragmentation = libFrag
     //experimental data = expFrag
     libFrag.sortByIntensity();
-    s = libFrag.scoreMatch(expFrag, productPpmTolr);
+    s = libFrag.scoreMatch(expFrag, productPpmTolr, scoringAlgo);
     return s;
 }
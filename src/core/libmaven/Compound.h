@@ -155,7 +155,8 @@ class Compound{
 
         FragmentationMatchScore scoreCompoundHit(Fragment* expFrag,
                                                  float productPpmTolr = 20,
-                                                 bool searchProton = false);
+                                                 bool searchProton = false,
+                                                 string scoringAlgo = "");
 
         float adjustedMass(int charge);  /**   total mass by formula minus loss of electrons' mass  */
         void addReaction(Reaction* r) { reactions.push_back(r); }   /**  add reaction of this compound   */
@@ -1,4 +1,5 @@
 #include "EIC.h"
+#include "datastructures/memoryArena.h"
 #include "Peak.h"
 #include "PeakGroup.h"
 #include "mzPatterns.h"
@@ -18,6 +19,8 @@ EIC::EIC()
     sample = NULL;
     spline = NULL;
     baseline = NULL;
+    _splineInArena = false;
+    _baselineInArena = false;
     mzmin = mzmax = rtmin = rtmax = 0;
     maxIntensity = totalIntensity = 0;
     maxAreaTopIntensity = 0;
@@ -39,15 +42,28 @@ EIC::EIC()
 
 EIC::~EIC()
 {
-    if (spline != NULL)
-        delete[] spline;
-    spline = NULL;
-    if (baseline != NULL)
-        delete[] baseline;
-    baseline = NULL;
+    _releaseBuffer(spline, _splineInArena);
+    _releaseBuffer(baseline, _baselineInArena);
     peaks.clear();
 }
 
+float* EIC::_allocateBuffer(unsigned int n, bool& inArena)
+{
+    MemoryArena* arena = MemoryArena::current();
+    inArena = arena != nullptr;
+    if (inArena)
+        return arena->allocateArray<float>(n);
+    return new float[n];
+}
+
+void EIC::_releaseBuffer(float*& buffer, bool& inArena)
+{
+    if (buffer != nullptr && !inArena)
+        delete[] buffer;
+    buffer = nullptr;
+    inArena = false;
+}
+
 EIC *EIC::eicMerge(const vector<EIC *> &eics)
 {
     // Merge to 776
@@ -138,8 +154,7 @@ bool EIC::_clearBaseline()
 {
     if (baseline != nullptr)
     { //delete previous baseline if exists
-        delete[] baseline;
-        baseline = nullptr;
+        _releaseBuffer(baseline, _baselineInArena);
         eic_noNoiseObs = 0;
     }
 
@@ -147,7 +162,7 @@ bool EIC::_clearBaseline()
     if (!n)
         return false;
 
-    baseline = new float[n];
+    baseline = _allocateBuffer(n, _baselineInArena);
     std::fill_n(baseline, n, 0.0f);
 
     return true;
@@ -356,14 +371,11 @@ void EIC::computeSpline(int smoothWindow)
     if (n == 0)
         return;
     if (this->spline != NULL)
-    {
-        delete[] spline;
-        spline = NULL;
-    }
+        _releaseBuffer(spline, _splineInArena);
 
     try
     {
-        this->spline = new float[n];
+        this->spline = _allocateBuffer(n, _splineInArena);
         for (int i = 0; i < n; i++)
             spline[i] = 0;
     }
@@ -394,11 +406,12 @@ void EIC::computeSpline(int smoothWindow)
     }
     else if (smootherType == AVG)
     {
-        float *y = new float[n];
+        bool yInArena = false;
+        float *y = _allocateBuffer(n, yInArena);
         for (int i = 0; i < n; i++)
             y[i] = intensity[i];
         smoothAverage(y, spline, smoothWindow, n);
-        delete[] y;
+        _releaseBuffer(y, yInArena);
     }
 }
 
@@ -794,9 +807,10 @@ void EIC::checkGaussianFit(Peak &peak)
     if (moves < 3)
         return;
 
-    //copy intensities into separate vector
-    //dim
-    vector<float> pints(moves * 2 + 1);
+    //copy intensities into a per-thread buffer, shared by all peaks fitted
+    //on this thread
+    static thread_local vector<float> pints;
+    pints.assign(moves * 2 + 1, 0.0f);
 
     int j = peak.pos + moves;
     if (j >= intensity.size())
@@ -1090,14 +1104,26 @@ void EIC::getRTMinMaxPerScan()
  * @param[in] scan This is the 
  */
 bool EIC::makeEICSlice(mzSample *sample, float mzmin, float mzmax, float rtmin, float rtmax, int mslevel, int eicType, string filterline)
+{
+    this->mzmin = mzmin;
+    this->mzmax = mzmax;
+    vector<EIC*> eics(1, this);
+    return makeEICSlices(sample, eics, rtmin, rtmax, mslevel, eicType, filterline);
+}
+
+bool EIC::makeEICSlices(mzSample *sample,
+                        vector<EIC*> &eics,
+                        float rtmin,
+                        float rtmax,
+                        int mslevel,
+                        int eicType,
+                        string filterline)
 {
     float eicMz = 0, eicIntensity = 0;
-    int lb, scanNum;
-    vector<float>::iterator mzItr;
+    int scanNum;
     deque<Scan *>::iterator scanItr;
-    deque<Scan *> scans;
+    deque<Scan *> &scans = sample->scans;
 
-    scans = sample->scans;
     //binary search rt domain iterator
     Scan tmpScan(sample, 0, 1, rtmin - 0.1, 0, -1);
     scanItr = lower_bound(scans.begin(), scans.end(), &tmpScan, Scan::compRt);
@@ -1115,10 +1141,13 @@ bool EIC::makeEICSlice(mzSample *sample, float mzmin, float mzmax, float rtmin,
         estimatedScans = float(rtmax - rtmin) / (sample->maxRt - sample->minRt) * scans.size() + 10;
     }
 
-    this->scannum.reserve(estimatedScans);
-    this->rt.reserve(estimatedScans);
-    this->intensity.reserve(estimatedScans);
-    this->mz.reserve(estimatedScans);
+    for (EIC *eic : eics)
+    {
+        eic->scannum.reserve(estimatedScans);
+        eic->rt.reserve(estimatedScans);
+        eic->intensity.reserve(estimatedScans);
+        eic->mz.reserve(estimatedScans);
+    }
 
     scanNum = scanItr - scans.begin() - 1;
 
@@ -1136,84 +1165,97 @@ bool EIC::makeEICSlice(mzSample *sample, float mzmin, float mzmax, float rtmin,
         if (scan->rt > rtmax)
             break;
 
-        eicMz = 0;
-        eicIntensity = 0;
+        for (EIC *eic : eics)
+        {
+            _scanIntensity(scan, eic->mzmin, eic->mzmax, eicType, eicMz, eicIntensity);
+
+            eic->scannum.push_back(scanNum);
+            eic->rt.push_back(scan->rt);
+            eic->intensity.push_back(eicIntensity);
+            eic->mz.push_back(eicMz);
+            eic->totalIntensity += eicIntensity;
+            if (eicIntensity > eic->maxIntensity)
+                eic->maxIntensity = eicIntensity;
+        }
+    }
+
+    return true;
+}
 
-        //binary search
-        mzItr = lower_bound(scan->mz.begin(), scan->mz.end(), mzmin);
-        lb = mzItr - scan->mz.begin();
+void EIC::_scanIntensity(Scan *scan,
+                         float mzmin,
+                         float mzmax,
+                         int eicType,
+                         float &eicMz,
+                         float &eicIntensity)
+{
+    eicMz = 0;
+    eicIntensity = 0;
 
-        switch ((EIC::EicType)eicType)
-        {
+    //binary search
+    vector<float>::iterator mzItr = lower_bound(scan->mz.begin(), scan->mz.end(), mzmin);
+    int lb = mzItr - scan->mz.begin();
 
-        //takes the maximum intensity for given m/z range in a scan
-            case EIC::MAX:
+    switch ((EIC::EicType)eicType)
+    {
+
+    //takes the maximum intensity for given m/z range in a scan
+        case EIC::MAX:
+    {
+        for (unsigned int scanIdx = lb; scanIdx < scan->nobs(); scanIdx++)
         {
-            for (unsigned int scanIdx = lb; scanIdx < scan->nobs(); scanIdx++)
-            {
-                if (scan->mz[scanIdx] < mzmin)
-                    continue;
-                if (scan->mz[scanIdx] > mzmax)
-                    break;
+            if (scan->mz[scanIdx] < mzmin)
+                continue;
+            if (scan->mz[scanIdx] > mzmax)
+                break;
 
-                if (scan->intensity[scanIdx] > eicIntensity)
-                {
-                    eicIntensity = scan->intensity[scanIdx];
-                    eicMz = scan->mz[scanIdx];
-                }
+            if (scan->intensity[scanIdx] > eicIntensity)
+            {
+                eicIntensity = scan->intensity[scanIdx];
+                eicMz = scan->mz[scanIdx];
             }
-            break;
         }
+        break;
+    }
 
-        //takes the sum of all intensities for given m/z range in a scan
-        //associated m/z is the weighted average(with intensities as weights)
-        case EIC::SUM:
+    //takes the sum of all intensities for given m/z range in a scan
+    //associated m/z is the weighted average(with intensities as weights)
+    case EIC::SUM:
+    {
+        float n = 0;
+        for (unsigned int scanIdx = lb; scanIdx < scan->nobs(); scanIdx++)
         {
-            float n = 0;
-            for (unsigned int scanIdx = lb; scanIdx < scan->nobs(); scanIdx++)
-            {
-                if (scan->mz[scanIdx] < mzmin)
-                    continue;
-                if (scan->mz[scanIdx] > mzmax)
-                    break;
+            if (scan->mz[scanIdx] < mzmin)
+                continue;
+            if (scan->mz[scanIdx] > mzmax)
+                break;
 
-                eicIntensity += scan->intensity[scanIdx];
-                eicMz += scan->mz[scanIdx] * scan->intensity[scanIdx];
-                n += scan->intensity[scanIdx];
-            }
-            eicMz /= n;
-            break;
+            eicIntensity += scan->intensity[scanIdx];
+            eicMz += scan->mz[scanIdx] * scan->intensity[scanIdx];
+            n += scan->intensity[scanIdx];
         }
+        eicMz /= n;
+        break;
+    }
 
-        default:
+    default:
+    {
+        for (unsigned int scanIdx = lb; scanIdx < scan->nobs(); scanIdx++)
         {
-            for (unsigned int scanIdx = lb; scanIdx < scan->nobs(); scanIdx++)
-            {
-                if (scan->mz[scanIdx] < mzmin)
-                    continue;
-                if (scan->mz[scanIdx] > mzmax)
-                    break;
+            if (scan->mz[scanIdx] < mzmin)
+                continue;
+            if (scan->mz[scanIdx] > mzmax)
+                break;
 
-                if (scan->intensity[scanIdx] > eicIntensity)
-                {
-                    eicIntensity = scan->intensity[scanIdx];
-                    eicMz = scan->mz[scanIdx];
-                }
+            if (scan->intensity[scanIdx] > eicIntensity)
+            {
+                eicIntensity = scan->intensity[scanIdx];
+                eicMz = scan->mz[scanIdx];
             }
-            break;
-        }
         }
-
-        this->scannum.push_back(scanNum);
-        this->rt.push_back(scan->rt);
-        this->intensity.push_back(eicIntensity);
-        this->mz.push_back(eicMz);
-        this->totalIntensity += eicIntensity;
-        if (eicIntensity > this->maxIntensity)
-            this->maxIntensity = eicIntensity;
+        break;
+    }
     }
-
-    return true;
 }
 
 void EIC::normalizeIntensityPerScan(float scale)
@@ -219,6 +219,23 @@ class EIC
     */
     bool makeEICSlice(mzSample *sample, float mzmin, float mzmax, float rtmin, float rtmax, int mslevel, int eicType, string filterline);
 
+    /**
+    * @brief fill several EICs of a sample in a single sweep over its scans
+    * @details every EIC must already have its mzmin and mzmax set. Scans
+    * within the given RT range are visited once and the intensity for each
+    * EIC's m/z window is extracted from every scan.
+    * @param sample sample whose scans will be read
+    * @param eics EICs to be filled
+    * @return bool true if EICs are pulled. false otherwise
+    */
+    static bool makeEICSlices(mzSample *sample,
+                              vector<EIC*> &eics,
+                              float rtmin,
+                              float rtmax,
+                              int mslevel,
+                              int eicType,
+                              string filterline);
+
     void getRTMinMaxPerScan();
 
     void normalizeIntensityPerScan(float scale);
@@ -325,6 +342,47 @@ class EIC
      */
     bool _clearBaseline();
 
+    /**
+     * @brief Whether the spline array was allocated from a MemoryArena and
+     * must therefore not be freed by this EIC.
+     */
+    bool _splineInArena;
+
+    /**
+     * @brief Whether the baseline array was allocated from a MemoryArena and
+     * must therefore not be freed by this EIC.
+     */
+    bool _baselineInArena;
+
+    /**
+     * @brief Allocate an intensity-sized float buffer. If a MemoryArena is
+     * current for the calling thread, the buffer is taken from it, otherwise
+     * it is allocated on the heap.
+     * @param n Number of floats to allocate.
+     * @param inArena Set to true if the buffer was allocated from an arena.
+     * @return Pointer to the new (uninitialized) buffer.
+     */
+    static float* _allocateBuffer(unsigned int n, bool& inArena);
+
+    /**
+     * @brief Find the intensity and m/z of a scan for a given m/z range,
+     * according to the EIC type.
+     */
+    static void _scanIntensity(Scan *scan,
+                               float mzmin,
+                               float mzmax,
+                               int eicType,
+                               float &eicMz,
+                               float &eicIntensity);
+
+    /**
+     * @brief Release a buffer obtained from `_allocateBuffer` and set it to
+     * nullptr. Arena-backed buffers are simply dropped.
+     * @param buffer Reference to the buffer pointer.
+     * @param inArena Whether the buffer came from an arena; reset to false.
+     */
+    static void _releaseBuffer(float*& buffer, bool& inArena);
+
     /**
      * @brief Computes a baseline using naive thresholding method.
      * @param smoothingWindow is the size of window used for 1D guassian smoothing.
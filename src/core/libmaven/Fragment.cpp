@@ -140,12 +140,25 @@ vector<int> Fragment::compareRanks(Fragment* a, Fragment* b, float productPpmTol
 { 
     bool verbose = false;
     vector<int> ranks (a->mzValues.size(), -1);	//missing value == -1
+
+    //b's peaks sorted by m/z, so that only those near each of a's peaks are
+    //looked at; the first of b's peaks (in b's order) within tolerance wins
+    vector<pair<float, int>> sortedB(b->mzValues.size());
+    for (unsigned int j = 0; j < b->mzValues.size(); j++)
+        sortedB[j] = make_pair(b->mzValues[j], j);
+    sort(sortedB.begin(), sortedB.end());
+
     for(unsigned int i = 0; i < a->mzValues.size(); i++) {
-        for( unsigned int j = 0; j < b->mzValues.size(); j++) {
-            if (mzUtils::ppmDist(a->mzValues[i], b->mzValues[j]) < productPpmTolr) {
-                ranks[i] = j;
-                break;
-            }
+        float mz = a->mzValues[i];
+        float window = mz / 1e6 * productPpmTolr * 1.01 + 0.0001;
+        auto itr = lower_bound(sortedB.begin(),
+                               sortedB.end(),
+                               make_pair(mz - window, -1));
+        for (; itr != sortedB.end() && itr->first <= mz + window; itr++) {
+            if (mzUtils::ppmDist(mz, itr->first) >= productPpmTolr)
+                continue;
+            if (ranks[i] == -1 || itr->second < ranks[i])
+                ranks[i] = itr->second;
         }
     }
     if (verbose) {
@@ -186,25 +199,79 @@ void Fragment::buildConsensus(float productPpmTolr)
     this->consensus = consensusFrag;
     consensusFrag->sortByMz();
 
-    for (auto brother : brothers) {
-        vector<int> ranks = compareRanks(brother, consensusFrag, productPpmTolr); 
+    //every other fragment's peaks are summed into the lowest consensus m/z
+    //within ppm tolerance, as compareRanks() matches them, and unmatched
+    //peaks are merged in once the whole fragment has been matched. Consensus
+    //m/z values never move, so the consensus stays sorted without re-sorting
+    //it for every brother.
+    vector<Fragment*> fragments = brothers;
+    fragments.push_back(this);
+    for (Fragment* fragment : fragments) {
+        if (fragment == seed)
+            continue;
 
-        for (unsigned int j = 0; j < ranks.size(); j++) {
-            int posA = ranks[j];	
-            float mzB = brother->mzValues[j];
-            float intB = brother->intensityValues[j];
-            if (posA >= 0) {
+        vector<float>& consensusMzs = consensusFrag->mzValues;
+        vector<pair<float, float>> newPeaks;
+        for (unsigned int j = 0; j < fragment->mzValues.size(); j++) {
+            float mz = fragment->mzValues[j];
+            float intensity = fragment->intensityValues[j];
+            float window = mz / 1e6 * productPpmTolr * 1.01 + 0.0001;
+            auto itr = lower_bound(consensusMzs.begin(),
+                                   consensusMzs.end(),
+                                   mz - window);
+            int pos = -1;
+            for (; itr != consensusMzs.end() && *itr <= mz + window; itr++) {
+                if (mzUtils::ppmDist(mz, *itr) < productPpmTolr) {
+                    pos = itr - consensusMzs.begin();
+                    break;
+                }
+            }
+
+            if (pos >= 0) {
                 //sum intensities for m/z within ppm tolerance
-                consensusFrag->intensityValues[posA] += intB;
-                consensusFrag->obscount[posA] += 1;
-            } else if (posA == -1) {
+                consensusFrag->intensityValues[pos] += intensity;
+                consensusFrag->obscount[pos] += 1;
+            } else {
                 //new entry if m/z does not fall within ppm tolerance of existing m/z
-                consensusFrag->mzValues.push_back(mzB);
-                consensusFrag->intensityValues.push_back(intB);
-                consensusFrag->obscount.push_back(1);
+                newPeaks.push_back(make_pair(mz, intensity));
+            }
+        }
+        if (newPeaks.empty())
+            continue;
+
+        //merge new peaks into the consensus, after existing peaks of equal
+        //m/z and in the fragment's order among themselves
+        stable_sort(newPeaks.begin(),
+                    newPeaks.end(),
+                    [](const pair<float, float>& a, const pair<float, float>& b) {
+                        return a.first < b.first;
+                    });
+        size_t size = consensusMzs.size() + newPeaks.size();
+        vector<float> mergedMzs;
+        vector<float> mergedIntensities;
+        vector<int> mergedObscount;
+        mergedMzs.reserve(size);
+        mergedIntensities.reserve(size);
+        mergedObscount.reserve(size);
+        size_t i = 0;
+        size_t k = 0;
+        while (i < consensusMzs.size() || k < newPeaks.size()) {
+            if (k == newPeaks.size()
+                || (i < consensusMzs.size() && consensusMzs[i] <= newPeaks[k].first)) {
+                mergedMzs.push_back(consensusMzs[i]);
+                mergedIntensities.push_back(consensusFrag->intensityValues[i]);
+                mergedObscount.push_back(consensusFrag->obscount[i]);
+                i++;
+            } else {
+                mergedMzs.push_back(newPeaks[k].first);
+                mergedIntensities.push_back(newPeaks[k].second);
+                mergedObscount.push_back(1);
+                k++;
             }
         }
-        consensusFrag->sortByMz();
+        consensusFrag->mzValues = mergedMzs;
+        consensusFrag->intensityValues = mergedIntensities;
+        consensusFrag->obscount = mergedObscount;
     }
 
     if (!consensusFrag->intensityValues.size() || 
@@ -216,7 +283,7 @@ void Fragment::buildConsensus(float productPpmTolr)
     consensusFrag->purity = consensusPurity();
 
     //average values 
-    int N = 1 + brothers.size();
+    int N = fragments.size();
     for (unsigned int i = 0; i < consensusFrag->intensityValues.size(); i++) {
         consensusFrag->intensityValues[i] /= N;
     }
@@ -454,10 +521,76 @@ double Fragment::dotProduct(Fragment* other)
 
     if(thisTIC == 0 or otherTIC == 0) return 0;
     //TODO: find out why min and max mzValues are not used
-    vector<float> va = asDenseVector(100, 2000, 2000);
-    vector<float> vb = other->asDenseVector(100, 2000, 2000);
-    
-    return mzUtils::correlation(va, vb);
+    //only the occupied bins of the dense vectors are visited, the rest are
+    //zero and do not change the correlation sums
+    vector<pair<int, float>> va = binnedIntensities(100, 2000, 2000);
+    vector<pair<int, float>> vb = other->binnedIntensities(100, 2000, 2000);
+
+    int n = 2000;
+    double sumx = 0;
+    double sumy = 0;
+    double sumxy = 0;
+    double x2 = 0;
+    double y2 = 0;
+    for (auto& x : va) {
+        sumx += x.second;
+        x2 += x.second * x.second;
+    }
+    for (auto& y : vb) {
+        sumy += y.second;
+        y2 += y.second * y.second;
+    }
+    auto itrA = va.begin();
+    auto itrB = vb.begin();
+    while (itrA != va.end() && itrB != vb.end()) {
+        if (itrA->first < itrB->first) {
+            itrA++;
+        } else if (itrB->first < itrA->first) {
+            itrB++;
+        } else {
+            sumxy += itrA->second * itrB->second;
+            itrA++;
+            itrB++;
+        }
+    }
+
+    double var1 = x2 - (sumx * sumx) / n;
+    double var2 = y2 - (sumy * sumy) / n;
+    if (var1 == 0 || var2 == 0) return 0;
+    return (float)((sumxy - (sumx * sumy) / n) / sqrt(var1 * var2));
+}
+
+vector<pair<int, float>> Fragment::binnedIntensities(float mzmin,
+                                                     float mzmax,
+                                                     int nbins)
+{
+    //same binning as asDenseVector, in m/z order of the bins
+    vector<pair<int, float>> bins;
+    double mzrange = mzmax - mzmin;
+    for (unsigned int i = 0; i < mzValues.size(); i++) {
+        if (mzValues[i] < mzmin || mzValues[i] > mzmax)
+            continue;
+
+        int bin = int(((mzValues[i] - mzmin) / mzrange ) * nbins);
+        if (bin > 0 && bin < nbins)
+            bins.push_back(make_pair(bin, intensityValues[i]));
+    }
+    stable_sort(bins.begin(),
+                bins.end(),
+                [](const pair<int, float>& a, const pair<int, float>& b) {
+                    return a.first < b.first;
+                });
+
+    //sum up intensities falling into the same bin
+    vector<pair<int, float>> merged;
+    for (auto& bin : bins) {
+        if (!merged.empty() && merged.back().first == bin.first) {
+            merged.back().second += bin.second;
+        } else {
+            merged.push_back(bin);
+        }
+    }
+    return merged;
 }
 
 double Fragment::hyperGeometricScore(int k, int m, int n, int N)
@@ -535,7 +668,9 @@ double Fragment::mzWeightedDotProduct(const vector<int>& X, Fragment* other)
     return (sqrt(dotP / (thisTIC * otherTIC))); //SIM
 }
 
-FragmentationMatchScore Fragment::scoreMatch(Fragment* other, float productPpmTolr)
+FragmentationMatchScore Fragment::scoreMatch(Fragment* other,
+                                             float productPpmTolr,
+                                             string scoringAlgo)
 {
     FragmentationMatchScore s;
     if (mzValues.size() < 2 or other->mzValues.size() < 2) return s;
@@ -544,26 +679,91 @@ FragmentationMatchScore Fragment::scoreMatch(Fragment* other, float productPpmTo
     Fragment* a = this;
     Fragment* b =  other;
 
+    bool all = scoringAlgo.empty();
+    bool needsTic = all
+                    || scoringAlgo == "HyperGeomScore"
+                    || scoringAlgo == "TICMatched";
+
     s.ppmError = abs((a->precursorMz - b->precursorMz) / a->precursorMz * 1e6);
     vector<int> ranks = compareRanks(a, b, productPpmTolr);
-    for(int rank: ranks) {
-        if(rank != -1) s.numMatches++;
-    }
 
-    //annotate?
-    for(int i = 0; i < ranks.size(); i++)
-        other->annotations[ranks[i]] = annotations[i];
+    //every rank based score is accumulated in a single pass over the ranks
+    int n = b->nobs();
+    int N = ranks.size();
+    double d2 = 0;
+    double TIC = 0;
+    double matchedTIC = 0;
+    double mzErr2 = 0;
+    double weightedDotP = 0;
+    int Ak = 0;
+    int Bk = 0;
+    int Ck = 0;
+    for (int i = 0; i < N; i++) {
+        int j = ranks[i];
+
+        //annotate?
+        b->annotations[j] = annotations[i];
+
+        TIC += intensityValues[i];
+        if (j == -1) {
+            d2 += 2 * i;	//mising values set to average distance
+            continue;
+        }
+        s.numMatches++;
+        matchedTIC += intensityValues[i];
+        d2 += (i - j) * (i - j);
+        mzErr2 += POW2(mzValues[i] - b->mzValues[j]);
+        weightedDotP += mzValues[i] *
+                        intensityValues[i] *
+                        b->mzValues[j] *
+                        b->intensityValues[j];
+        if (j < 0.2 * n) Ak++;
+        else if (j < 0.5 * n) Bk++;
+        else if (j < 0.8 * n) Ck++;
+    }
 
     s.fractionMatched = s.numMatches / a->nobs();
-    s.spearmanRankCorrelation = spearmanRankCorrelation(ranks);
-    s.ticMatched = ticMatched(ranks);
-    s.mzFragError =  mzErr(ranks,b);
-    s.dotProduct = dotProduct(b);
-    s.hypergeomScore  = hyperGeometricScore(s.numMatches, a->nobs(), b->nobs(), 100000) +
-                        s.ticMatched; // ticMatch is tie breaker
-    s.mvhScore = MVH(ranks, b);
-    s.weightedDotProduct = mzWeightedDotProduct(ranks, b);
+    if (N > 0) {
+        s.spearmanRankCorrelation = 1.00 - (6.0 * d2) / (N * ((N * N) - 1));
+        if (needsTic && TIC > 0) s.ticMatched = matchedTIC / TIC;
+        if (s.numMatches > 0) s.mzFragError = sqrt(mzErr2);
+    }
+
+    if (all || scoringAlgo == "DotProduct")
+        s.dotProduct = dotProduct(b);
+
+    if (needsTic) {
+        s.hypergeomScore = hyperGeometricScore(s.numMatches, a->nobs(), b->nobs(), 100000) +
+                           s.ticMatched; // ticMatch is tie breaker
+    }
+
+    if (N > 0 && (all || scoringAlgo == "MVH")) {
+        int Am = 0.2 * n;
+        int Bm = 0.5 * n;
+        int Cm = 0.8 * n;
+        if (Ak > Am) Ak = Am;
+        if (Bk > Bm) Bk = Bm;
+        if (Ck > Cm) Ck = Cm;
+
+        double A = logNchooseK(Am, Ak) + 0.1 * logNchooseK(Bm, Bk) + 0.001 * logNchooseK(Cm, Ck);
+        double B = logNchooseK((100000 - Am - Bm - Cm), (n - Ak - Bk - Ck));
+        double C = logNchooseK(100000, n);
+        s.mvhScore = -(A + B - C);
+    }
+
+    if (N > 0 && (all || scoringAlgo == "WeightedDotProduct")) {
+        double thisTIC = 0;
+        double otherTIC = 0;
+        for(unsigned int i = 0; i < nobs(); i++)
+            thisTIC +=  mzValues[i] * intensityValues[i];
+        for(unsigned int j = 0; j < b->nobs(); j++)
+            otherTIC += b->mzValues[j] * b->intensityValues[j];
+
+        if (thisTIC != 0 and otherTIC != 0)
+            s.weightedDotProduct = sqrt(weightedDotP / (thisTIC * otherTIC)); //SIM
+    }
 
+    if (!all) s.mergedScore = s.getScoreByName(scoringAlgo);
     return s;
 }
 
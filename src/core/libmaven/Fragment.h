@@ -128,8 +128,9 @@ class Fragment {
 
         /**
          * @brief create a consensus spectra for all brother fragments
-         * @details go through all brother fragments and create a spectra where 
-         * a new m/z is added if it does not fall within the PPM tolerance range of existing m/zs.
+         * @details the consensus starts from the brother with the most peaks. Peaks of
+         * every other brother are matched to the lowest consensus m/z within PPM
+         * tolerance, and a new m/z is added if none is within tolerance.
          * intensity for every m/z is calculated as the sum of intensities in that m/z bracket
          * averaged over the number of brother fragments and further normalized against the highest intensity.
          */
@@ -153,6 +154,12 @@ class Fragment {
 
         vector<float> asDenseVector(float mzmin, float mzmax, int nbins = 2000);
 
+        /**
+         * @brief sparse form of asDenseVector
+         * @return (bin, summed intensity) pairs of the occupied bins, in bin order
+         */
+        vector<std::pair<int, float>> binnedIntensities(float mzmin, float mzmax, int nbins = 2000);
+
         double logNchooseK(int N, int k);
 
         double spearmanRankCorrelation(const vector<int>& X);
@@ -172,7 +179,16 @@ class Fragment {
 
         double mzWeightedDotProduct(const vector<int>& X, Fragment* other);
 
-        FragmentationMatchScore scoreMatch(Fragment* other, float productPpmTolr);
+        /**
+         * @brief score the match of this (library) fragment against another (experimental) one
+         * @details peaks are aligned once and all scores are derived from the same alignment.
+         * @param scoringAlgo if empty, every score is computed. Otherwise only the named score
+         * (see FragmentationMatchScore::getScoringAlgorithmNames) and the match counts are
+         * computed, and the named score is also set as mergedScore.
+         */
+        FragmentationMatchScore scoreMatch(Fragment* other,
+                                           float productPpmTolr,
+                                           string scoringAlgo = "");
 
         inline unsigned int nobs() { return mzValues.size(); }
 
@@ -1,4 +1,5 @@
 #include "classifierNeuralNet.h"
+#include "datastructures/memoryArena.h"
 #include "datastructures/mzSlice.h"
 #include "obiwarp.h"
 #include "PeakDetector.h"
@@ -15,6 +16,7 @@
 #include "mavenparameters.h"
 #include "mzMassCalculator.h"
 #include "isotopeDetection.h"
+#include "landmarkAligner.h"
 
 PeakDetector::PeakDetector() {
     mavenParameters = NULL;
@@ -24,13 +26,29 @@ PeakDetector::PeakDetector(MavenParameters* mp) {
 	mavenParameters = mp;
 }
 
+PeakDetector::~PeakDetector() {
+    delete_all(_sliceArenas);
+}
+
+void PeakDetector::_prepareSliceArenas() {
+    int numThreads = omp_get_max_threads();
+    while (_sliceArenas.size() < static_cast<size_t>(numThreads))
+        _sliceArenas.push_back(new MemoryArena());
+}
+
+void PeakDetector::_resetSliceArenas() {
+    for (auto arena : _sliceArenas)
+        arena->reset();
+}
+
 void PeakDetector::resetProgressBar() {
 	zeroStatus = true;
 }
 
 vector<EIC*> PeakDetector::pullEICs(mzSlice* slice,
                                     std::vector<mzSample*>& samples,
-                                    MavenParameters* mp)
+                                    MavenParameters* mp,
+                                    vector<MemoryArena*>* arenas)
 {
     vector<EIC*> eics;
     vector<mzSample*> vsamples;
@@ -46,6 +64,13 @@ vector<EIC*> PeakDetector::pullEICs(mzSlice* slice,
             vsamples.push_back(samples[i]);
         }
 
+        // buffers of EICs pulled by this thread go to its own arena, if any
+        MemoryArena* arena = nullptr;
+        size_t threadNum = static_cast<size_t>(omp_get_thread_num());
+        if (arenas != nullptr && threadNum < arenas->size())
+            arena = (*arenas)[threadNum];
+        MemoryArena::Scope arenaScope(arena);
+
         // single threaded version - getting EICs of selected samples.
         // #pragma omp parallel for ordered
 #pragma omp for
@@ -117,42 +142,66 @@ void PeakDetector::processSlice(mzSlice& slice) {
 }
 
 void PeakDetector::pullAllIsotopes() {
-    for (unsigned int j = 0; j < mavenParameters->allgroups.size(); j++) {
-        if(mavenParameters->stop) break;
-        PeakGroup& group = mavenParameters->allgroups[j];
-        Compound* compound = group.compound;
+    int numGroups = mavenParameters->allgroups.size();
+
+    // Groups are independent of each other, so their isotopes are pulled in
+    // parallel. Each group only ever modifies its own children, which are
+    // added in the order of isotope names, so the result does not depend on
+    // how groups are scheduled.
+    if (mavenParameters->pullIsotopesFlag) {
+        bool C13Flag = mavenParameters->C13Labeled_BPE;
+        bool N15Flag = mavenParameters->N15Labeled_BPE;
+        bool S34Flag = mavenParameters->S34Labeled_BPE;
+        bool D2Flag = mavenParameters->D2Labeled_BPE;
+
+        bool stopped = false;
+        int groupsProcessed = 0;
+        #pragma omp parallel for schedule(dynamic) shared(stopped, groupsProcessed)
+        for (int j = 0; j < numGroups; j++) {
+            if (mavenParameters->stop || stopped) {
+                stopped = true;
+                #pragma omp cancel for
+            }
+            #pragma omp cancellation point for
+
+            PeakGroup& group = mavenParameters->allgroups[j];
+            if (!group.isIsotope()) {
+                IsotopeDetection::IsotopeDetectionType isoType;
+                isoType = IsotopeDetection::PeakDetection;
+
+                IsotopeDetection isotopeDetection(
+                    mavenParameters,
+                    isoType,
+                    C13Flag,
+                    N15Flag,
+                    S34Flag,
+                    D2Flag);
+                isotopeDetection.pullIsotopes(&group);
+            }
 
-        if (mavenParameters->pullIsotopesFlag && !group.isIsotope())
-        {
-            bool C13Flag = mavenParameters->C13Labeled_BPE;
-            bool N15Flag = mavenParameters->N15Labeled_BPE;
-            bool S34Flag = mavenParameters->S34Labeled_BPE;
-            bool D2Flag = mavenParameters->D2Labeled_BPE;
-
-            IsotopeDetection::IsotopeDetectionType isoType;
-            isoType = IsotopeDetection::PeakDetection;
-
-            IsotopeDetection isotopeDetection(
-                mavenParameters,
-                isoType,
-                C13Flag,
-                N15Flag,
-                S34Flag,
-                D2Flag);
-            isotopeDetection.pullIsotopes(&group);
+            int processed;
+            #pragma omp atomic capture
+            processed = ++groupsProcessed;
+
+            if (mavenParameters->showProgressFlag && processed % 10 == 0) {
+                #pragma omp critical(isotopeProgress)
+                sendBoostSignal("Calculating Isotopes", processed, numGroups);
+            }
         }
+    }
+
+    // compounds are linked to their best groups serially and in group
+    // order, so that ties are always resolved the same way
+    for (int j = 0; j < numGroups; j++) {
+        if (mavenParameters->stop) break;
+        PeakGroup& group = mavenParameters->allgroups[j];
+        Compound* compound = group.compound;
 
         if (compound) {
             if (!compound->hasGroup() ||
                 group.groupRank < compound->getPeakGroup()->groupRank)
                 compound->setPeakGroup(group);
         }
-
-
-        if (mavenParameters->showProgressFlag &&
-            mavenParameters->pullIsotopesFlag && j % 10 == 0) {
-			sendBoostSignal("Calculating Isotopes", j, mavenParameters->allgroups.size());
-        }
     }
 }
 
@@ -270,7 +319,8 @@ void PeakDetector::alignSamples(const int& method) {
             cerr << "Starting OBI-WARP alignment" << std::endl;
             /*TODO: move the hard coded values in  default_settings.xml and instead of using obi params
             make use mavenParameters to access all the values */
-            ObiParams params("cor", false, 2.0, 1.0, 0.20, 3.40, 0.0, 20.0, false, 0.60);
+            ObiParams params("cor", false, 2.0, 1.0, 0.20, 3.40, 0.0, 20.0, false, 0.60,
+                             mavenParameters->obiWarpMaxRtShift);
             Aligner mzAligner;
             mzAligner.alignWithObiWarp(mavenParameters->samples, &params, mavenParameters);
         }
@@ -294,6 +344,17 @@ void PeakDetector::alignSamples(const int& method) {
 
         break;
 
+        case 3: {
+            cerr << "Starting landmark alignment" << std::endl;
+            LandmarkAligner landmarkAligner;
+            Aligner mzAligner;
+            mzAligner.alignWithLandmarks(mavenParameters->samples,
+                                         landmarkAligner,
+                                         mavenParameters);
+        }
+
+        break;
+
         default: break;
 
 
@@ -310,6 +371,10 @@ void PeakDetector::processSlices(vector<mzSlice *> &slices, string setName)
 
     sort(slices.begin(), slices.end(), mzSlice::compIntensity);
 
+    // temporary EIC buffers are allocated from per-thread arenas, which are
+    // reset after each slice once its EICs have been deleted
+    _prepareSliceArenas();
+
     int eicCount = 0;
     for (unsigned int s = 0; s < slices.size(); s++)
     {
@@ -323,9 +388,11 @@ void PeakDetector::processSlices(vector<mzSlice *> &slices, string setName)
         if (compound != NULL && compound->hasGroup())
             compound->unlinkGroup();
 
+        MemoryArena::Scope arenaScope(_sliceArenas[omp_get_thread_num()]);
         vector<EIC *> eics = pullEICs(slice,
                                       mavenParameters->samples,
-                                      mavenParameters);
+                                      mavenParameters,
+                                      &_sliceArenas);
 
         if (mavenParameters->clsf->hasModel())
         {
@@ -366,6 +433,7 @@ void PeakDetector::processSlices(vector<mzSlice *> &slices, string setName)
         if (eicMaxIntensity < mavenParameters->minGroupIntensity)
         {
             delete_all(eics);
+            _resetSliceArenas();
             continue;
         }
 
@@ -406,6 +474,7 @@ void PeakDetector::processSlices(vector<mzSlice *> &slices, string setName)
 
         //cleanup
         delete_all(eics);
+        _resetSliceArenas();
 
         if (mavenParameters->allgroups.size() > mavenParameters->limitGroupCount)
         {
@@ -426,4 +495,10 @@ void PeakDetector::processSlices(vector<mzSlice *> &slices, string setName)
             sendBoostSignal(progressText, s + 1, std::min((int)slices.size(), mavenParameters->limitGroupCount));
         }
     }
+
+    // peak memory taken by temporary EIC buffers of every thread
+    cerr << "Slice arena high-water marks (bytes):";
+    for (auto arena : _sliceArenas)
+        cerr << " " << arena->highWaterMark();
+    cerr << endl;
 }
@@ -12,6 +12,7 @@
 class Compound;
 class EIC;
 class MavenParameters;
+class MemoryArena;
 class mzSample;
 class mzSlice;
 class PeakGroup;
@@ -28,6 +29,7 @@ public:
 
 	PeakDetector();
 	PeakDetector(MavenParameters* mp);
+	~PeakDetector();
 
 
 	//copy constructor	
@@ -122,9 +124,22 @@ public:
 	 */
         std::vector<mzSlice*> processCompounds(std::vector<Compound*> set, std::string setName);
 
+    /**
+     * @brief Pull, smooth and find peaks in EICs of all selected samples for
+     * a slice.
+     * @param slice The slice for which EICs will be pulled.
+     * @param samples Samples from which EICs will be pulled.
+     * @param mp Parameters to be used for smoothing and baseline.
+     * @param arenas Optional per-thread arenas (indexed by OpenMP thread
+     * number) from which the spline and baseline buffers of the EICs will be
+     * allocated. EICs pulled this way must be deleted before the arenas are
+     * reset.
+     * @return Vector of newly allocated EICs.
+     */
     static std::vector<EIC*> pullEICs(mzSlice* slice,
                                  std::vector<mzSample*>& samples,
-                                 MavenParameters* mp);
+                                 MavenParameters* mp,
+                                 std::vector<MemoryArena*>* arenas = nullptr);
 
         private:
 
@@ -136,6 +151,22 @@ public:
 	 */
 	MavenParameters* mavenParameters;
 	bool zeroStatus;
+
+    /**
+     * @brief Per-thread arenas backing temporary EIC buffers while slices
+     * are being processed. These are reset after every slice.
+     */
+    std::vector<MemoryArena*> _sliceArenas;
+
+    /**
+     * @brief Make sure there is one slice arena for every worker thread.
+     */
+    void _prepareSliceArenas();
+
+    /**
+     * @brief Release everything allocated from the slice arenas.
+     */
+    void _resetSliceArenas();
 };
 
 #endif // PEAKDETECTOR_H
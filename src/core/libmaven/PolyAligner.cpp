@@ -1,6 +1,23 @@
+#include <Eigen>
+
 #include "PolyAligner.h"
 #include "mzUtils.h"
 
+vector<double> AlignmentStats::predict(const vector<double>& x) {
+	if (poly_transform_result.empty()) {
+		cerr << "Empty transform.. ";
+		return vector<double>();
+	}
+
+	vector<double> y(x.size());
+	Eigen::Map<const Eigen::ArrayXd> xs(x.data(), x.size());
+	Eigen::Map<Eigen::ArrayXd> ys(y.data(), y.size());
+	ys.setConstant(poly_transform_result[poly_align_degree]);
+	for (int k = poly_align_degree - 1; k >= 0; k--)
+		ys = ys * xs + poly_transform_result[k];
+	return y;
+}
+
 PolyAligner::PolyAligner(StatisticsVector<float>& subj, StatisticsVector<float>& ref) {
 
 	if( subj.size() != ref.size()) { 
@@ -19,6 +36,10 @@ PolyAligner::PolyAligner(StatisticsVector<float>& subj, StatisticsVector<float>&
 	calculateOutliers(3);
 } 
 
+PolyAligner::~PolyAligner() {
+	delete mtRand;
+}
+
 double PolyAligner::calculateR2(AlignmentStats* model) { 
 	double R2=0;
 	int N = subjVector.size();
@@ -113,15 +134,29 @@ AlignmentStats* PolyAligner::align(int degree) {
 	if(stats->poly_align_degree > stats->N/3 ) { stats->poly_align_degree = stats->N/3; }
 
 	double* result = new double[(stats->poly_align_degree+1)];
-	double* w = new double[(stats->poly_align_degree+1)*(stats->poly_align_degree+1)];
 
-	
 	if(stats->N > 0) {
 		stats->R_before=0; 
 		stats->R_after=0;
 
-		sort_xy(x, ref, stats->N, 1, 0);
-        leasqu(stats->N, x, ref, stats->poly_align_degree, w, (stats->poly_align_degree+1), result);	//polynomial fit
+		//polynomial fit by least squares, with columns of the Vandermonde
+		//matrix scaled to unit norm to keep the problem well conditioned
+		int deg = stats->poly_align_degree;
+		Eigen::MatrixXd vandermonde(stats->N, deg+1);
+		Eigen::VectorXd y(stats->N);
+		for(int ii=0; ii < stats->N; ii++) {
+			double power = 1;
+			for(int k=0; k <= deg; k++) {
+				vandermonde(ii,k) = power;
+				power *= x[ii];
+			}
+			y(ii) = ref[ii];
+		}
+		Eigen::VectorXd scale = vandermonde.colwise().norm().transpose();
+		for(int k=0; k <= deg; k++) if (scale(k) == 0) scale(k) = 1;
+		vandermonde *= scale.cwiseInverse().asDiagonal();
+		Eigen::VectorXd coefficients = vandermonde.colPivHouseholderQr().solve(y);
+		for(int k=0; k <= deg; k++) result[k] = coefficients(k) / scale(k);
 
 		stats->transformedFailed=0;
 		for(int ii=0; ii < stats->N; ii++)  { 
@@ -142,7 +177,6 @@ AlignmentStats* PolyAligner::align(int degree) {
 	}
 
     delete[] result;
-	delete[] w;
 	delete[] x;
 	delete[] ref;
 	return stats;
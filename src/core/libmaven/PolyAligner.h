@@ -32,6 +32,14 @@ struct AlignmentStats {
 			 }
 		}
 
+        /**
+         * @brief Transform many values at once, evaluating the polynomial
+         * with Horner's scheme over the whole array.
+         * @return Transformed values, or an empty vector if the transform
+         * is empty.
+         */
+        vector<double> predict(const vector<double>& x);
+
 
 		void summary() { 
 			if (transformedFailed) cerr << "TRANSFORMED FAILED! "; 
@@ -58,6 +66,11 @@ class PolyAligner {
 
 	public:
 		PolyAligner(StatisticsVector<float>& subj, StatisticsVector<float>& ref);
+		~PolyAligner();
+
+		// owns its random generator
+		PolyAligner(const PolyAligner&) = delete;
+		PolyAligner& operator=(const PolyAligner&) = delete;
 
 
 		AlignmentStats* align(int ideg);
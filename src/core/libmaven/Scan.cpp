@@ -18,6 +18,8 @@ Scan::Scan(mzSample* sample, int scannum, int mslevel, float rt, float precursor
 	this->precursorCharge = 0;
 	this->precursorIntensity = 0;
     this->isolationWindow = 1;
+    this->_hasLastFullScan = false;
+    this->_lastFullScan = nullptr;
 }
 
 void Scan::deepcopy(Scan* b) {
@@ -39,7 +41,11 @@ void Scan::deepcopy(Scan* b) {
     this->setPolarity( b->getPolarity() );
     this->originalRt = b->originalRt;
     this->isolationWindow = b->isolationWindow;
-
+    // the copy is not linked to a full scan of its own; getLastFullScan
+    // finds one through the sample until setLastFullScan is called
+    this->_hasLastFullScan = false;
+    this->_lastFullScan = nullptr;
+    this->_precursorPurities = b->_precursorPurities;
 }
 
 int Scan::findHighestIntensityPos(float _mz, MassCutoff *massCutoff) {
@@ -546,6 +552,13 @@ vector<int> Scan::assignCharges(MassCutoff *massCutoffTolr) {
 Scan* Scan::getLastFullScan(int historySize)
 {
 	if (!this->sample) return 0;
+    if (_hasLastFullScan) {
+        if (_lastFullScan
+            and this->scannum - _lastFullScan->scannum < historySize)
+            return _lastFullScan;
+        return 0;
+    }
+
     int scanNum = this->scannum;
     for(int i = scanNum; i > (scanNum - historySize); i--) {
         Scan* lscan = this->sample->getScan(i);
@@ -555,6 +568,12 @@ Scan* Scan::getLastFullScan(int historySize)
 	return 0;
 }
 
+void Scan::setLastFullScan(Scan* fullScan)
+{
+    _hasLastFullScan = true;
+    _lastFullScan = fullScan;
+}
+
 void Scan::recalculatePrecursorMz(float ppm)
 {
     if (mslevel != 2)
@@ -564,14 +583,14 @@ void Scan::recalculatePrecursorMz(float ppm)
     if (!fullScan)
         return;
     
-    MassCutoff* massCutoff = new MassCutoff();
-    massCutoff->setMassCutoffAndType(ppm, "ppm");
+    MassCutoff massCutoff;
+    massCutoff.setMassCutoffAndType(ppm, "ppm");
 
     //find highest intensity precursor for this ms2 scan
     //increase the error range till a precursor is found
     for (int i : {1, 2, 3, 4, 5}) {
-        massCutoff->setMassCutoff(ppm * i);
-        int pos = fullScan->findHighestIntensityPos(this->precursorMz, massCutoff);
+        massCutoff.setMassCutoff(ppm * i);
+        int pos = fullScan->findHighestIntensityPos(this->precursorMz, &massCutoff);
         if (pos > 0 && pos < fullScan->nobs()) {
             this->precursorMz = fullScan->mz[pos];
             break;
@@ -595,7 +614,8 @@ vector<mzPoint> Scan::getIsolatedRegion(float isolationWindowAmu)
 	float minMz = this->precursorMz - (isolationWindowAmu / 2.0f);
 	float maxMz = this->precursorMz + (isolationWindowAmu / 2.0f);
 	
-	for(int i = 0; i < lastFullScan->nobs(); i++ ) {
+	auto first = lower_bound(lastFullScan->mz.begin(), lastFullScan->mz.end(), minMz);
+	for(int i = first - lastFullScan->mz.begin(); i < lastFullScan->nobs(); i++ ) {
 		if (lastFullScan->mz[i] < minMz) continue;
 		if (lastFullScan->mz[i] > maxMz) break;
 		isolatedSegment.push_back(mzPoint(lastFullScan->rt,
@@ -606,6 +626,26 @@ vector<mzPoint> Scan::getIsolatedRegion(float isolationWindowAmu)
 }
 
 double Scan::getPrecursorPurity(float ppm)
+{
+    for (auto& purity : _precursorPurities) {
+        if (purity.first == ppm)
+            return purity.second;
+    }
+    return _computePrecursorPurity(ppm);
+}
+
+void Scan::cachePrecursorPurity(float ppm)
+{
+    for (auto& purity : _precursorPurities) {
+        if (purity.first == ppm) {
+            purity.second = _computePrecursorPurity(ppm);
+            return;
+        }
+    }
+    _precursorPurities.push_back(make_pair(ppm, _computePrecursorPurity(ppm)));
+}
+
+double Scan::_computePrecursorPurity(float ppm)
 {
     if (this->precursorMz <= 0 ) return 0;
     if (this->sample == 0 ) return 0;
@@ -619,9 +659,9 @@ double Scan::getPrecursorPurity(float ppm)
     if (!lastFullScan) return 0;
 
     //locate intensity of isolated mass
-    MassCutoff* massCutoff = new MassCutoff();
-    massCutoff->setMassCutoffAndType(ppm, "ppm");
-    int pos = lastFullScan->findHighestIntensityPos(this->precursorMz, massCutoff);
+    MassCutoff massCutoff;
+    massCutoff.setMassCutoffAndType(ppm, "ppm");
+    int pos = lastFullScan->findHighestIntensityPos(this->precursorMz, &massCutoff);
     if (pos < 0) return 0;
     double targetInt = lastFullScan->intensity[pos];
 
@@ -630,7 +670,6 @@ double Scan::getPrecursorPurity(float ppm)
     for (mzPoint& point: isolatedSegment)
         totalInt += point.y;
 
-    delete massCutoff;
     if (totalInt > 0) {
         return (targetInt / totalInt);
     } else {
@@ -188,6 +188,19 @@ class Scan
      */ 
     double getPrecursorPurity(float ppm = 10.0);
 
+    /**
+     * @brief compute and store the precursor purity at the given ppm, so
+     * that later calls to getPrecursorPurity with the same ppm are lookups
+     */
+    void cachePrecursorPurity(float ppm);
+
+    /**
+     * @brief link this scan to the closest full scan at or before it in
+     * its sample (nullptr if there is none), so that getLastFullScan does
+     * not have to walk back through the sample's scans
+     */
+    void setLastFullScan(Scan* fullScan);
+
     /**
     *@brief print the info present in a scan
     */
@@ -242,6 +255,16 @@ class Scan
   private:
     float parentPeakIntensity;
 
+    bool _hasLastFullScan;
+    Scan* _lastFullScan;
+
+    /**
+     * @brief (ppm, purity) pairs stored by cachePrecursorPurity
+     */
+    vector<pair<float, double>> _precursorPurities;
+
+    double _computePrecursorPurity(float ppm);
+
     struct BrotherData
     {
         float expectedMass;
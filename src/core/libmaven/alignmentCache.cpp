@@ -0,0 +1,193 @@
+#include <cstdio>
+#include <random>
+
+#include "alignmentCache.h"
+#include "mzSample.h"
+#include "mzUtils.h"
+#include "Scan.h"
+
+namespace {
+    // written at the start of every entry; bump the version whenever the
+    // format or the alignment algorithms change in a way that invalidates
+    // existing entries
+    const char magic[8] = {'M', 'A', 'V', 'E', 'N', 'A', 'L', 'N'};
+    const uint32_t version = 1;
+
+    const uint64_t fnvOffset = 14695981039346656037ULL;
+    const uint64_t fnvPrime = 1099511628211ULL;
+
+    /**
+     * @brief FNV-1a step over a 32-bit word.
+     */
+    inline uint64_t hashWord(uint64_t hash, uint32_t word)
+    {
+        return (hash ^ word) * fnvPrime;
+    }
+
+    inline uint64_t hashFloat(uint64_t hash, float value)
+    {
+        uint32_t word;
+        memcpy(&word, &value, sizeof(word));
+        return hashWord(hash, word);
+    }
+
+    uint64_t hashString(const string& str)
+    {
+        uint64_t hash = fnvOffset;
+        for (unsigned char c : str)
+            hash = hashWord(hash, c);
+        return hash;
+    }
+
+    string toHex(uint64_t value)
+    {
+        stringstream stream;
+        stream << hex << setw(16) << setfill('0') << value;
+        return stream.str();
+    }
+
+    /**
+     * @brief Create a directory along with all its missing parents.
+     */
+    void createPath(const string& path)
+    {
+        for (size_t i = 1; i < path.size(); i++) {
+            if (path[i] == '/' || path[i] == '\\')
+                mzUtils::createDir(path.substr(0, i).c_str());
+        }
+        mzUtils::createDir(path.c_str());
+    }
+}
+
+AlignmentCache::AlignmentCache(const string& directory)
+{
+    _directory = directory;
+}
+
+uint64_t AlignmentCache::contentHash(mzSample* sample)
+{
+    uint64_t hash = fnvOffset;
+    hash = hashWord(hash, sample->scans.size());
+    for (auto scan : sample->scans) {
+        hash = hashWord(hash, scan->mslevel);
+        hash = hashFloat(hash, scan->originalRt);
+        hash = hashWord(hash, scan->nobs());
+        for (auto mz : scan->mz)
+            hash = hashFloat(hash, mz);
+        for (auto intensity : scan->intensity)
+            hash = hashFloat(hash, intensity);
+    }
+    return hash;
+}
+
+string AlignmentCache::_path(uint64_t sampleHash,
+                             uint64_t referenceHash,
+                             const string& parameters) const
+{
+    return _directory
+           + DIR_SEPARATOR_STR
+           + toHex(sampleHash)
+           + "-"
+           + toHex(referenceHash)
+           + "-"
+           + toHex(hashString(parameters))
+           + ".rt";
+}
+
+bool AlignmentCache::contains(uint64_t sampleHash,
+                              uint64_t referenceHash,
+                              const string& parameters) const
+{
+    if (!enabled())
+        return false;
+    return mzUtils::fileExists(_path(sampleHash, referenceHash, parameters));
+}
+
+bool AlignmentCache::load(uint64_t sampleHash,
+                          uint64_t referenceHash,
+                          const string& parameters,
+                          vector<float>& rts) const
+{
+    if (!enabled())
+        return false;
+
+    ifstream file(_path(sampleHash, referenceHash, parameters),
+                  ios::in | ios::binary);
+    if (!file.is_open())
+        return false;
+
+    char fileMagic[sizeof(magic)];
+    uint32_t fileVersion = 0;
+    uint32_t parametersSize = 0;
+    file.read(fileMagic, sizeof(fileMagic));
+    file.read(reinterpret_cast<char*>(&fileVersion), sizeof(fileVersion));
+    file.read(reinterpret_cast<char*>(&parametersSize),
+              sizeof(parametersSize));
+    if (!file
+        || memcmp(fileMagic, magic, sizeof(magic)) != 0
+        || fileVersion != version
+        || parametersSize != parameters.size())
+        return false;
+
+    string fileParameters(parametersSize, '\0');
+    file.read(&fileParameters[0], parametersSize);
+    if (!file || fileParameters != parameters)
+        return false;
+
+    uint64_t count = 0;
+    file.read(reinterpret_cast<char*>(&count), sizeof(count));
+    if (!file)
+        return false;
+    rts.resize(count);
+    file.read(reinterpret_cast<char*>(rts.data()), count * sizeof(float));
+    return static_cast<bool>(file);
+}
+
+bool AlignmentCache::save(uint64_t sampleHash,
+                          uint64_t referenceHash,
+                          const string& parameters,
+                          const vector<float>& rts) const
+{
+    if (!enabled())
+        return false;
+
+    createPath(_directory);
+    string path = _path(sampleHash, referenceHash, parameters);
+    random_device device;
+    string tmpPath = path + ".tmp" + to_string(device());
+
+    {
+        ofstream file(tmpPath, ios::out | ios::binary | ios::trunc);
+        if (!file.is_open()) {
+            cerr << "Error: could not write alignment cache entry "
+                 << tmpPath
+                 << endl;
+            return false;
+        }
+        uint32_t parametersSize = parameters.size();
+        uint64_t count = rts.size();
+        file.write(magic, sizeof(magic));
+        file.write(reinterpret_cast<const char*>(&version), sizeof(version));
+        file.write(reinterpret_cast<const char*>(&parametersSize),
+                   sizeof(parametersSize));
+        file.write(parameters.data(), parametersSize);
+        file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+        file.write(reinterpret_cast<const char*>(rts.data()),
+                   count * sizeof(float));
+        if (!file) {
+            file.close();
+            remove(tmpPath.c_str());
+            return false;
+        }
+    }
+
+    // rename does not replace existing files everywhere
+    if (rename(tmpPath.c_str(), path.c_str()) != 0) {
+        remove(path.c_str());
+        if (rename(tmpPath.c_str(), path.c_str()) != 0) {
+            remove(tmpPath.c_str());
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,77 @@
+#ifndef ALIGNMENTCACHE_H
+#define ALIGNMENTCACHE_H
+
+#include <stdint.h>
+
+#include "standardincludes.h"
+
+class mzSample;
+
+using namespace std;
+
+/**
+ * @brief Stores aligned retention times of samples on disk, so that aligning
+ * the same samples again with the same parameters can be skipped.
+ *
+ * @details Entries are keyed by a hash of the sample's content, a hash of the
+ * reference sample's content and a description of the alignment parameters,
+ * and hold the aligned retention time of every scan of the sample. Content
+ * hashes cover the original retention times, m/z values and intensities of
+ * all scans, but not the current retention times, so that samples that were
+ * already aligned are still recognised. Every entry is a file of its own in
+ * the cache directory, written to a temporary file first and then renamed,
+ * so that concurrent runs never read partial entries. The parameters are stored
+ * in full and compared when reading, in addition to being part of the key.
+ */
+class AlignmentCache
+{
+  public:
+    /**
+     * @brief Constructor of class AlignmentCache.
+     * @param directory Directory holding the entries, created when the first
+     * entry is saved. An empty path disables the cache.
+     */
+    AlignmentCache(const string& directory);
+
+    inline bool enabled() const { return !_directory.empty(); }
+
+    /**
+     * @brief Hash of the scans of a sample.
+     */
+    static uint64_t contentHash(mzSample* sample);
+
+    /**
+     * @brief Whether an entry exists for the given key.
+     */
+    bool contains(uint64_t sampleHash,
+                  uint64_t referenceHash,
+                  const string& parameters) const;
+
+    /**
+     * @brief Read the aligned retention times stored for the given key.
+     * @return True if an entry was found and read completely.
+     */
+    bool load(uint64_t sampleHash,
+              uint64_t referenceHash,
+              const string& parameters,
+              vector<float>& rts) const;
+
+    /**
+     * @brief Store aligned retention times for the given key, replacing any
+     * existing entry.
+     * @return True if the entry was written.
+     */
+    bool save(uint64_t sampleHash,
+              uint64_t referenceHash,
+              const string& parameters,
+              const vector<float>& rts) const;
+
+  private:
+    string _directory;
+
+    string _path(uint64_t sampleHash,
+                 uint64_t referenceHash,
+                 const string& parameters) const;
+};
+
+#endif // ALIGNMENTCACHE_H
@@ -1,9 +1,39 @@
 #include "classifierNeuralNet.h"
+#include "datastructures/peakTable.h"
 #include "EIC.h"
 #include "mzSample.h"
 #include "Peak.h"
 #include "PeakGroup.h"
 
+NeuralNetModel::NeuralNetModel(nnwork* brain)
+{
+    int numInputs = brain->get_layersize(NEUN_INPUT);
+    int numHidden = brain->get_layersize(HIDDEN);
+    int numOutputs = brain->get_layersize(OUTPUT);
+
+    _hiddenWeights.resize(numHidden, numInputs);
+    for (int j = 0; j < numHidden; j++)
+        for (int i = 0; i < numInputs; i++)
+            _hiddenWeights(j, i) = brain->get_weight(HIDDEN, j, i);
+
+    _outputWeights.resize(numOutputs, numHidden);
+    for (int k = 0; k < numOutputs; k++)
+        for (int j = 0; j < numHidden; j++)
+            _outputWeights(k, j) = brain->get_weight(OUTPUT, k, j);
+}
+
+Eigen::VectorXf NeuralNetModel::score(const Eigen::MatrixXf& features) const
+{
+    // sigmoid(x) = 1 / (1 + e^-x), applied to every node of a layer
+    Eigen::MatrixXf hidden = features * _hiddenWeights.transpose();
+    hidden = (1.0f + (-hidden.array()).exp()).inverse().matrix();
+
+    Eigen::MatrixXf output = hidden * _outputWeights.transpose();
+    output = (1.0f + (-output.array()).exp()).inverse().matrix();
+
+    return output.col(0);
+}
+
 ClassifierNeuralNet::ClassifierNeuralNet() {
 	num_features = 9;
 	hidden_layer = 4;
@@ -25,11 +55,20 @@ ClassifierNeuralNet::ClassifierNeuralNet() {
 }
 
 ClassifierNeuralNet::~ClassifierNeuralNet() {
+	_model.reset();
 	if (brain)
 		delete (brain);
 	brain = NULL;
 }
 
+void ClassifierNeuralNet::_updateModel() {
+    if (brain == NULL) {
+        _model.reset();
+        return;
+    }
+    _model = make_shared<const NeuralNetModel>(brain);
+}
+
 bool ClassifierNeuralNet::hasModel() {
 	return brain != NULL;
 }
@@ -49,27 +88,42 @@ void ClassifierNeuralNet::loadModel(string filename) {
 		delete (brain);
 	brain = new nnwork(num_features, hidden_layer, num_outputs);
 	brain->load((char*) filename.c_str());
+	_updateModel();
 	cout << "Read in classification model " << filename << endl;
 }
 
 vector<float> ClassifierNeuralNet::getFeatures(Peak& p) {
+	PeakTable table;
+	table.append(p);
+	Eigen::MatrixXf features = getFeatures(table);
+
 	vector<float> set(num_features, 0);
-	if (p.width > 0) {
-		set[0] = p.peakAreaFractional;
-		set[1] = p.noNoiseFraction;
-		set[2] = p.symmetry / (p.width + 1) * log2(p.width + 1);
-		set[3] = p.groupOverlapFrac;
-		set[4] = p.gaussFitR2 * 100.0;
-		
-        set[5] = p.signalBaselineRatio > 0 ? log2(p.signalBaselineRatio) / 10.0 : 0;
-		set[6] = p.peakRank / 10.0;
-		set[7] = p.peakIntensity > 0 ? log10(p.peakIntensity) : 0;
-		set[8] = p.width <= 3 && p.signalBaselineRatio >= 3.0 ? 1 : 0;
-		//set[9] =  ((float) (p.width >= 3) + (int) (p.symmetry >= 5) + (int) (p.signalBaselineRatio > 3.0))/3;
-		if (p.peakRank / 10.0 > 1)
-			set[6] = 1;
-		//cerr << "tiny=" << set[8] << " " << set[7] << " " << p.symmetry << endl;
-		//set[7] =  ((float) (p.baseLineRightCleanCount >= 5) +  (int) (p.baseLineLeftCleanCount >= 5))/2;
+	for (int k = 0; k < num_features; k++)
+		set[k] = features(0, k);
+	return set;
+}
+
+Eigen::MatrixXf ClassifierNeuralNet::getFeatures(const PeakTable& table) {
+	Eigen::MatrixXf set = Eigen::MatrixXf::Zero(table.size(), num_features);
+	for (size_t i = 0; i < table.size(); i++) {
+		unsigned int width = table.width[i];
+		if (width == 0)
+			continue;
+
+		float signalBaselineRatio = table.signalBaselineRatio[i];
+		float peakIntensity = table.peakIntensity[i];
+		set(i, 0) = table.peakAreaFractional[i];
+		set(i, 1) = table.noNoiseFraction[i];
+		set(i, 2) = table.symmetry[i] / (width + 1) * log2(width + 1);
+		set(i, 3) = table.groupOverlapFrac[i];
+		set(i, 4) = table.gaussFitR2[i] * 100.0;
+		set(i, 5) = signalBaselineRatio > 0 ? log2(signalBaselineRatio) / 10.0
+		                                    : 0;
+		set(i, 6) = table.peakRank[i] / 10.0;
+		set(i, 7) = peakIntensity > 0 ? log10(peakIntensity) : 0;
+		set(i, 8) = width <= 3 && signalBaselineRatio >= 3.0 ? 1 : 0;
+		if (table.peakRank[i] / 10.0 > 1)
+			set(i, 6) = 1;
 	}
 	return set;
 }
@@ -79,34 +133,42 @@ void ClassifierNeuralNet::classify(PeakGroup* grp) {
 	if (brain == NULL)
 		return;
 
-    for (unsigned int j=0; j < grp->peaks.size(); j++ ) {
-        grp->peaks[j].quality=scorePeak(grp->peaks[j]);
-	}
+	PeakTable table(grp->peaks);
+	vector<float> scores = scorePeaks(table);
+	for (unsigned int j = 0; j < grp->peaks.size(); j++)
+		grp->peaks[j].quality = scores[j];
 }
 
 void ClassifierNeuralNet::scoreEICs(vector<EIC*> &eics)
 {
-
+	// gather peaks of all EICs, so that they can be scored in one batch
+	PeakTable table;
 	for (unsigned int i = 0; i < eics.size(); i++)
-	{
-		for (unsigned int j = 0; j < eics[i]->peaks.size(); j++ ) {
-			eics[i]->peaks[j].quality = scorePeak(eics[i]->peaks[j]);
-		}
+		table.append(eics[i]->peaks);
+
+	vector<float> scores = scorePeaks(table);
+	size_t row = 0;
+	for (unsigned int i = 0; i < eics.size(); i++) {
+		for (unsigned int j = 0; j < eics[i]->peaks.size(); j++)
+			eics[i]->peaks[j].quality = scores[row++];
 	}
 }
 
 float ClassifierNeuralNet::scorePeak(Peak& p) {
-   //Merged with Maven776 - Kiran
-    float result[2] = {0.1,0.1};
-    if(brain != NULL) {
-        float fts[1000];
-        vector<float> features = getFeatures(p);
-        for(int k=0;k<num_features;k++)
-        fts[k]=features[k];
-        brain->run(fts, result);
-    }
+	PeakTable table;
+	table.append(p);
+	return scorePeaks(table)[0];
+}
+
+vector<float> ClassifierNeuralNet::scorePeaks(const PeakTable& table) {
+	// keep a reference, so that the model outlives this call even if it is
+	// replaced meanwhile
+	shared_ptr<const NeuralNetModel> model = _model;
+	if (!model)
+		return vector<float>(table.size(), 0.1);
 
-    return result[0];
+	Eigen::VectorXf scores = model->score(getFeatures(table));
+	return vector<float>(scores.data(), scores.data() + scores.size());
 }
 
 
@@ -142,6 +204,7 @@ void ClassifierNeuralNet::refineModel(PeakGroup* grp) {
 			}
 		}
 	}
+	_updateModel();
 }
 
 void ClassifierNeuralNet::train(vector<PeakGroup*>& groups) {
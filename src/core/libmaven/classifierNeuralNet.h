@@ -1,13 +1,53 @@
 #ifndef CLASSIFER_NEURALNET
 #define CLASSIFER_NEURALNET
 
+#include <memory>
+
+#include <Eigen>
+
 #include "classifier.h"
 #include "standardincludes.h"
 
 class EIC;
+class PeakTable;
 
 using namespace std;
 
+/**
+ * @brief Immutable snapshot of the weights of a trained three-layer network.
+ * @details Unlike nnwork::run, which stores intermediate outputs inside the
+ * network, evaluating this model has no side effects, so a single instance
+ * can be shared by any number of threads. Rows of a feature matrix are
+ * scored together using matrix products.
+ */
+class NeuralNetModel
+{
+  public:
+    /**
+     * @brief Copy the weights of a network.
+     * @param brain The network to take a snapshot of.
+     */
+    explicit NeuralNetModel(nnwork* brain);
+
+    /**
+     * @brief Evaluate the network for a batch of inputs.
+     * @param features Matrix with one row of input features per sample.
+     * @return Value of the first output node for every row.
+     */
+    Eigen::VectorXf score(const Eigen::MatrixXf& features) const;
+
+  private:
+    /**
+     * @brief Weights of hidden layer (hidden nodes × input nodes).
+     */
+    Eigen::MatrixXf _hiddenWeights;
+
+    /**
+     * @brief Weights of output layer (output nodes × hidden nodes).
+     */
+    Eigen::MatrixXf _outputWeights;
+};
+
 class ClassifierNeuralNet: public Classifier {
 public:
 	ClassifierNeuralNet();
@@ -19,9 +59,37 @@ public:
 	void loadModel(string filename);
 	bool hasModel();
     vector<float> getFeatures(Peak& p);
+
+    /**
+     * @brief Compute the input features for all peaks of a peak table.
+     * @param table Columnar view of the peaks.
+     * @return Matrix with one row of features for each row of the table.
+     */
+    Eigen::MatrixXf getFeatures(const PeakTable& table);
+
 	float scorePeak(Peak& p);
+
+    /**
+     * @brief Score all rows of a peak table in a single batch.
+     * @details This method can be called concurrently from multiple threads,
+     * as long as the model is not being loaded or trained at the same time.
+     * @param table Columnar view of the peaks to be scored.
+     * @return Quality score for every row of the table.
+     */
+    vector<float> scorePeaks(const PeakTable& table);
+
 	void scoreEICs(vector<EIC*> &eics);
 private:
+    /**
+     * @brief Refresh the shared model snapshot after the network has been
+     * loaded or its weights have changed.
+     */
+    void _updateModel();
+
+    /**
+     * @brief Thread-safe snapshot of the network, used for scoring.
+     */
+    shared_ptr<const NeuralNetModel> _model;
 	
 
 	//neural net specific features
@@ -0,0 +1,108 @@
+#include <cstdint>
+
+#include "memoryArena.h"
+
+namespace {
+    thread_local MemoryArena* currentArena = nullptr;
+}
+
+MemoryArena::MemoryArena(size_t blockSize)
+{
+    _currentBlock = 0;
+    _blockSize = blockSize > 0 ? blockSize : 1;
+    _bytesInUse = 0;
+    _highWaterMark = 0;
+    _blockAllocations = 0;
+    _allocationCount = 0;
+}
+
+MemoryArena::~MemoryArena()
+{
+    for (auto& block : _blocks)
+        delete[] block.data;
+    _blocks.clear();
+}
+
+void MemoryArena::_addBlock(size_t minSize)
+{
+    Block block;
+    block.size = max(minSize, _blockSize);
+    block.data = new char[block.size];
+    block.used = 0;
+    _blocks.push_back(block);
+    _blockAllocations++;
+}
+
+void* MemoryArena::allocate(size_t bytes, size_t alignment)
+{
+    if (bytes == 0)
+        bytes = 1;
+
+    while (true) {
+        if (_currentBlock < _blocks.size()) {
+            Block& block = _blocks[_currentBlock];
+            uintptr_t base = reinterpret_cast<uintptr_t>(block.data);
+            uintptr_t start = (base + block.used + alignment - 1)
+                              & ~(uintptr_t)(alignment - 1);
+            size_t end = (start - base) + bytes;
+            if (end <= block.size) {
+                _bytesInUse += end - block.used;
+                _highWaterMark = max(_highWaterMark, _bytesInUse);
+                _allocationCount++;
+                block.used = end;
+                return reinterpret_cast<void*>(start);
+            }
+
+            // move on to the next (already allocated) block if there is one
+            if (_currentBlock + 1 < _blocks.size()) {
+                _currentBlock++;
+                continue;
+            }
+        }
+
+        _addBlock(bytes + alignment);
+        _currentBlock = _blocks.size() - 1;
+    }
+}
+
+void MemoryArena::reset()
+{
+    if (_blocks.size() > 1) {
+        // coalesce into one block that can hold everything needed so far
+        size_t total = capacity();
+        for (auto& block : _blocks)
+            delete[] block.data;
+        _blocks.clear();
+        _addBlock(max(total, _highWaterMark));
+    }
+
+    for (auto& block : _blocks)
+        block.used = 0;
+    _currentBlock = 0;
+    _bytesInUse = 0;
+    _allocationCount = 0;
+}
+
+size_t MemoryArena::capacity() const
+{
+    size_t total = 0;
+    for (const auto& block : _blocks)
+        total += block.size;
+    return total;
+}
+
+MemoryArena* MemoryArena::current()
+{
+    return currentArena;
+}
+
+MemoryArena::Scope::Scope(MemoryArena* arena)
+{
+    _previous = currentArena;
+    currentArena = arena;
+}
+
+MemoryArena::Scope::~Scope()
+{
+    currentArena = _previous;
+}
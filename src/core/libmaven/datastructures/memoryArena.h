@@ -0,0 +1,130 @@
+#ifndef MEMORYARENA_H
+#define MEMORYARENA_H
+
+#include "standardincludes.h"
+
+using namespace std;
+
+/**
+ * @brief A bump allocator for short-lived buffers.
+ *
+ * @details Memory is handed out by advancing an offset into large blocks and
+ * is never freed individually; instead the whole arena is `reset` once all
+ * objects allocated from it are dead (e.g., at the end of a slice during
+ * peak detection). After a reset, any blocks that were needed beyond the
+ * first are coalesced into a single block large enough to hold the previous
+ * high-water mark, so that a steady-state workload does not touch the heap.
+ *
+ * An arena is not thread-safe. Each worker thread is expected to have its
+ * own arena, which can be made available to code running on that thread
+ * through a `MemoryArena::Scope`.
+ */
+class MemoryArena
+{
+  public:
+    /**
+     * @brief Construct an arena.
+     * @param blockSize Minimum size (in bytes) of every block allocated by
+     * this arena. No memory is allocated until the first request.
+     */
+    explicit MemoryArena(size_t blockSize = 1 << 20);
+
+    ~MemoryArena();
+
+    MemoryArena(const MemoryArena&) = delete;
+    MemoryArena& operator=(const MemoryArena&) = delete;
+
+    /**
+     * @brief Allocate raw memory from the arena.
+     * @param bytes Number of bytes requested.
+     * @param alignment Alignment of the returned address, must be a power
+     * of two.
+     * @return Pointer to uninitialized memory, valid until the next reset.
+     */
+    void* allocate(size_t bytes, size_t alignment = alignof(max_align_t));
+
+    /**
+     * @brief Allocate an uninitialized array of trivially destructible
+     * objects from the arena.
+     * @param n Number of elements in the array.
+     * @return Pointer to the first element, valid until the next reset.
+     */
+    template <typename T>
+    T* allocateArray(size_t n)
+    {
+        return static_cast<T*>(allocate(n * sizeof(T), alignof(T)));
+    }
+
+    /**
+     * @brief Release all allocations made from this arena at once.
+     */
+    void reset();
+
+    /**
+     * @brief Number of bytes currently handed out (including padding).
+     */
+    size_t bytesInUse() const { return _bytesInUse; }
+
+    /**
+     * @brief Largest value of `bytesInUse` observed over the lifetime of this
+     * arena. Useful for choosing a block size.
+     */
+    size_t highWaterMark() const { return _highWaterMark; }
+
+    /**
+     * @brief Total number of bytes held by the arena's blocks.
+     */
+    size_t capacity() const;
+
+    /**
+     * @brief Number of blocks obtained from the heap so far. This stays
+     * constant once the arena has been sized for its workload.
+     */
+    size_t blockAllocations() const { return _blockAllocations; }
+
+    /**
+     * @brief Number of allocations served since the last reset.
+     */
+    size_t allocationCount() const { return _allocationCount; }
+
+    /**
+     * @brief The arena made current for the calling thread, if any.
+     * @return Pointer to the active arena or nullptr if allocations on this
+     * thread should go to the heap.
+     */
+    static MemoryArena* current();
+
+    /**
+     * @brief Makes an arena current for the calling thread for the lifetime
+     * of this object. Scopes can be nested; the previously current arena is
+     * restored on destruction.
+     */
+    class Scope
+    {
+      public:
+        explicit Scope(MemoryArena* arena);
+        ~Scope();
+
+      private:
+        MemoryArena* _previous;
+    };
+
+  private:
+    struct Block {
+        char* data;
+        size_t size;
+        size_t used;
+    };
+
+    void _addBlock(size_t minSize);
+
+    vector<Block> _blocks;
+    size_t _currentBlock;
+    size_t _blockSize;
+    size_t _bytesInUse;
+    size_t _highWaterMark;
+    size_t _blockAllocations;
+    size_t _allocationCount;
+};
+
+#endif // MEMORYARENA_H
@@ -0,0 +1,73 @@
+#include "peakTable.h"
+#include "Peak.h"
+
+PeakTable::PeakTable(const vector<Peak>& peaks)
+{
+    append(peaks);
+}
+
+void PeakTable::append(const vector<Peak>& peaks)
+{
+    reserve(size() + peaks.size());
+    for (const auto& peak : peaks)
+        append(peak);
+}
+
+void PeakTable::append(const Peak& peak)
+{
+    quality.push_back(peak.quality);
+    peakIntensity.push_back(peak.peakIntensity);
+    signalBaselineRatio.push_back(peak.signalBaselineRatio);
+    peakAreaFractional.push_back(peak.peakAreaFractional);
+    noNoiseFraction.push_back(peak.noNoiseFraction);
+    symmetry.push_back(peak.symmetry);
+    groupOverlapFrac.push_back(peak.groupOverlapFrac);
+    gaussFitR2.push_back(peak.gaussFitR2);
+    peakRank.push_back(peak.peakRank);
+    width.push_back(peak.width);
+}
+
+void PeakTable::reserve(size_t n)
+{
+    quality.reserve(n);
+    peakIntensity.reserve(n);
+    signalBaselineRatio.reserve(n);
+    peakAreaFractional.reserve(n);
+    noNoiseFraction.reserve(n);
+    symmetry.reserve(n);
+    groupOverlapFrac.reserve(n);
+    gaussFitR2.reserve(n);
+    peakRank.reserve(n);
+    width.reserve(n);
+}
+
+void PeakTable::clear()
+{
+    quality.clear();
+    peakIntensity.clear();
+    signalBaselineRatio.clear();
+    peakAreaFractional.clear();
+    noNoiseFraction.clear();
+    symmetry.clear();
+    groupOverlapFrac.clear();
+    gaussFitR2.clear();
+    peakRank.clear();
+    width.clear();
+}
+
+size_t PeakTable::countAbove(const vector<float>& column, float threshold)
+{
+    return countAbove(column, threshold, 0, column.size());
+}
+
+size_t PeakTable::countAbove(const vector<float>& column,
+                             float threshold,
+                             size_t begin,
+                             size_t end)
+{
+    size_t count = 0;
+    const float* values = column.data();
+    for (size_t i = begin; i < end; ++i)
+        count += values[i] > threshold;
+    return count;
+}
@@ -0,0 +1,97 @@
+#ifndef PEAKTABLE_H
+#define PEAKTABLE_H
+
+#include "standardincludes.h"
+
+class Peak;
+
+using namespace std;
+
+/**
+ * @brief Columnar (structure-of-arrays) view over the frequently read fields
+ * of a set of peaks.
+ *
+ * @details Peak objects carry a large number of fields, most of which are
+ * only needed for reporting and display. Filtering and scoring, however,
+ * touch only a handful of them for every peak. A PeakTable copies these
+ * "hot" fields into contiguous columns so that predicates and feature
+ * extraction can stream through them, instead of striding over full Peak
+ * objects. Row `i` of the table always corresponds to the `i`th peak it was
+ * built from; the table does not hold any reference to the source peaks.
+ */
+class PeakTable
+{
+  public:
+    PeakTable() {}
+
+    /**
+     * @brief Construct a table with one row for each of the given peaks.
+     * @param peaks Vector of peaks whose hot fields will be copied.
+     */
+    explicit PeakTable(const vector<Peak>& peaks);
+
+    /**
+     * @brief Append one row for each of the given peaks to this table.
+     * @param peaks Vector of peaks whose hot fields will be copied.
+     */
+    void append(const vector<Peak>& peaks);
+
+    /**
+     * @brief Append a single peak as a new row to this table.
+     * @param peak The peak whose hot fields will be copied.
+     */
+    void append(const Peak& peak);
+
+    /**
+     * @brief Reserve space for the given number of rows in all columns.
+     * @param n Number of rows.
+     */
+    void reserve(size_t n);
+
+    /**
+     * @brief Remove all rows from this table.
+     */
+    void clear();
+
+    /**
+     * @brief Number of rows (peaks) in this table.
+     */
+    inline size_t size() const { return quality.size(); }
+
+    /**
+     * @brief Count the values in a column that are strictly greater than a
+     * threshold.
+     * @param column One of the columns of this table.
+     * @param threshold Value to be compared against.
+     * @return Number of rows with a value greater than the threshold.
+     */
+    static size_t countAbove(const vector<float>& column, float threshold);
+
+    /**
+     * @brief Count the values in a range of rows of a column that are
+     * strictly greater than a threshold.
+     * @param column One of the columns of this table.
+     * @param threshold Value to be compared against.
+     * @param begin First row of the range.
+     * @param end One past the last row of the range.
+     * @return Number of rows in range with a value greater than the
+     * threshold.
+     */
+    static size_t countAbove(const vector<float>& column,
+                             float threshold,
+                             size_t begin,
+                             size_t end);
+
+    vector<float> quality;
+    vector<float> peakIntensity;
+    vector<float> signalBaselineRatio;
+    vector<float> peakAreaFractional;
+    vector<float> noNoiseFraction;
+    vector<float> symmetry;
+    vector<float> groupOverlapFrac;
+    vector<float> gaussFitR2;
+    vector<float> peakRank;
+    vector<unsigned int> width;
+};
+
+#endif // PEAKTABLE_H
@@ -1,3 +1,4 @@
+#include "constants.h"
 #include "elementMass.h"
 
 ElementMass::ElementMass() {
@@ -85,4 +86,46 @@ ElementMass::ElementMass() {
     elementMassMap["Cu"] = 62.929599;
     elementMassMap["Sn"] = 119.902199;
 
+    elementIsotopeMap["H"] = {{elementMassMap["H"], H_ABUNDANCE},
+                              {H2_MASS, H2_ABUNDANCE}};
+    elementIsotopeMap["C"] = {{elementMassMap["C"], C12_ABUNDANCE},
+                              {C13_MASS, C13_ABUNDANCE}};
+    elementIsotopeMap["N"] = {{elementMassMap["N"], N14_ABUNDANCE},
+                              {N15_MASS, N15_ABUNDANCE}};
+    elementIsotopeMap["O"] = {{elementMassMap["O"], 0.99757},
+                              {16.99913170, 0.00038},
+                              {17.9991610, 0.00205}};
+    elementIsotopeMap["Mg"] = {{elementMassMap["Mg"], 0.7899},
+                               {MG25_MASS, 0.1000},
+                               {25.982592929, 0.1101}};
+    elementIsotopeMap["Si"] = {{elementMassMap["Si"], 0.92223},
+                               {28.976494700, 0.04685},
+                               {29.97377017, 0.03092}};
+    elementIsotopeMap["S"] = {{elementMassMap["S"], S32_ABUNDANCE},
+                              {32.97145876, 0.0075},
+                              {S34_MASS, S34_ABUNDANCE},
+                              {35.96708076, 0.0002}};
+    elementIsotopeMap["Cl"] = {{elementMassMap["Cl"], 0.7576},
+                               {36.96590259, 0.2424}};
+    elementIsotopeMap["K"] = {{elementMassMap["K"], 0.932581},
+                              {39.96399848, 0.000117},
+                              {40.96182576, 0.067302}};
+    elementIsotopeMap["Ca"] = {{elementMassMap["Ca"], 0.96941},
+                               {41.95861801, 0.00647},
+                               {42.9587666, 0.00135},
+                               {43.9554818, 0.02086},
+                               {45.9536926, 0.00004},
+                               {47.952534, 0.00187}};
+    elementIsotopeMap["Fe"] = {{53.9396105, 0.05845},
+                               {elementMassMap["Fe"], 0.91754},
+                               {56.9353940, 0.02119},
+                               {57.9332756, 0.00282}};
+    elementIsotopeMap["Se"] = {{73.9224764, 0.0089},
+                               {75.9192136, 0.0937},
+                               {76.9199140, 0.0763},
+                               {77.9173091, 0.2377},
+                               {elementMassMap["Se"], 0.4961},
+                               {81.9166994, 0.0873}};
+    elementIsotopeMap["Br"] = {{elementMassMap["Br"], 0.5069},
+                               {80.9162906, 0.4931}};
 }
@@ -9,6 +9,14 @@ class ElementMass {
     public:
         ElementMass();
         map<string, double> elementMassMap;
+
+        /**
+         * @brief Masses and natural abundances of the stable isotopes of
+         * elements commonly found in metabolites, lipids and peptides. The
+         * most abundant isotope of every element has the mass listed in
+         * elementMassMap.
+         */
+        map<string, vector<pair<double, double>>> elementIsotopeMap;
 };
 
 #endif
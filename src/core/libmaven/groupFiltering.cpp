@@ -1,7 +1,9 @@
 #include "Compound.h"
 #include "datastructures/mzSlice.h"
+#include "datastructures/peakTable.h"
 #include "groupFiltering.h"
 #include "mavenparameters.h"
+#include "mzUtils.h"
 #include "PeakGroup.h"
 
 GroupFiltering::GroupFiltering(MavenParameters *mavenParameters)
@@ -18,54 +20,104 @@ GroupFiltering::GroupFiltering(MavenParameters *mavenParameters, mzSlice* slice)
 
 void GroupFiltering::filter(vector<PeakGroup> &peakgroups)
 {
+    vector<PeakGroup*> groups(peakgroups.size());
+    for (unsigned int i = 0; i < peakgroups.size(); i++)
+        groups[i] = &peakgroups[i];
 
-    unsigned int i = 0;
-    while (i < peakgroups.size())
-    {
-        if (filterByMS1(peakgroups[i]))
-        {
-            peakgroups.erase(peakgroups.begin() + i);
-            continue;
-        }
-        
-        if (_mavenParameters->matchFragmentationFlag &&
-            filterByMS2(peakgroups[i])) {
-            peakgroups.erase(peakgroups.begin() + i);
-            continue;
-        }
+    vector<bool> keep = ms1KeepMask(groups);
 
-        i++;
-        
+    if (_mavenParameters->matchFragmentationFlag) {
+        for (unsigned int i = 0; i < peakgroups.size(); i++) {
+            if (keep[i] && filterByMS2(peakgroups[i]))
+                keep[i] = false;
+        }
     }
 
+    mzUtils::retainMasked(peakgroups, keep);
 }
 
-bool GroupFiltering::filterByMS1(PeakGroup &peakgroup)
+vector<bool> GroupFiltering::ms1KeepMask(const vector<PeakGroup*> &peakgroups)
 {
+    size_t numGroups = peakgroups.size();
+    bool hasModel = _mavenParameters->clsf->hasModel();
+
+    // compute per-group statistics and gather columns for all groups
+    vector<float> maxIntensity(numGroups);
+    vector<float> maxSignalBaselineRatio(numGroups);
+    vector<float> maxQuality(numGroups);
+    vector<float> blankMax(numGroups);
+    vector<float> maxNoNoiseObs(numGroups);
+    vector<int> goodPeakCount(numGroups);
+    vector<size_t> peakOffsets(numGroups + 1, 0);
+    PeakTable peaks;
+    for (size_t i = 0; i < numGroups; i++) {
+        PeakGroup &peakgroup = *peakgroups[i];
+        peakgroup.setQuantitationType(
+            (PeakGroup::QType)_mavenParameters->peakQuantitation);
+        peakgroup.minQuality = _mavenParameters->minQuality;
+        peakgroup.minIntensity = _mavenParameters->minGroupIntensity;
+        peakgroup.groupStatistics();
+
+        if (hasModel) {
+            _mavenParameters->clsf->classify(&peakgroup);
+            peakgroup.updateQuality();
+        }
 
-    //TODO: remove compound assignment from filtering
-    Compound* compound = _slice->compound;
-    peakgroup.setQuantitationType((PeakGroup::QType)_mavenParameters->peakQuantitation);
-    peakgroup.minQuality = _mavenParameters->minQuality;
-    peakgroup.minIntensity = _mavenParameters->minGroupIntensity;
+        maxIntensity[i] = peakgroup.maxIntensity;
+        maxSignalBaselineRatio[i] = peakgroup.maxSignalBaselineRatio;
+        maxQuality[i] = peakgroup.maxQuality;
+        blankMax[i] = peakgroup.blankMax;
+        maxNoNoiseObs[i] = peakgroup.maxNoNoiseObs;
+        goodPeakCount[i] = peakgroup.goodPeakCount;
 
-    peakgroup.groupStatistics();
+        peaks.append(peakgroup.peaks);
+        peakOffsets[i + 1] = peaks.size();
+    }
 
-    if (_mavenParameters->clsf->hasModel()) {
-        _mavenParameters->clsf->classify(&peakgroup);
-        peakgroup.updateQuality();
-        if (peakgroup.goodPeakCount < _mavenParameters->minGoodGroupCount)
-            return true;
+    // evaluate all threshold and quantile predicates over the columns
+    size_t noVisibleSamples = _mavenParameters->getVisibleSamples().size();
+    vector<bool> keep(numGroups, true);
+    for (size_t i = 0; i < numGroups; i++) {
+        if (hasModel
+            && goodPeakCount[i] < _mavenParameters->minGoodGroupCount) {
+            keep[i] = false;
+        } else if (maxNoNoiseObs[i] < _mavenParameters->minNoNoiseObs) {
+            keep[i] = false;
+        } else if (_failsQuantileFilters(maxIntensity[i],
+                                         maxSignalBaselineRatio[i],
+                                         maxQuality[i],
+                                         blankMax[i],
+                                         peaks,
+                                         peakOffsets[i],
+                                         peakOffsets[i + 1],
+                                         noVisibleSamples)) {
+            keep[i] = false;
+        }
     }
 
-    if (peakgroup.maxNoNoiseObs < _mavenParameters->minNoNoiseObs)
-        return true;
-    if (quantileFilters(&peakgroup))
-        return true;
+    // only groups that pass need to be ranked
+    for (size_t i = 0; i < numGroups; i++) {
+        if (keep[i] && _rankGroup(*peakgroups[i]))
+            keep[i] = false;
+    }
+
+    return keep;
+}
+
+bool GroupFiltering::filterByMS1(PeakGroup &peakgroup)
+{
+    vector<PeakGroup*> groups(1, &peakgroup);
+    return !ms1KeepMask(groups)[0];
+}
+
+bool GroupFiltering::_rankGroup(PeakGroup &peakgroup)
+{
+    //TODO: remove compound assignment from filtering
+    Compound* compound = _slice ? _slice->compound : peakgroup.compound;
 
     if (compound)
         peakgroup.compound = compound;
-    if (!_slice->srmId.empty())
+    if (_slice && !_slice->srmId.empty())
         peakgroup.srmId = _slice->srmId;
 
     float rtDiff = -1;
@@ -119,39 +171,53 @@ bool GroupFiltering::filterByMS2(PeakGroup& peakgroup)
 }
 
 bool GroupFiltering::quantileFilters(PeakGroup *group) {
-    if (group->maxIntensity < _mavenParameters->minGroupIntensity){
+    PeakTable peaks(group->peaks);
+    return _failsQuantileFilters(group->maxIntensity,
+                                 group->maxSignalBaselineRatio,
+                                 group->maxQuality,
+                                 group->blankMax,
+                                 peaks,
+                                 0,
+                                 peaks.size(),
+                                 _mavenParameters->getVisibleSamples().size());
+}
+
+bool GroupFiltering::_failsQuantileFilters(float maxIntensity,
+                                           float maxSignalBaselineRatio,
+                                           float maxQuality,
+                                           float blankMax,
+                                           const PeakTable &peaks,
+                                           size_t begin,
+                                           size_t end,
+                                           size_t noVisibleSamples)
+{
+    if (maxIntensity < _mavenParameters->minGroupIntensity){
         return true;
     }
-    if (group->maxSignalBaselineRatio < _mavenParameters->minSignalBaseLineRatio) {
+    if (maxSignalBaselineRatio < _mavenParameters->minSignalBaseLineRatio) {
         return true;
     }
     if (_mavenParameters->clsf->hasModel() && 
-        group->maxQuality < _mavenParameters->minQuality) {
+        maxQuality < _mavenParameters->minQuality) {
             return true;
     }
-    if (group->maxIntensity < group->blankMax * _mavenParameters->minSignalBlankRatio){
+    if (maxIntensity < blankMax * _mavenParameters->minSignalBlankRatio){
         return true;
     }
-    vector<Peak> peaks = group->getPeaks();
-    int peaksAboveMinIntensity = 0;
-    int peaksAboveBaselineRatio = 0;
-    int peaksAboveBlankRatio = 0;
-    int peaksAboveMinQuality = 0;
-    for (int i = 0; i < peaks.size(); i++) {
-        if (peaks[i].peakIntensity > _mavenParameters->minGroupIntensity) {
-            peaksAboveMinIntensity++;
-        }
-        if (peaks[i].signalBaselineRatio > _mavenParameters->minSignalBaseLineRatio) {
-            peaksAboveBaselineRatio++;
-        }
-        if (peaks[i].peakIntensity > group->blankMax * _mavenParameters->minSignalBlankRatio){
-            peaksAboveBlankRatio++;
-        }
-        if (peaks[i].quality > _mavenParameters->minQuality) {
-            peaksAboveMinQuality++;
-        }
-    }
-    int noVisibleSamples = _mavenParameters->getVisibleSamples().size();
+
+    float minBlankIntensity = blankMax * _mavenParameters->minSignalBlankRatio;
+    size_t peaksAboveMinIntensity = PeakTable::countAbove(
+        peaks.peakIntensity, _mavenParameters->minGroupIntensity, begin, end);
+    size_t peaksAboveBaselineRatio = PeakTable::countAbove(
+        peaks.signalBaselineRatio,
+        _mavenParameters->minSignalBaseLineRatio,
+        begin,
+        end);
+    size_t peaksAboveBlankRatio = PeakTable::countAbove(
+        peaks.peakIntensity, minBlankIntensity, begin, end);
+    size_t peaksAboveMinQuality = PeakTable::countAbove(
+        peaks.quality, _mavenParameters->minQuality, begin, end);
+
     if ((1.0*peaksAboveMinIntensity/noVisibleSamples) * 100 < _mavenParameters->quantileIntensity) {
         return true;
     }
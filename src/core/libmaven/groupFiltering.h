@@ -6,6 +6,7 @@
 
 class MavenParameters;
 class PeakGroup;
+class PeakTable;
 class mzSlice;
 
 using namespace std;
@@ -34,6 +35,20 @@ class GroupFiltering
 
     void filter(vector<PeakGroup> &peakgroups);
 
+	/**
+	 * @brief Evaluate MS1 filters for a batch of groups in a single pass.
+	 * @details Group statistics (and peak quality, if a classifier model
+	 * is loaded) are computed for every group first. All threshold and
+	 * quantile predicates are then evaluated over columns of group- and
+	 * peak-level values gathered from the whole batch. Groups that pass are
+	 * ranked and, if a slice was given, have its compound and SRM ID
+	 * assigned. Since groups are passed by pointer, the batch can span
+	 * groups from many slices.
+	 * @param peakgroups Pointers to the groups to be filtered.
+	 * @return Mask with true for every group that should be kept.
+	 */
+	vector<bool> ms1KeepMask(const vector<PeakGroup*> &peakgroups);
+
 		bool filterByMS1(PeakGroup &peakgroup);
 
 		bool filterByMS2(PeakGroup& peakgroup);
@@ -50,6 +65,34 @@ class GroupFiltering
 		mzSlice *_slice;
     MavenParameters *_mavenParameters;
 
+	/**
+	 * @brief Returns true if a group does not satisfy the minimum share of
+	 * peaks above the user thresholds (or its maxima are below them).
+	 * @param maxIntensity Group's maximum peak intensity.
+	 * @param maxSignalBaselineRatio Group's maximum peak S/N.
+	 * @param maxQuality Group's maximum peak quality.
+	 * @param blankMax Group's maximum blank intensity.
+	 * @param peaks Peak table containing the group's peaks.
+	 * @param begin First row of the group's peaks in the table.
+	 * @param end One past the last row of the group's peaks in the table.
+	 * @param noVisibleSamples Number of visible samples.
+	 */
+	bool _failsQuantileFilters(float maxIntensity,
+	                           float maxSignalBaselineRatio,
+	                           float maxQuality,
+	                           float blankMax,
+	                           const PeakTable &peaks,
+	                           size_t begin,
+	                           size_t end,
+	                           size_t noVisibleSamples);
+
+	/**
+	 * @brief Assign slice compound to the group and compute its rank.
+	 * @return True if the group has to be rejected because it lies outside
+	 * the compound's RT window.
+	 */
+	bool _rankGroup(PeakGroup &peakgroup);
+
 };
 
 #endif //GROUPFILTERING_H
@@ -3,6 +3,7 @@
 #include "constants.h"
 #include "EIC.h"
 #include "isotopeDetection.h"
+#include "isotopeDistribution.h"
 #include "masscutofftype.h"
 #include "mavenparameters.h"
 #include "mzSample.h"
@@ -63,54 +64,90 @@ map<string, PeakGroup> IsotopeDetection::getIsotopes(PeakGroup* parentgroup, vec
     //iterate over samples to find properties for parent's isotopes.
     map<string, PeakGroup> isotopes;
 
+    // find nearest peak as long as it is within RT window
+    float maxRtDiff=_mavenParameters->maxIsotopeScanDiff * _mavenParameters->avgScanTime;
+    //why are we even doing this calculation, why not have the parameter be in units of RT?
+
     for (unsigned int s = 0; s < _mavenParameters->samples.size(); s++) {
         mzSample* sample = _mavenParameters->samples[s];
+
+        // isotopes can only be found in samples where the parent has a peak
+        Peak* parentPeak = parentgroup->getPeak(sample);
+        if (!parentPeak)
+            continue;
+
+        float rtmin = parentPeak->rtmin;
+        float rtmax = parentPeak->rtmax;
+        float parentPeakIntensity = parentPeak->peakIntensity;
+        Scan* scan = parentPeak->getScan();
+
+        // isotopologues that pass the intensity checks, along with the RT
+        // at which they were observed and their m/z windows
+        vector<unsigned int> candidates;
+        vector<float> candidateRts;
+        vector<pair<float, float>> mzRanges;
         for (unsigned int k = 0; k < masslist.size(); k++) {
             //			if (stopped())
             //				break; TODO: stop
             Isotope& x = masslist[k];
-            string isotopeName = x.name;
             double isotopeMass = x.mass;
-            double expectedAbundance = x.abundance;
 
             float mzmin = isotopeMass -_mavenParameters->compoundMassCutoffWindow->massCutoffValue(isotopeMass);
             float mzmax = isotopeMass +_mavenParameters->compoundMassCutoffWindow->massCutoffValue(isotopeMass);
 
-            float rt = parentgroup->medianRt();
-            float rtmin = parentgroup->minRt;
-            float rtmax = parentgroup->maxRt;
-
-            Peak* parentPeak = parentgroup->getPeak(sample);
-            if (parentPeak) {
-                rt = parentPeak->rt;
-                rtmin = parentPeak->rtmin;
-                rtmax = parentPeak->rtmax;
-            }
-
-            float isotopePeakIntensity = 0;
-            float parentPeakIntensity = 0;
-
-            if (parentPeak) {
-                parentPeakIntensity = parentPeak->peakIntensity;
-                Scan* scan = parentPeak->getScan();
-                std::pair<float, float> isotope = getIntensity(scan, mzmin, mzmax);
-                isotopePeakIntensity = isotope.first;
-                rt = isotope.second;
-            }
+            std::pair<float, float> isotope = getIntensity(scan, mzmin, mzmax);
+            float isotopePeakIntensity = isotope.first;
+            float rt = isotope.second;
 
             if (isotopePeakIntensity == 0 || rt == 0) continue;
 
             if (filterIsotope(x, isotopePeakIntensity, parentPeakIntensity, sample, parentgroup))
                 continue;
 
-            vector<Peak> allPeaks;
+            candidates.push_back(k);
+            candidateRts.push_back(rt);
+            mzRanges.push_back(make_pair(mzmin, mzmax));
+        }
+
+        if (candidates.empty())
+            continue;
+
+        // Isotope peaks are only accepted within maxRtDiff of the parent, so
+        // there is no need to look for them over the entire run. The window
+        // is padded by the parent's peak width, so that isotope peaks are
+        // not truncated, and by the baseline smoothing window, so that
+        // their baselines can still be estimated.
+        float margin = (rtmax - rtmin)
+                       + _mavenParameters->baseline_smoothingWindow
+                             * _mavenParameters->avgScanTime;
+        float windowMin = rtmin;
+        float windowMax = rtmax;
+        for (float rt : candidateRts) {
+            windowMin = min(windowMin, rt - maxRtDiff);
+            windowMax = max(windowMax, rt + maxRtDiff);
+        }
+
+        // pull all isotopologue EICs with a single sweep over the scans
+        vector<EIC*> eics = sample->getEICs(mzRanges,
+                                            windowMin - margin,
+                                            windowMax + margin,
+                                            1,
+                                            _mavenParameters->eicType,
+                                            _mavenParameters->filterline);
+        //actually mslevel should probably be deepest MS level?
+        //TODO: decide how isotope children should even work in MS mode
+
+        for (unsigned int c = 0; c < candidates.size(); c++) {
+            Isotope& x = masslist[candidates[c]];
+            string isotopeName = x.name;
+            double isotopeMass = x.mass;
+            double expectedAbundance = x.abundance;
+            float rt = candidateRts[c];
+            EIC* eic = eics[c];
 
-            EIC * eic = sample->getEIC(mzmin, mzmax, sample->minRt,sample->maxRt, 1, _mavenParameters->eicType,
-                                        _mavenParameters->filterline);
-            //actually last parameter should probably be deepest MS level?
-            //TODO: decide how isotope children should even work in MS mode
+            vector<Peak> allPeaks;
 
-            // smooth fond eic TODO: null check for found
+            // smooth fond eic
             eic->setSmootherType(
                     (EIC::SmootherType)
                     _mavenParameters->eic_smoothingAlgorithm);
@@ -118,8 +155,6 @@ map<string, PeakGroup> IsotopeDetection::getIsotopes(PeakGroup* parentgroup, vec
             eic->setBaselineDropTopX(_mavenParameters->baseline_dropTopX);
             eic->setFilterSignalBaselineDiff(_mavenParameters->isotopicMinSignalBaselineDifference);
             eic->getPeakPositions(_mavenParameters->eic_smoothingWindow);
-            //TODO: this needs be optimized to not bother finding peaks outside of
-            //maxIsotopeScanDiff window
             allPeaks = eic->peaks;
 
             //Set peak quality
@@ -130,13 +165,12 @@ map<string, PeakGroup> IsotopeDetection::getIsotopes(PeakGroup* parentgroup, vec
 
             //filter isotopic peaks
             bool isIsotope = true;
-			PeakFiltering peakFiltering(_mavenParameters, isIsotope);
-            peakFiltering.filter(allPeaks);                               
+            PeakFiltering peakFiltering(_mavenParameters, isIsotope);
+            peakFiltering.filter(allPeaks);
 
             delete(eic);
-            // find nearest peak as long as it is within RT window
-            float maxRtDiff=_mavenParameters->maxIsotopeScanDiff * _mavenParameters->avgScanTime;
-            //why are we even doing this calculation, why not have the parameter be in units of RT?
+            eics[c] = NULL;
+
             Peak* nearestPeak = NULL;
             float d = FLT_MAX;
             for (unsigned int i = 0; i < allPeaks.size(); i++) {
@@ -183,7 +217,7 @@ bool IsotopeDetection::filterIsotope(Isotope x, float isotopePeakIntensity, floa
             || (x.H2 > 0 && _D2Flag == false) //if isotope is not D2 Labeled
         )
     {
-        float expectedAbundance = x.abundance;
+        float expectedAbundance = naturalAbundance(x, parentGroup);
         if (expectedAbundance < 1e-8)
             return true;
         if (expectedAbundance * parentPeakIntensity < 1) //TODO: In practice this is probably fine but in general I don't like these types of intensity checks -- the actual absolute value depends on the type of instrument, etc
@@ -228,6 +262,30 @@ bool IsotopeDetection::filterIsotope(Isotope x, float isotopePeakIntensity, floa
     return false;
 }
 
+double IsotopeDetection::naturalAbundance(const Isotope& x, PeakGroup* parentGroup)
+{
+    if (parentGroup == NULL
+        || parentGroup->compound == NULL
+        || parentGroup->compound->formula.empty())
+        return x.abundance;
+
+    string formula = parentGroup->compound->formula;
+    int charge = _mavenParameters->getCharge(parentGroup->compound);
+    float mzmin = x.mass - _mavenParameters->compoundMassCutoffWindow->massCutoffValue(x.mass);
+    float mzmax = x.mass + _mavenParameters->compoundMassCutoffWindow->massCutoffValue(x.mass);
+
+    IsotopeDistribution isotopeDistribution;
+    double abundance = 0;
+    for (const IsotopePeak& peak : isotopeDistribution.fineStructure(formula, charge)) {
+        if (peak.mass >= mzmin && peak.mass <= mzmax)
+            abundance += peak.abundance;
+    }
+
+    if (abundance == 0)
+        return x.abundance;
+    return abundance;
+}
+
 std::pair<float, float> IsotopeDetection::getIntensity(Scan* scan, float mzmin, float mzmax)
 {
     float highestIntensity = 0;
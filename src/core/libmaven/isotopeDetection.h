@@ -50,6 +50,16 @@ class IsotopeDetection
 	IsotopeDetectionType _isoType;
 
 	void addIsotopes(PeakGroup *parentgroup, map<string, PeakGroup> isotopes);
+
+	/**
+	 * @brief natural abundance expected in the m/z window of an isotope
+	 * @details sums the isotopic fine structure of the parent's formula
+	 * within the mass cutoff of the isotope, so that heavy isotopes of
+	 * elements that are not labelled (O17, O18, S33, ...) are accounted for.
+	 * Falls back to the isotope's own abundance if the parent has no formula
+	 * or none of its fine structure falls within the window.
+	 **/
+	double naturalAbundance(const Isotope& x, PeakGroup* parentGroup);
 	void childStatistics(PeakGroup* parentgroup, PeakGroup &child, string isotopeName);
 	bool filterLabel(string isotopeName);
 	void addChild(PeakGroup *parentgroup, PeakGroup &child, string isotopeName);
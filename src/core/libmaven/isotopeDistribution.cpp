@@ -0,0 +1,155 @@
+#include "isotopeDistribution.h"
+#include "mzMassCalculator.h"
+
+namespace {
+    bool compMass(const IsotopePeak& a, const IsotopePeak& b)
+    {
+        return a.mass < b.mass;
+    }
+
+    bool compShiftMass(const IsotopePeak& a, const IsotopePeak& b)
+    {
+        if (a.shift != b.shift)
+            return a.shift < b.shift;
+        return a.mass < b.mass;
+    }
+}
+
+IsotopeDistribution::IsotopeDistribution(double abundanceThreshold,
+                                         double resolution)
+{
+    _abundanceThreshold = abundanceThreshold;
+    _resolution = resolution;
+}
+
+vector<IsotopePeak> IsotopeDistribution::coarseStructure(const string& formula,
+                                                         int charge) const
+{
+    return _distribution(formula, charge, true);
+}
+
+vector<IsotopePeak> IsotopeDistribution::fineStructure(const string& formula,
+                                                       int charge) const
+{
+    return _distribution(formula, charge, false);
+}
+
+vector<IsotopePeak> IsotopeDistribution::_distribution(const string& formula,
+                                                       int charge,
+                                                       bool coarse) const
+{
+    map<string, int> atoms = MassCalculator::getComposition(formula);
+
+    // start from an empty molecule
+    vector<IsotopePeak> distribution(1, IsotopePeak{0.0, 1.0, 0});
+    for (const auto& atom : atoms) {
+        if (atom.second <= 0)
+            continue;
+        vector<IsotopePeak> element = _elementDistribution(atom.first,
+                                                           atom.second,
+                                                           coarse);
+        distribution = _convolve(distribution, element, coarse);
+    }
+
+    for (auto& peak : distribution)
+        peak.mass = MassCalculator::adjustMass(peak.mass, charge);
+    sort(distribution.begin(), distribution.end(), compMass);
+    return distribution;
+}
+
+vector<IsotopePeak> IsotopeDistribution::_elementDistribution(
+    const string& element,
+    int count,
+    bool coarse) const
+{
+    // single atom pattern, with shifts relative to the most abundant isotope
+    vector<pair<double, double>> isotopes =
+        MassCalculator::getElementIsotopes(element);
+    double referenceMass = max_element(
+        isotopes.begin(),
+        isotopes.end(),
+        [](const pair<double, double>& a, const pair<double, double>& b) {
+            return a.second < b.second;
+        })->first;
+    vector<IsotopePeak> atom;
+    for (const auto& isotope : isotopes) {
+        int shift = static_cast<int>(round(isotope.first - referenceMass));
+        atom.push_back(IsotopePeak{isotope.first, isotope.second, shift});
+    }
+
+    if (atom.size() == 1) {
+        atom[0].mass *= count;
+        return atom;
+    }
+
+    // raise the single atom pattern to the power of count by squaring
+    vector<IsotopePeak> result(1, IsotopePeak{0.0, 1.0, 0});
+    vector<IsotopePeak> power = atom;
+    while (count > 0) {
+        if (count & 1)
+            result = _convolve(result, power, coarse);
+        count >>= 1;
+        if (count > 0)
+            power = _convolve(power, power, coarse);
+    }
+    return result;
+}
+
+vector<IsotopePeak> IsotopeDistribution::_convolve(
+    const vector<IsotopePeak>& a,
+    const vector<IsotopePeak>& b,
+    bool coarse) const
+{
+    vector<IsotopePeak> product;
+    product.reserve(a.size() * b.size());
+    for (const auto& x : a) {
+        for (const auto& y : b) {
+            product.push_back(IsotopePeak{x.mass + y.mass,
+                                          x.abundance * y.abundance,
+                                          x.shift + y.shift});
+        }
+    }
+    _mergeAndPrune(product, coarse);
+    return product;
+}
+
+void IsotopeDistribution::_mergeAndPrune(vector<IsotopePeak>& peaks,
+                                         bool coarse) const
+{
+    if (peaks.empty())
+        return;
+
+    sort(peaks.begin(), peaks.end(), compShiftMass);
+
+    // merge in place, keeping abundance-weighted masses; coarse peaks are
+    // merged by nominal mass, fine peaks only if they are within resolution
+    size_t merged = 0;
+    double weightedMass = peaks[0].mass * peaks[0].abundance;
+    for (size_t i = 1; i < peaks.size(); i++) {
+        IsotopePeak& last = peaks[merged];
+        const IsotopePeak& peak = peaks[i];
+        bool sameNominalMass = peak.shift == last.shift;
+        if (sameNominalMass
+            && (coarse || peak.mass - last.mass < _resolution)) {
+            weightedMass += peak.mass * peak.abundance;
+            last.abundance += peak.abundance;
+            last.mass = weightedMass / last.abundance;
+            continue;
+        }
+        peaks[++merged] = peak;
+        weightedMass = peak.mass * peak.abundance;
+    }
+    peaks.resize(merged + 1);
+
+    double maxAbundance = 0;
+    for (const auto& peak : peaks)
+        maxAbundance = max(maxAbundance, peak.abundance);
+
+    double minAbundance = maxAbundance * _abundanceThreshold;
+    peaks.erase(remove_if(peaks.begin(),
+                          peaks.end(),
+                          [minAbundance](const IsotopePeak& peak) {
+                              return peak.abundance < minAbundance;
+                          }),
+                peaks.end());
+}
@@ -0,0 +1,117 @@
+#ifndef ISOTOPEDISTRIBUTION_H
+#define ISOTOPEDISTRIBUTION_H
+
+#include "standardincludes.h"
+
+using namespace std;
+
+/**
+ * @brief A single peak of an isotope distribution.
+ */
+struct IsotopePeak
+{
+    /**
+     * @brief Abundance-weighted mass (or m/z, if charged) of the peak.
+     */
+    double mass;
+
+    /**
+     * @brief Probability of the peak, i.e. its share of the whole
+     * distribution.
+     */
+    double abundance;
+
+    /**
+     * @brief Nominal mass shift (M+0, M+1, ...) from the isotopologue made of
+     * the most abundant isotope of every element. Shifts are negative for
+     * isotopologues with a lighter, less abundant isotope, as with 54Fe in
+     * iron or 74Se to 78Se in selenium.
+     */
+    int shift;
+};
+
+/**
+ * @brief Generates natural isotope distributions of chemical formulae.
+ *
+ * @details The distribution of each element is obtained by raising its
+ * single atom pattern to the power of the atom count using repeated
+ * squaring, and element distributions are then convolved together. After
+ * every convolution, peaks that cannot be resolved are merged and peaks less
+ * abundant than a threshold (relative to the most abundant peak) are
+ * pruned, which keeps the distributions small even for lipids and peptides.
+ *
+ * Two kinds of distributions can be generated: the coarse distribution,
+ * where all isotopologues with the same nominal mass are aggregated into a
+ * single peak, and the fine structure, where only isotopologues within the
+ * given resolution of each other are merged.
+ *
+ * Isotope masses and abundances are those of MassCalculator, so the
+ * monoisotopic peak is at the mass MassCalculator computes for the formula.
+ * Elements without isotope data are treated as monoisotopic.
+ */
+class IsotopeDistribution
+{
+  public:
+    /**
+     * @brief Constructor of class IsotopeDistribution.
+     * @param abundanceThreshold Peaks less abundant than this fraction of
+     * the most abundant peak are discarded.
+     * @param resolution Fine structure peaks closer than this (in Da) are
+     * merged.
+     */
+    IsotopeDistribution(double abundanceThreshold = 1e-6,
+                        double resolution = 1e-4);
+
+    /**
+     * @brief Isotope distribution aggregated by nominal mass.
+     * @param formula Neutral formula of the molecule.
+     * @param charge Charge of the ion. Masses are adjusted to m/z the same
+     * way as MassCalculator::computeMass does.
+     * @return Peaks sorted by mass.
+     */
+    vector<IsotopePeak> coarseStructure(const string& formula,
+                                        int charge = 0) const;
+
+    /**
+     * @brief Isotopic fine structure.
+     * @param formula Neutral formula of the molecule.
+     * @param charge Charge of the ion. Masses are adjusted to m/z the same
+     * way as MassCalculator::computeMass does.
+     * @return Peaks sorted by mass.
+     */
+    vector<IsotopePeak> fineStructure(const string& formula,
+                                      int charge = 0) const;
+
+  private:
+    double _abundanceThreshold;
+    double _resolution;
+
+    /**
+     * @brief Compute the distribution of a whole formula.
+     */
+    vector<IsotopePeak> _distribution(const string& formula,
+                                      int charge,
+                                      bool coarse) const;
+
+    /**
+     * @brief Compute the distribution of a number of atoms of an element.
+     */
+    vector<IsotopePeak> _elementDistribution(const string& element,
+                                             int count,
+                                             bool coarse) const;
+
+    /**
+     * @brief Convolve two distributions, merging and pruning the result.
+     */
+    vector<IsotopePeak> _convolve(const vector<IsotopePeak>& a,
+                                  const vector<IsotopePeak>& b,
+                                  bool coarse) const;
+
+    /**
+     * @brief Merge peaks that cannot be told apart and prune those below
+     * the abundance threshold. Peaks are sorted in place by mass.
+     */
+    void _mergeAndPrune(vector<IsotopePeak>& peaks, bool coarse) const;
+};
+
+#endif // ISOTOPEDISTRIBUTION_H
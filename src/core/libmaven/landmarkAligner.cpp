@@ -0,0 +1,365 @@
+#include "landmarkAligner.h"
+#include "MersenneTwister.h"
+#include "mzSample.h"
+#include "Scan.h"
+
+namespace {
+    // candidate apexes taken from every scan
+    const unsigned int ionsPerScan = 10;
+
+    // scans on either side of an apex that are checked for its shape
+    const int halfWindow = 8;
+
+    // fewer pairs than these are not trusted to describe a warp
+    const unsigned int minMatches = 10;
+
+    // fraction of pairs, but at least minNeighbours, used by every LOESS
+    // estimate
+    const float loessSpan = 0.3;
+    const unsigned int minNeighbours = 5;
+
+    const int ransacIterations = 200;
+
+    struct Candidate
+    {
+        int scan;
+        float mz;
+        float intensity;
+    };
+
+    /**
+     * @brief Intensity of the most intense peak of a scan within the given
+     * m/z range, or zero if there is none.
+     */
+    float maxIntensity(Scan* scan, float mzmin, float mzmax)
+    {
+        auto first = lower_bound(scan->mz.begin(), scan->mz.end(), mzmin);
+        float intensity = 0;
+        for (auto it = first; it != scan->mz.end() && *it <= mzmax; it++)
+            intensity = max(intensity, scan->intensity[it - scan->mz.begin()]);
+        return intensity;
+    }
+
+    /**
+     * @brief Index of the landmark closest in rt to the given one among
+     * landmarks within m/z and rt tolerance, or -1 if there is none.
+     * @param sorted Indices of landmarks ordered by m/z.
+     */
+    int closestLandmark(const Landmark& landmark,
+                        const vector<Landmark>& landmarks,
+                        const vector<int>& sorted,
+                        float ppm,
+                        float maxRtShift)
+    {
+        float tolerance = landmark.mz * ppm / 1e6;
+        auto first = lower_bound(sorted.begin(),
+                                 sorted.end(),
+                                 landmark.mz - tolerance,
+                                 [&landmarks](int i, float mz) {
+                                     return landmarks[i].mz < mz;
+                                 });
+
+        int closest = -1;
+        float closestDistance = maxRtShift;
+        for (auto it = first; it != sorted.end(); it++) {
+            const Landmark& other = landmarks[*it];
+            if (other.mz > landmark.mz + tolerance)
+                break;
+            float distance = fabs(other.rt - landmark.rt);
+            if (distance <= closestDistance) {
+                closest = *it;
+                closestDistance = distance;
+            }
+        }
+        return closest;
+    }
+
+    vector<int> sortedByMz(const vector<Landmark>& landmarks)
+    {
+        vector<int> sorted(landmarks.size());
+        for (unsigned int i = 0; i < sorted.size(); i++)
+            sorted[i] = i;
+        sort(sorted.begin(), sorted.end(), [&landmarks](int a, int b) {
+            return landmarks[a].mz < landmarks[b].mz;
+        });
+        return sorted;
+    }
+}
+
+LandmarkAligner::LandmarkAligner(int maxLandmarks,
+                                 float ppm,
+                                 float maxRtShift,
+                                 float rtTolerance)
+{
+    _maxLandmarks = maxLandmarks;
+    _ppm = ppm;
+    _maxRtShift = maxRtShift;
+    _rtTolerance = rtTolerance;
+}
+
+string LandmarkAligner::parameters() const
+{
+    stringstream stream;
+    stream << "landmarks"
+           << " maxLandmarks=" << _maxLandmarks
+           << " ppm=" << _ppm
+           << " maxRtShift=" << _maxRtShift
+           << " rtTolerance=" << _rtTolerance;
+    return stream.str();
+}
+
+vector<Landmark> LandmarkAligner::findLandmarks(mzSample* sample) const
+{
+    vector<Scan*> scans;
+    for (auto scan : sample->scans) {
+        if (scan->mslevel == 1)
+            scans.push_back(scan);
+    }
+
+    vector<Candidate> candidates;
+    vector<unsigned int> order;
+    for (unsigned int i = 0; i < scans.size(); i++) {
+        Scan* scan = scans[i];
+        order.resize(scan->nobs());
+        for (unsigned int k = 0; k < order.size(); k++)
+            order[k] = k;
+        unsigned int count = min(ionsPerScan, scan->nobs());
+        partial_sort(order.begin(),
+                     order.begin() + count,
+                     order.end(),
+                     [scan](unsigned int a, unsigned int b) {
+                         return scan->intensity[a] > scan->intensity[b];
+                     });
+        for (unsigned int k = 0; k < count; k++) {
+            candidates.push_back(Candidate{static_cast<int>(i),
+                                           scan->mz[order[k]],
+                                           scan->intensity[order[k]]});
+        }
+    }
+    stable_sort(candidates.begin(),
+                candidates.end(),
+                [](const Candidate& a, const Candidate& b) {
+                    return a.intensity > b.intensity;
+                });
+
+    vector<Landmark> landmarks;
+    vector<float> chromatogram(2 * halfWindow + 1);
+    for (const auto& candidate : candidates) {
+        if (landmarks.size() >= static_cast<size_t>(_maxLandmarks))
+            break;
+        int first = candidate.scan - halfWindow;
+        int last = candidate.scan + halfWindow;
+        if (first < 0 || last >= static_cast<int>(scans.size()))
+            continue;
+
+        // skip ions belonging to an existing landmark
+        float mzmin = candidate.mz * (1 - _ppm / 1e6);
+        float mzmax = candidate.mz * (1 + _ppm / 1e6);
+        float rtmin = scans[first]->rt;
+        float rtmax = scans[last]->rt;
+        bool taken = false;
+        for (const auto& landmark : landmarks) {
+            if (landmark.mz >= mzmin && landmark.mz <= mzmax
+                && landmark.rt >= rtmin && landmark.rt <= rtmax) {
+                taken = true;
+                break;
+            }
+        }
+        if (taken)
+            continue;
+
+        for (int j = first; j <= last; j++)
+            chromatogram[j - first] = maxIntensity(scans[j], mzmin, mzmax);
+
+        // the apex has to be in the middle, observed in the adjacent scans,
+        // and fall below half its height on both sides
+        float apex = chromatogram[halfWindow];
+        if (*max_element(chromatogram.begin(), chromatogram.end()) > apex
+            || chromatogram[halfWindow - 1] == 0
+            || chromatogram[halfWindow + 1] == 0)
+            continue;
+        int left = halfWindow;
+        while (left > 0 && chromatogram[left - 1] >= apex / 2)
+            left--;
+        int right = halfWindow;
+        while (right < 2 * halfWindow && chromatogram[right + 1] >= apex / 2)
+            right++;
+        if (left == 0 || right == 2 * halfWindow)
+            continue;
+
+        // retention time of the apex, weighted over the top half of the peak
+        double weightedRt = 0;
+        double totalIntensity = 0;
+        for (int j = left; j <= right; j++) {
+            weightedRt += chromatogram[j] * scans[first + j]->rt;
+            totalIntensity += chromatogram[j];
+        }
+        landmarks.push_back(Landmark{candidate.mz,
+                                     static_cast<float>(weightedRt
+                                                        / totalIntensity),
+                                     apex});
+    }
+    return landmarks;
+}
+
+vector<pair<float, float>> LandmarkAligner::matchLandmarks(
+    const vector<Landmark>& landmarks,
+    const vector<Landmark>& refLandmarks) const
+{
+    vector<int> sorted = sortedByMz(landmarks);
+    vector<int> refSorted = sortedByMz(refLandmarks);
+
+    vector<pair<float, float>> matches;
+    for (unsigned int i = 0; i < landmarks.size(); i++) {
+        int j = closestLandmark(landmarks[i],
+                                refLandmarks,
+                                refSorted,
+                                _ppm,
+                                _maxRtShift);
+        if (j < 0)
+            continue;
+        if (closestLandmark(refLandmarks[j],
+                            landmarks,
+                            sorted,
+                            _ppm,
+                            _maxRtShift) != static_cast<int>(i))
+            continue;
+        matches.push_back(make_pair(landmarks[i].rt, refLandmarks[j].rt));
+    }
+    sort(matches.begin(), matches.end());
+    return matches;
+}
+
+vector<pair<float, float>> LandmarkAligner::_ransacInliers(
+    const vector<pair<float, float>>& matches,
+    float tolerance) const
+{
+    // a fixed seed keeps alignments reproducible
+    MTRand mtRand(1);
+    float bestIntercept = 0;
+    float bestSlope = 0;
+    unsigned int bestCount = 0;
+    for (int iteration = 0; iteration < ransacIterations; iteration++) {
+        const auto& a = matches[mtRand.randInt(matches.size() - 1)];
+        const auto& b = matches[mtRand.randInt(matches.size() - 1)];
+        if (fabs(b.first - a.first) < _rtTolerance)
+            continue;
+
+        // samples are not expected to run at very different speeds
+        float slope = (b.second - a.second) / (b.first - a.first);
+        if (slope < 0.5f || slope > 2.0f)
+            continue;
+        float intercept = a.second - slope * a.first;
+
+        unsigned int count = 0;
+        for (const auto& match : matches) {
+            if (fabs(match.second - intercept - slope * match.first)
+                <= tolerance)
+                count++;
+        }
+        if (count > bestCount) {
+            bestCount = count;
+            bestSlope = slope;
+            bestIntercept = intercept;
+        }
+    }
+
+    vector<pair<float, float>> inliers;
+    if (bestCount == 0)
+        return inliers;
+    for (const auto& match : matches) {
+        if (fabs(match.second - bestIntercept - bestSlope * match.first)
+            <= tolerance)
+            inliers.push_back(match);
+    }
+    return inliers;
+}
+
+float LandmarkAligner::_loess(const vector<pair<float, float>>& points,
+                              float rt)
+{
+    // nearest neighbours of rt form a contiguous range of points
+    size_t n = points.size();
+    size_t k = max(static_cast<size_t>(minNeighbours),
+                   static_cast<size_t>(loessSpan * n));
+    k = min(k, n);
+    size_t left = lower_bound(points.begin(),
+                              points.end(),
+                              make_pair(rt, -FLT_MAX))
+                  - points.begin();
+    size_t right = left;
+    while (right - left < k) {
+        if (left == 0) {
+            right++;
+        } else if (right == n) {
+            left--;
+        } else if (rt - points[left - 1].first
+                   <= points[right].first - rt) {
+            left--;
+        } else {
+            right++;
+        }
+    }
+
+    // tricube weighted linear fit of shifts, centred on rt
+    double maxDistance = max(rt - points[left].first,
+                             points[right - 1].first - rt) * 1.001;
+    double sw = 0, swx = 0, swy = 0, swxx = 0, swxy = 0;
+    for (size_t i = left; i < right; i++) {
+        double x = points[i].first - rt;
+        double y = points[i].second - points[i].first;
+        double w = 1;
+        if (maxDistance > 0) {
+            double d = fabs(x) / maxDistance;
+            w = pow(1 - d * d * d, 3);
+        }
+        sw += w;
+        swx += w * x;
+        swy += w * y;
+        swxx += w * x * x;
+        swxy += w * x * y;
+    }
+
+    double denominator = sw * swxx - swx * swx;
+    if (fabs(denominator) < 1e-12 * sw * sw)
+        return swy / sw;
+    double slope = (sw * swxy - swx * swy) / denominator;
+    return (swy - slope * swx) / sw;
+}
+
+vector<float> LandmarkAligner::fitWarp(
+    const vector<pair<float, float>>& matches,
+    const vector<float>& rts) const
+{
+    vector<float> warped;
+    if (matches.size() < minMatches)
+        return warped;
+
+    // discard wrongly paired landmarks against a straight line first, with
+    // some slack for drift that is not linear
+    vector<pair<float, float>> inliers = _ransacInliers(matches,
+                                                        3 * _rtTolerance);
+    if (inliers.size() < minMatches)
+        return warped;
+
+    vector<pair<float, float>> points;
+    for (const auto& inlier : inliers) {
+        float shift = inlier.second - inlier.first;
+        if (fabs(shift - _loess(inliers, inlier.first)) <= _rtTolerance)
+            points.push_back(inlier);
+    }
+    if (points.size() < minMatches)
+        return warped;
+
+    float minRt = points.front().first;
+    float maxRt = points.back().first;
+    warped.reserve(rts.size());
+    for (auto rt : rts) {
+        float clampedRt = min(max(rt, minRt), maxRt);
+        float warpedRt = rt + _loess(points, clampedRt);
+        if (!warped.empty())
+            warpedRt = max(warpedRt, warped.back());
+        warped.push_back(warpedRt);
+    }
+    return warped;
+}
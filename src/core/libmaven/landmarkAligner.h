@@ -0,0 +1,121 @@
+#ifndef LANDMARKALIGNER_H
+#define LANDMARKALIGNER_H
+
+#include "standardincludes.h"
+
+class mzSample;
+
+using namespace std;
+
+/**
+ * @brief An intense, well-shaped feature used as a retention time anchor.
+ */
+struct Landmark
+{
+    float mz;
+
+    /**
+     * @brief Retention time of the apex, interpolated between scans.
+     */
+    float rt;
+
+    float intensity;
+};
+
+/**
+ * @brief Finds a retention time warp for a sample by matching a few hundred
+ * landmark features against those of a reference sample.
+ *
+ * @details Unlike OBI-Warp, which compares full binned intensity matrices of
+ * two samples, this only looks at the most intense ions of every MS1 scan.
+ * Starting from the most intense of these, an ion becomes a landmark if its
+ * extracted chromatogram around the scan has its apex there and falls below
+ * half of the apex on both sides within a few scans; ions close to an
+ * existing landmark are skipped. Landmarks of a sample are then paired with
+ * the reference's if their m/z values are within tolerance and their
+ * retention times within the maximum expected shift, keeping only mutually
+ * closest pairs.
+ *
+ * The warp is fitted robustly in two steps. RANSAC finds the straight line
+ * supported by most pairs and discards pairs far from it, which removes
+ * landmarks paired with the wrong feature. The retention time differences of
+ * the remaining pairs are then smoothed with LOESS (locally weighted linear
+ * regression), so that the warp can follow non-linear drift. Pairs not
+ * agreeing with the smooth curve are dropped and the curve is fitted once
+ * more. Outside the range of matched landmarks the shift at the nearest end
+ * is kept.
+ *
+ * All methods are const and may be called concurrently for different
+ * samples.
+ */
+class LandmarkAligner
+{
+  public:
+    /**
+     * @brief Constructor of class LandmarkAligner.
+     * @param maxLandmarks Maximum number of landmarks picked per sample.
+     * @param ppm m/z tolerance for landmarks to be paired.
+     * @param maxRtShift Largest retention time difference, in minutes, of
+     * landmarks to be paired.
+     * @param rtTolerance Largest distance, in minutes, of a pair from the
+     * fitted warp for it to be kept.
+     */
+    LandmarkAligner(int maxLandmarks = 300,
+                    float ppm = 10,
+                    float maxRtShift = 1,
+                    float rtTolerance = 0.1);
+
+    /**
+     * @brief Pick landmarks among the MS1 scans of a sample.
+     * @return Landmarks, most intense first.
+     */
+    vector<Landmark> findLandmarks(mzSample* sample) const;
+
+    /**
+     * @brief Pair landmarks of a sample with those of the reference.
+     * @return Retention times of the pairs as (sample rt, reference rt),
+     * ordered by sample rt.
+     */
+    vector<pair<float, float>> matchLandmarks(
+        const vector<Landmark>& landmarks,
+        const vector<Landmark>& refLandmarks) const;
+
+    /**
+     * @brief Fit a warp through paired retention times.
+     * @param matches Pairs as returned by matchLandmarks.
+     * @param rts Retention times at which the warp is evaluated, in
+     * increasing order.
+     * @return Warped retention times, non-decreasing, of the same size as
+     * rts, or an empty vector if too few pairs agree on a warp.
+     */
+    vector<float> fitWarp(const vector<pair<float, float>>& matches,
+                          const vector<float>& rts) const;
+
+    /**
+     * @brief Description of the parameters, identifying alignments done
+     * with them.
+     */
+    string parameters() const;
+
+  private:
+    int _maxLandmarks;
+    float _ppm;
+    float _maxRtShift;
+    float _rtTolerance;
+
+    /**
+     * @brief Pairs lying within the given distance of the straight line
+     * supported by most pairs.
+     */
+    vector<pair<float, float>> _ransacInliers(
+        const vector<pair<float, float>>& matches,
+        float tolerance) const;
+
+    /**
+     * @brief LOESS estimate of the retention time shift at rt.
+     * @param points Pairs ordered by sample rt.
+     */
+    static float _loess(const vector<pair<float, float>>& points, float rt);
+};
+
+#endif // LANDMARKALIGNER_H
@@ -91,12 +91,19 @@ SOURCES = 	base64.cpp \
                 databases.cpp \
                 Peptide.cpp \
                 PolyAligner.cpp \
+                landmarkAligner.cpp \
+                alignmentCache.cpp \
                 jsonReports.cpp \
                 masscutofftype.cpp \
                 peakFiltering.cpp \
                 groupFiltering.cpp \
                 isotopeDetection.cpp \
+                isotopeDistribution.cpp \
+                spectralSearch.cpp \
+                spectraClustering.cpp \
                 datastructures/mzSlice.cpp \
+                datastructures/peakTable.cpp \
+                datastructures/memoryArena.cpp \
                 groupClassifier.cpp \
                 groupFeatures.cpp \
                 svmPredictor.cpp \
@@ -135,12 +142,19 @@ HEADERS += 	constants.h \
                 Peptide.hpp \
                 PeptideRecord.h \
                 PolyAligner.h \
+                landmarkAligner.h \
+                alignmentCache.h \
                 jsonReports.h \
                 masscutofftype.h \
                 peakFiltering.h \
                 groupFiltering.h \
                 isotopeDetection.h \
+                isotopeDistribution.h \
+                spectralSearch.h \
+                spectraClustering.h \
                 datastructures/mzSlice.h \
+                datastructures/peakTable.h \
+                datastructures/memoryArena.h \
                 settings.h \
                 groupClassifier.h \
                 groupFeatures.h \
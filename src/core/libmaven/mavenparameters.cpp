@@ -14,6 +14,7 @@ MavenParameters::MavenParameters(string settingsPath):lastUsedSettingsPath(setti
 
     clsf = NULL;
     alignSamplesFlag = false;
+    obiWarpMaxRtShift = 0;
         processAllSlices = false;
         pullIsotopesFlag = false;
         matchRtFlag = false;
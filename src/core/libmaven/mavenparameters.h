@@ -100,6 +100,19 @@ class MavenParameters
 
         bool writeCSVFlag;
         bool alignSamplesFlag;
+
+        /**
+         * @brief Directory where aligned retention times are cached, so that
+         * aligning the same samples again is skipped. Empty disables caching.
+         */
+        string alignmentCacheDir;
+
+        /**
+         * @brief Largest expected rt shift of a sample from the reference,
+         * in minutes. If positive, OBI-Warp only aligns within this shift;
+         * 0 aligns over the whole run.
+         */
+        float obiWarpMaxRtShift;
         bool keepFoundGroups;
         bool processAllSlices;
         bool pullIsotopesFlag;
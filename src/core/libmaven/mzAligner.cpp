@@ -1,12 +1,14 @@
 #include <QJsonArray>
 #include <QJsonValue>
 
+#include "alignmentCache.h"
 #include "mzAligner.h"
 #include "mzMassSlicer.h"
 #include "mzSample.h"
 #include "PolyAligner.h"
 #include "mzSample.h"
 #include "Compound.h"
+#include "landmarkAligner.h"
 #include "obiwarp.h"
 #include "mavenparameters.h"
 #include "Peak.h"
@@ -14,9 +16,111 @@
 
 mzSample* Aligner::refSample = nullptr;
 
+namespace {
+    string obiWarpParameters(const ObiParams* obiParams)
+    {
+        stringstream stream;
+        stream << "obiwarp"
+               << " score=" << obiParams->score
+               << " local=" << obiParams->local
+               << " factor_diag=" << obiParams->factor_diag
+               << " factor_gap=" << obiParams->factor_gap
+               << " gap_init=" << obiParams->gap_init
+               << " gap_extend=" << obiParams->gap_extend
+               << " init_penalty=" << obiParams->init_penalty
+               << " response=" << obiParams->response
+               << " nostdnrm=" << obiParams->nostdnrm
+               << " binSize=" << obiParams->binSize
+               << " maxRtShift=" << obiParams->maxRtShift;
+        return stream.str();
+    }
+
+    map<mzSample*, uint64_t> contentHashes(const vector<mzSample*>& samples)
+    {
+        vector<uint64_t> hashes(samples.size());
+        #pragma omp parallel for schedule(dynamic)
+        for (int i = 0; i < samples.size(); ++i)
+            hashes[i] = AlignmentCache::contentHash(samples[i]);
+
+        map<mzSample*, uint64_t> sampleHashes;
+        for (int i = 0; i < samples.size(); ++i)
+            sampleHashes[samples[i]] = hashes[i];
+        return sampleHashes;
+    }
+}
+
+AlignmentState::AlignmentState()
+{
+    _obiWarp = nullptr;
+}
+
+AlignmentState::~AlignmentState()
+{
+    delete _obiWarp;
+}
+
+void AlignmentState::clear()
+{
+    delete _obiWarp;
+    _obiWarp = nullptr;
+    _mzPoints.clear();
+    _obiWarpKey.clear();
+    _rts.clear();
+}
+
+ObiWarp* AlignmentState::obiWarp(const string& key) const
+{
+    if (_obiWarp == nullptr || _obiWarpKey != key)
+        return nullptr;
+    return _obiWarp;
+}
+
+void AlignmentState::setObiWarp(ObiWarp* obiWarp,
+                                const vector<float>& mzPoints,
+                                const string& key)
+{
+    if (obiWarp != _obiWarp)
+        delete _obiWarp;
+    _obiWarp = obiWarp;
+    _mzPoints = mzPoints;
+    _obiWarpKey = key;
+}
+
+bool AlignmentState::loadRts(uint64_t sampleHash,
+                             uint64_t referenceHash,
+                             const string& parameters,
+                             vector<float>& rts) const
+{
+    auto entry = _rts.find(_rtsKey(sampleHash, referenceHash, parameters));
+    if (entry == _rts.end())
+        return false;
+    rts = entry->second;
+    return true;
+}
+
+void AlignmentState::saveRts(uint64_t sampleHash,
+                             uint64_t referenceHash,
+                             const string& parameters,
+                             const vector<float>& rts)
+{
+    _rts[_rtsKey(sampleHash, referenceHash, parameters)] = rts;
+}
+
+string AlignmentState::_rtsKey(uint64_t sampleHash,
+                               uint64_t referenceHash,
+                               const string& parameters)
+{
+    return to_string(sampleHash)
+           + " "
+           + to_string(referenceHash)
+           + " "
+           + parameters;
+}
+
 Aligner::Aligner() {
        maxIterations=10;
        polynomialDegree=3;
+       _state = nullptr;
 }
 
 void Aligner::doAlignment(vector<PeakGroup*>& peakgroups)
@@ -119,14 +223,41 @@ double Aligner::checkFit() {
 	return sumR2;
 }
 
+vector<vector<pair<unsigned int, Peak*>>> Aligner::_peaksBySample()
+{
+    map<mzSample*, unsigned int> sampleIndex;
+    for (unsigned int s = 0; s < samples.size(); s++)
+        sampleIndex.insert(make_pair(samples[s], s));
+
+    vector<vector<pair<unsigned int, Peak*>>> samplePeaks(samples.size());
+    for (unsigned int j = 0; j < allgroups.size(); j++) {
+        for (auto& peak : allgroups[j]->peaks) {
+            auto itr = sampleIndex.find(peak.getSample());
+            if (itr == sampleIndex.end())
+                continue;
+            auto& peaks = samplePeaks[itr->second];
+            if (!peaks.empty() && peaks.back().first == j)
+                continue;
+            peaks.push_back(make_pair(j, &peak));
+        }
+    }
+    return samplePeaks;
+}
+
 void Aligner::PolyFit(int poly_align_degree) {
 
 	if (allgroups.size() < 2 ) return;
 	cerr << "Align: " << allgroups.size() << endl;
 
 	vector<double> allGroupsMeansRt  = groupMeanRt();
+	vector<vector<pair<unsigned int, Peak*>>> samplePeaks = _peaksBySample();
 
-	for (unsigned int s=0; s < samples.size(); s++ ) {
+	// samples are fitted independently and only touch their own scans and
+	// peaks; models are stored once all samples are done
+	vector<AlignmentStats*> sampleStats(samples.size(), nullptr);
+
+	#pragma omp parallel for schedule(dynamic)
+	for (int s=0; s < (int) samples.size(); s++ ) {
 			mzSample* sample = samples[s];
 			if (sample == NULL) continue;
 
@@ -135,10 +266,10 @@ void Aligner::PolyFit(int poly_align_degree) {
 			int n=0;
 
             map<int,int>duplicates;
-			for(unsigned int j=0; j < allgroups.size(); j++ ) {
-				Peak* p = allgroups[j]->getPeak(sample);
-				if (!p) continue;
-                if (!p || p->rt <= 0 || allGroupsMeansRt[j] <=0 ) continue;
+			for (auto& groupPeak : samplePeaks[s]) {
+				unsigned int j = groupPeak.first;
+				Peak* p = groupPeak.second;
+                if (p->rt <= 0 || allGroupsMeansRt[j] <=0 ) continue;
 
                 int intTime = (int) p->rt*100;
                 duplicates[intTime]++;
@@ -152,33 +283,44 @@ void Aligner::PolyFit(int poly_align_degree) {
 
 			PolyAligner polyAligner(subj,ref);
             AlignmentStats* stats = polyAligner.optimalPolynomial(1,poly_align_degree,10);
-
-			sampleDegree[sample] = stats->poly_align_degree;
-			sampleCoefficient[sample] = stats->getCoeffients();
+			sampleStats[s] = stats;
 
            if (stats->transformImproved()) {
 
-                bool failedTransformation=false;
-                for(unsigned int ii=0; ii < sample->scans.size(); ii++ ) {
-                    double newrt =  stats->predict(sample->scans[ii]->rt);
-                    if (std::isnan(newrt) || std::isinf(newrt))  failedTransformation = true;
-                    break;
+                vector<double> rts(sample->scans.size());
+                for(unsigned int ii=0; ii < sample->scans.size(); ii++ )
+                    rts[ii] = sample->scans[ii]->rt;
+                vector<double> newRts = stats->predict(rts);
+
+                bool failedTransformation = newRts.size() != rts.size();
+                for (auto newrt : newRts) {
+                    if (std::isnan(newrt) || std::isinf(newrt)) {
+                        failedTransformation = true;
+                        break;
+                    }
                 }
 
                 if (!failedTransformation) {
                     for(unsigned int ii=0; ii < sample->scans.size(); ii++ ) {
-                        sample->scans[ii]->rt = stats->predict(sample->scans[ii]->rt);
+                        sample->scans[ii]->rt = newRts[ii];
                     }
 
-                    for(unsigned int ii=0; ii < allgroups.size(); ii++ ) {
-                        Peak* p = allgroups[ii]->getPeak(sample);
-                        if (p)  p->rt = stats->predict(p->rt);
+                    for (auto& groupPeak : samplePeaks[s]) {
+                        Peak* p = groupPeak.second;
+                        p->rt = stats->predict(p->rt);
                     }
                 }
             } else 	{
                 cerr << "APPLYTING TRANSFORM FAILED! " << endl;
             }
     }
+
+	for (unsigned int s=0; s < samples.size(); s++ ) {
+		if (sampleStats[s] == nullptr) continue;
+		sampleDegree[samples[s]] = sampleStats[s]->poly_align_degree;
+		sampleCoefficient[samples[s]] = sampleStats[s]->getCoeffients();
+		delete sampleStats[s];
+	}
 }
 
 void Aligner::Fit(int ideg) {
@@ -202,6 +344,7 @@ void Aligner::Fit(int ideg) {
 	double* w = new double[maxdeg*maxdeg];
 
 	//vector<double> groupRt  = groupMeanRt();
+	vector<vector<pair<unsigned int, Peak*>>> samplePeaks = _peaksBySample();
 
 	for (unsigned int s=0; s < samples.size(); s++ ) {
 			mzSample* sample = samples[s];
@@ -210,9 +353,9 @@ void Aligner::Fit(int ideg) {
 
 			int n=0;
 			StatisticsVector<float>diff;
-			for(unsigned int j=0; j < allgroups.size(); j++ ) {
-				Peak* p = allgroups[j]->getPeak(sample);
-				if (!p) continue;
+			for (auto& groupPeak : samplePeaks[s]) {
+				unsigned int j = groupPeak.first;
+				Peak* p = groupPeak.second;
 				if (p->rt <= 0) continue;
                 //if (p->quality < 0.5 ) continue;
                 int intTime = (int) p->rt*100;
@@ -298,16 +441,14 @@ void Aligner::Fit(int ideg) {
                 }
             }
 
-            for(unsigned int ii=0; ii < allgroups.size(); ii++ ) {
-                Peak* p = allgroups[ii]->getPeak(sample);
-                if (p) {
-                    //float newrt = seval(n, p->rt, x, ref, b, c, d);
-                    double newrt = leasev(result, ideg, p->rt)-zeroOffset;
-                    if (!std::isnan(newrt) && !std::isinf(newrt)) { //nan check
-                        p->rt = newrt;
-                    } else {
-                        //cerr << "Polynomial transformed failed! (peak)" << p->rt << endl;
-                    }
+            for (auto& groupPeak : samplePeaks[s]) {
+                Peak* p = groupPeak.second;
+                //float newrt = seval(n, p->rt, x, ref, b, c, d);
+                double newrt = leasev(result, ideg, p->rt)-zeroOffset;
+                if (!std::isnan(newrt) && !std::isinf(newrt)) { //nan check
+                    p->rt = newrt;
+                } else {
+                    //cerr << "Polynomial transformed failed! (peak)" << p->rt << endl;
                 }
             }
 
@@ -330,11 +471,17 @@ bool Aligner::alignSampleRts(mzSample* sample,
                              vector<float> &mzPoints,
                              ObiWarp& obiWarp,
                              bool setAsReference,
-                             const MavenParameters* mp)
+                             const MavenParameters* mp,
+                             vector<AlignmentSegment>* segments)
 {
-    // we set the rt interval using the reference sample
+    // we set the rt interval using the reference sample; banded alignment
+    // scales with the band width rather than the number of scans, so it can
+    // use every scan (ObiWarp resamples by itself if it falls back to the
+    // full matrix)
     int rtBinSize = 1;
-    if (setAsReference && sample != nullptr) {
+    if (obiWarp.banded()) {
+        rtBinSize = 1;
+    } else if (setAsReference && sample != nullptr) {
         rtBinSize = mzUtils::approximateResamplingFactor(sample->ms1ScanCount(),
                                                          500);
     } else if (refSample != nullptr) {
@@ -342,30 +489,23 @@ bool Aligner::alignSampleRts(mzSample* sample,
                                                          500);
     }
 
+    // a single row-major rt x mz matrix, filled from each scan's peaks
     vector<float> rtPoints;
-    vector<vector<float> > mxn;
+    vector<float> mxn;
+    size_t mzCount = mzPoints.size();
 
     int intervalCounter = 0;
     for(auto scan: sample->scans) {
         if (mp->stop) return (true);
         if (scan->mslevel == 1 && (intervalCounter % rtBinSize == 0 || scan == sample->scans.back())) {
             rtPoints.push_back(scan->originalRt);
-            mxn.push_back(vector<float> (mzPoints.size()));
-        }
-        ++intervalCounter;
-    }
-
-    intervalCounter = 0;
-    int mxnCount = 0;
-    for(auto scan: sample->scans) {
-        if (scan->mslevel == 1 && (intervalCounter % rtBinSize == 0 || scan == sample->scans.back())) {
-            mxnCount++;
+            mxn.resize(rtPoints.size() * mzCount, 0.0f);
+            float* row = &mxn[(rtPoints.size() - 1) * mzCount];
             for(int i = 0; i <  scan->mz.size(); i++) {
-                if (mp->stop) return (true);
-                if (scan->mz.at(i) < mzPoints.front() || scan->mz.at(i) > mzPoints.back())
+                if (scan->mz[i] < mzPoints.front() || scan->mz[i] > mzPoints.back())
                     continue;
-                int index = upper_bound(mzPoints.begin(), mzPoints.end(), scan->mz.at(i)) - mzPoints.begin() -1;
-                mxn[mxnCount - 1][index] = max(mxn[mxnCount -1][index], scan->intensity.at(i));
+                int index = upper_bound(mzPoints.begin(), mzPoints.end(), scan->mz[i]) - mzPoints.begin() -1;
+                row[index] = max(row[index], scan->intensity[i]);
             }
         }
         ++intervalCounter;
@@ -373,32 +513,26 @@ bool Aligner::alignSampleRts(mzSample* sample,
 
     if (setAsReference) {
         if (mp->stop) return (true);
-        obiWarp.setReferenceData(rtPoints, mzPoints, mxn);
+        obiWarp.setReferenceData(rtPoints, mzPoints, std::move(mxn));
     }
     else {
-        vector<float> updatedRtPoints = obiWarp.align(rtPoints, mzPoints, mxn);
+        vector<float> updatedRtPoints = obiWarp.align(rtPoints, mzPoints, std::move(mxn));
         if (updatedRtPoints.empty())
             return(true);
 
         // perform segmented alignment
-        AlignmentSegment* lastSegment = nullptr;
+        AlignmentSegment seg = {0, 0, 0, 0};
         for (int i = 0; i < rtPoints.size(); ++i) {
-            auto originalRt = rtPoints.at(i);
-            auto updatedRt = updatedRtPoints.at(i);
-            AlignmentSegment* seg = new AlignmentSegment();
-            seg->sampleName = sample->sampleName;
-            seg->segStart = 0;
-            seg->segEnd = originalRt;
-            seg->newStart = 0;
-            seg->newEnd = updatedRt;
-
-            if (lastSegment and lastSegment->sampleName == seg->sampleName) {
-                seg->segStart = lastSegment->segEnd;
-                seg->newStart = lastSegment->newEnd;
-            }
+            seg.segStart = seg.segEnd;
+            seg.newStart = seg.newEnd;
+            seg.segEnd = rtPoints.at(i);
+            seg.newEnd = updatedRtPoints.at(i);
 
-            addSegment(sample->sampleName, seg);
-            lastSegment = seg;
+            if (segments != nullptr) {
+                segments->push_back(seg);
+            } else {
+                addSegment(sample->sampleName, seg);
+            }
         }
     }
     return (false);
@@ -415,6 +549,14 @@ bool Aligner::alignWithObiWarp(vector<mzSample*> samples,
                               ObiParams* obiParams,
                               const MavenParameters* mp)
 {
+    AlignmentCache cache(mp->alignmentCacheDir);
+    string parameters = obiWarpParameters(obiParams);
+    map<mzSample*, uint64_t> hashes;
+    // only samples without an alignment to the reference are aligned
+    samples = _restoreFromCache(cache, samples, hashes, parameters);
+    if (samples.empty())
+        return(false);
+
     if (refSample == nullptr) {
         srand(time(NULL));
         refSample = samples[rand()%samples.size()];
@@ -425,44 +567,68 @@ bool Aligner::alignWithObiWarp(vector<mzSample*> samples,
         sample->saveCurrentRetentionTimes();
     }
 
-    ObiWarp* obiWarp = new ObiWarp(obiParams);
-
-    float binSize = obiParams->binSize;
-    float minMzRange = 1e9;
-    float maxMzRange = 0;
-
-    for(const auto scan: refSample->scans) {
-        // PRM/DDA data have both mslevel 1 and mslevel 2 scans. We only want to align mslevel 1 scans
-        if(scan->mslevel == 1) {
-            for(const auto mz: scan->mz) {
-                minMzRange = min(minMzRange, mz);
-                maxMzRange = max(maxMzRange, mz);
+    // the reference data is kept in the alignment state, if there is one,
+    // for aligning samples added later
+    if (hashes.count(refSample) == 0)
+        hashes[refSample] = AlignmentCache::contentHash(refSample);
+    string referenceKey = parameters
+                          + " reference="
+                          + to_string(hashes[refSample]);
+    AlignmentState localState;
+    AlignmentState* state = _state != nullptr ? _state : &localState;
+    if (state->obiWarp(referenceKey) == nullptr) {
+        ObiWarp* obiWarp = new ObiWarp(obiParams);
+
+        float binSize = obiParams->binSize;
+        float minMzRange = 1e9;
+        float maxMzRange = 0;
+
+        for(const auto scan: refSample->scans) {
+            // PRM/DDA data have both mslevel 1 and mslevel 2 scans. We only want to align mslevel 1 scans
+            if(scan->mslevel == 1) {
+                for(const auto mz: scan->mz) {
+                    minMzRange = min(minMzRange, mz);
+                    maxMzRange = max(maxMzRange, mz);
+                }
             }
         }
-    }
 
-    maxMzRange += 10;
-    minMzRange -= 10;
-    if(minMzRange < 0.f)
-        minMzRange = 0.f;
-    minMzRange = floor(minMzRange);
-    maxMzRange = ceil(maxMzRange);
-    vector<float> mzPoints;
-    for (float bin = minMzRange; bin <= maxMzRange; bin += binSize)
-        mzPoints.push_back(bin);
+        maxMzRange += 10;
+        minMzRange -= 10;
+        if(minMzRange < 0.f)
+            minMzRange = 0.f;
+        minMzRange = floor(minMzRange);
+        maxMzRange = ceil(maxMzRange);
+        vector<float> mzPoints;
+        for (float bin = minMzRange; bin <= maxMzRange; bin += binSize)
+            mzPoints.push_back(bin);
+
+        bool stopped = alignSampleRts(refSample, mzPoints, *obiWarp, true, mp);
+        if (mp->stop || stopped) {
+            delete obiWarp;
+            return (true);
+        }
 
-    bool stopped = false;
-    stopped = alignSampleRts(refSample, mzPoints, *obiWarp, true, mp);
+        state->setObiWarp(obiWarp, mzPoints, referenceKey);
+    }
+    ObiWarp* obiWarp = state->obiWarp(referenceKey);
+    vector<float> mzPoints = state->mzPoints();
 
-    if (mp->stop || stopped) {
-        delete obiWarp;
-        return (true);
+    bool stopped = false;
+    int samplesToAlign = 0;
+    for (auto sample : samples) {
+        if (sample != refSample)
+            samplesToAlign++;
     }
 
     _alignmentSegments.clear();
     setSamples(samples);
+
+    // the reference is no longer modified, so all threads share obiWarp;
+    // segments are collected per sample and added in sample order afterwards
+    vector<vector<AlignmentSegment>> sampleSegments(samples.size());
     int samplesAligned = 0;
-    #pragma omp parallel for shared(samplesAligned)
+    #pragma omp parallel for schedule(dynamic)
     for (int i = 0; i < samples.size(); ++i) {
         if (samples[i] == refSample)
             continue;
@@ -471,25 +637,244 @@ bool Aligner::alignWithObiWarp(vector<mzSample*> samples,
             #pragma omp cancel for
         }
         #pragma omp cancellation point for
-        if (alignSampleRts(samples[i], mzPoints, *obiWarp, false, mp)) {
+        if (alignSampleRts(samples[i],
+                           mzPoints,
+                           *obiWarp,
+                           false,
+                           mp,
+                           &sampleSegments[i])) {
             stopped = true;
         } else {
+            #pragma omp critical
+            {
+                samplesAligned++;
+                setAlignmentProgress("Aligning samples",
+                                     samplesAligned,
+                                     samplesToAlign);
+            }
+        }
+    }
+    for (int i = 0; i < samples.size(); ++i) {
+        for (const auto& seg : sampleSegments[i])
+            addSegment(samples[i]->sampleName, seg);
+    }
+    setAlignmentProgress("Performing post-alignment interpolation…", 1, 1);
+    performSegmentedAlignment();
+
+    cerr << "Samples modified: " << samplesAligned << endl;
+    if (!stopped)
+        _saveToCache(cache, samples, hashes, parameters);
+    return(stopped);
+}
+
+bool Aligner::alignWithLandmarks(vector<mzSample*> samples,
+                                 const LandmarkAligner& landmarkAligner,
+                                 const MavenParameters* mp)
+{
+    AlignmentCache cache(mp->alignmentCacheDir);
+    string parameters = landmarkAligner.parameters();
+    map<mzSample*, uint64_t> hashes;
+    // only samples without an alignment to the reference are aligned
+    samples = _restoreFromCache(cache, samples, hashes, parameters);
+    if (samples.empty())
+        return(false);
+
+    if (refSample == nullptr) {
+        srand(time(NULL));
+        refSample = samples[rand()%samples.size()];
+    }
+
+    for (auto sample : samples) {
+        sample->saveCurrentRetentionTimes();
+    }
+
+    _alignmentSegments.clear();
+    setSamples(samples);
+
+    vector<Landmark> refLandmarks = landmarkAligner.findLandmarks(refSample);
+
+    vector<vector<AlignmentSegment>> sampleSegments(samples.size());
+    vector<char> warped(samples.size(), false);
+    bool stopped = false;
+    int samplesAligned = 0;
+    int samplesToAlign = 0;
+    for (auto sample : samples) {
+        if (sample != refSample)
+            samplesToAlign++;
+    }
+    #pragma omp parallel for schedule(dynamic)
+    for (int i = 0; i < samples.size(); ++i) {
+        if (samples[i] == refSample) {
+            warped[i] = true;
+            continue;
+        }
+        if (mp->stop || stopped) {
+            stopped = true;
+            #pragma omp cancel for
+        }
+        #pragma omp cancellation point for
+
+        mzSample* sample = samples[i];
+        auto matches = landmarkAligner.matchLandmarks(
+            landmarkAligner.findLandmarks(sample),
+            refLandmarks);
+
+        // the warp is known at every MS1 scan, and at the last scan of any
+        // level so that all scans fall within a segment
+        vector<float> rts;
+        float maxRt = 0;
+        for (auto scan : sample->scans) {
+            if (scan->mslevel == 1)
+                rts.push_back(scan->rt);
+            maxRt = max(maxRt, scan->rt);
+        }
+        sort(rts.begin(), rts.end());
+        rts.erase(unique(rts.begin(), rts.end()), rts.end());
+        if (rts.empty() || rts.back() < maxRt)
+            rts.push_back(maxRt);
+
+        vector<float> warpedRts = landmarkAligner.fitWarp(matches, rts);
+        if (warpedRts.empty()) {
+            #pragma omp critical
+            cerr << "Too few landmarks matched to align "
+                 << sample->sampleName
+                 << endl;
+            continue;
+        }
+
+        AlignmentSegment seg = {0, 0, 0, 0};
+        for (int j = 0; j < rts.size(); ++j) {
+            if (rts[j] == seg.segEnd) {
+                seg.newEnd = warpedRts[j];
+                continue;
+            }
+            seg.segStart = seg.segEnd;
+            seg.newStart = seg.newEnd;
+            seg.segEnd = rts[j];
+            seg.newEnd = warpedRts[j];
+            sampleSegments[i].push_back(seg);
+        }
+        warped[i] = true;
+
+        #pragma omp critical
+        {
             samplesAligned++;
-            setAlignmentProgress("Aligning samples", samplesAligned, samples.size()-1);
+            setAlignmentProgress("Aligning samples",
+                                 samplesAligned,
+                                 samplesToAlign);
         }
     }
+    for (int i = 0; i < samples.size(); ++i) {
+        for (const auto& seg : sampleSegments[i])
+            addSegment(samples[i]->sampleName, seg);
+    }
     setAlignmentProgress("Performing post-alignment interpolation…", 1, 1);
     performSegmentedAlignment();
 
     cerr << "Samples modified: " << samplesAligned << endl;
-    delete obiWarp;
+    if (!stopped) {
+        // samples without a warp kept their retention times, which are not
+        // aligned and must not be restored as such
+        vector<mzSample*> alignedSamples;
+        for (int i = 0; i < samples.size(); ++i) {
+            if (warped[i])
+                alignedSamples.push_back(samples[i]);
+        }
+        _saveToCache(cache, alignedSamples, hashes, parameters);
+    }
     return(stopped);
 }
 
-float AlignmentSegment::updateRt(float oldRt)
+vector<mzSample*> Aligner::_restoreFromCache(
+    const AlignmentCache& cache,
+    const vector<mzSample*>& samples,
+    map<mzSample*, uint64_t>& hashes,
+    const string& parameters)
+{
+    if (_state == nullptr && !cache.enabled()) {
+        cerr << "No alignment cache directory or earlier alignment set, "
+             << "aligning all samples"
+             << endl;
+        return samples;
+    }
+    hashes = contentHashes(samples);
+
+    // the reference is stored as aligned to itself
+    vector<float> rts;
+    if (refSample == nullptr) {
+        for (auto sample : samples) {
+            uint64_t hash = hashes[sample];
+            if ((_state != nullptr
+                 && _state->loadRts(hash, hash, parameters, rts))
+                || cache.contains(hash, hash, parameters)) {
+                setRefSample(sample);
+                break;
+            }
+        }
+        if (refSample == nullptr)
+            return samples;
+    }
+    if (hashes.count(refSample) == 0)
+        hashes[refSample] = AlignmentCache::contentHash(refSample);
+    uint64_t referenceHash = hashes[refSample];
+
+    vector<mzSample*> pending;
+    for (auto sample : samples) {
+        bool found = _state != nullptr
+                     && _state->loadRts(hashes[sample],
+                                        referenceHash,
+                                        parameters,
+                                        rts);
+        if (!found)
+            found = cache.load(hashes[sample], referenceHash, parameters, rts);
+        if (!found || rts.size() != sample->scans.size()) {
+            pending.push_back(sample);
+            continue;
+        }
+        sample->saveCurrentRetentionTimes();
+        for (int j = 0; j < rts.size(); ++j)
+            sample->scans[j]->rt = rts[j];
+    }
+
+    if (pending.size() < samples.size()) {
+        cerr << "Restored alignment of "
+             << samples.size() - pending.size()
+             << " samples from earlier alignments"
+             << endl;
+    }
+    return pending;
+}
+
+void Aligner::_saveToCache(const AlignmentCache& cache,
+                           const vector<mzSample*>& samples,
+                           map<mzSample*, uint64_t>& hashes,
+                           const string& parameters)
+{
+    if (_state == nullptr && !cache.enabled())
+        return;
+    if (hashes.count(refSample) == 0)
+        hashes[refSample] = AlignmentCache::contentHash(refSample);
+    uint64_t referenceHash = hashes[refSample];
+
+    for (auto sample : samples) {
+        vector<float> rts;
+        rts.reserve(sample->scans.size());
+        for (auto scan : sample->scans)
+            rts.push_back(scan->rt);
+        if (_state != nullptr)
+            _state->saveRts(hashes[sample], referenceHash, parameters, rts);
+        if (cache.enabled())
+            cache.save(hashes[sample], referenceHash, parameters, rts);
+    }
+}
+
+float AlignmentSegment::updateRt(float oldRt) const
 {
     // fractional distance from start of a segement
     if (oldRt >= segStart and oldRt <= segEnd) {
+        // e.g. the segment leading up to a first scan at rt 0
+        if (segEnd == segStart)
+            return newEnd;
         float frac = (oldRt - segStart) / (segEnd - segStart);
         return newStart + frac * (newEnd - newStart);
     } else {
@@ -505,41 +890,47 @@ float AlignmentSegment::updateRt(float oldRt)
     }
 }
 
-void Aligner::addSegment(string sampleName, AlignmentSegment* seg) {
-    if (_alignmentSegments.count(sampleName) == 0) {
-        _alignmentSegments[sampleName] = {};
-    }
-    _alignmentSegments.at(sampleName).push_back(seg);
+void Aligner::addSegment(const string& sampleName,
+                         const AlignmentSegment& seg)
+{
+    _alignmentSegments[sampleName].push_back(seg);
 }
 
 void Aligner::performSegmentedAlignment()
 {
-    for (auto sample : samples) {
+    // segments are contiguous, so the first segment ending at or after an rt
+    // is the first one containing it
+    auto compSegEnd = [](const AlignmentSegment& seg, float rt) {
+        return seg.segEnd < rt;
+    };
+
+    #pragma omp parallel for schedule(dynamic)
+    for (int i = 0; i < samples.size(); ++i) {
+        mzSample* sample = samples[i];
         if (sample == nullptr)
             continue;
 
         string sampleName = sample->sampleName;
-        if (_alignmentSegments.count(sampleName) == 0) {
+        auto entry = _alignmentSegments.find(sampleName);
+        if (entry == _alignmentSegments.end()) {
+            #pragma omp critical
             cerr << "Cannot find alignment information for sample "
                  << sampleName
                  << endl;
             continue;
         }
 
+        const vector<AlignmentSegment>& segments = entry->second;
         for (auto scan : sample->scans) {
-            AlignmentSegment* seg = nullptr;
-            for (auto segment : _alignmentSegments[sampleName]) {
-                if (scan->rt >= segment->segStart
-                    && scan->rt <= segment->segEnd) {
-                    seg = segment;
-                    break;
-                }
-            }
-
-            if (seg) {
+            auto seg = lower_bound(segments.begin(),
+                                   segments.end(),
+                                   scan->rt,
+                                   compSegEnd);
+            if (seg != segments.end() && scan->rt >= seg->segStart) {
                 double newRt = seg->updateRt(scan->rt);
                 scan->rt = newRt;
             } else {
+                #pragma omp critical
                 cerr << "Cannot find segment for: "
                      << sampleName
                      << "\t"
@@ -1,11 +1,16 @@
 #ifndef MZALIGNER_H
 #define MZALIGNER_H
 
+#include <stdint.h>
+
 #include <QJsonObject>
 #include <boost/signals2.hpp>
 
 #include "standardincludes.h"
 
+class AlignmentCache;
+class LandmarkAligner;
+class Peak;
 class PeakGroup;
 class mzSample;
 class ObiParams;
@@ -14,13 +19,90 @@ class MavenParameters;
 
 using namespace std;
 
+/**
+ * @brief Maps retention times within [segStart, segEnd] linearly onto
+ * [newStart, newEnd].
+ */
 struct AlignmentSegment {
-    string sampleName;
     float segStart;
     float segEnd;
     float newStart;
     float newEnd;
-    float updateRt(float oldRt);
+    float updateRt(float oldRt) const;
+};
+
+/**
+ * @brief What is kept from one alignment of a set of samples to the next.
+ * @details Holds the OBI-Warp reference data, so that samples added later
+ * are aligned against it without rebuilding the reference matrix, and the
+ * aligned retention times of every sample, keyed like AlignmentCache
+ * entries, so that only samples added since are aligned even when no cache
+ * directory is set. Its owner clears it when samples are removed.
+ */
+class AlignmentState
+{
+  public:
+    AlignmentState();
+    ~AlignmentState();
+
+    // owns the OBI-Warp reference
+    AlignmentState(const AlignmentState&) = delete;
+    AlignmentState& operator=(const AlignmentState&) = delete;
+
+    /**
+     * @brief Release the OBI-Warp reference and all retention times.
+     */
+    void clear();
+
+    /**
+     * @brief OBI-Warp holding reference data built for the given key, or
+     * nullptr if there is none.
+     */
+    ObiWarp* obiWarp(const string& key) const;
+
+    /**
+     * @brief m/z bins of the OBI-Warp reference data.
+     */
+    const vector<float>& mzPoints() const { return _mzPoints; }
+
+    /**
+     * @brief Keep an OBI-Warp holding reference data, releasing the previous
+     * one.
+     * @param obiWarp OBI-Warp to keep, owned by the state from now on.
+     * @param mzPoints m/z bins of the reference data.
+     * @param key Parameters and reference content the data was built for.
+     */
+    void setObiWarp(ObiWarp* obiWarp,
+                    const vector<float>& mzPoints,
+                    const string& key);
+
+    /**
+     * @brief Read the aligned retention times kept for the given key.
+     * @return True if retention times were found.
+     */
+    bool loadRts(uint64_t sampleHash,
+                 uint64_t referenceHash,
+                 const string& parameters,
+                 vector<float>& rts) const;
+
+    /**
+     * @brief Keep aligned retention times for the given key, replacing any
+     * kept before.
+     */
+    void saveRts(uint64_t sampleHash,
+                 uint64_t referenceHash,
+                 const string& parameters,
+                 const vector<float>& rts);
+
+  private:
+    ObiWarp* _obiWarp;
+    vector<float> _mzPoints;
+    string _obiWarpKey;
+    map<string, vector<float>> _rts;
+
+    static string _rtsKey(uint64_t sampleHash,
+                          uint64_t referenceHash,
+                          const string& parameters);
 };
 
 class Aligner {
@@ -38,11 +120,32 @@ class Aligner {
     bool alignWithObiWarp(vector<mzSample*> samples,
                          ObiParams* obiParams,
                          const MavenParameters* mp);
+
+    /**
+     * @brief Align samples to the reference sample by matching landmark
+     * features, a much cheaper alternative to OBI-Warp for runs that only
+     * drift slightly.
+     * @param landmarkAligner Picks and matches landmarks, and fits warps.
+     * @return True if alignment was stopped.
+     */
+    bool alignWithLandmarks(vector<mzSample*> samples,
+                            const LandmarkAligner& landmarkAligner,
+                            const MavenParameters* mp);
+
+    /**
+     * @brief Set a sample as the reference of OBI-WARP, or align it to the
+     * reference.
+     * @param segments If given, alignment segments of the sample are
+     * collected here instead of being added to the aligner, so that samples
+     * can be aligned concurrently.
+     * @return True if alignment was stopped or failed.
+     */
     bool alignSampleRts(mzSample* sample,
                         vector<float> &mzPoints,
                         ObiWarp& obiWarp,
                         bool setAsReference,
-                        const MavenParameters* mp);
+                        const MavenParameters* mp,
+                        vector<AlignmentSegment>* segments = nullptr);
     map<pair<string,string>, double> getDeltaRt() {return deltaRt; }
 	map<pair<string, string>, double> deltaRt;
     vector<vector<float> > fit;
@@ -60,15 +163,19 @@ class Aligner {
     /**
      * @brief Add an AlignmentSegment that will be used when performing
      * segmented alignment on the next call to `performSegmentedAlignment`.
+     * Segments of a sample are expected to be added in order of retention
+     * time, each starting where the previous one ends.
      * @param sampleName Name of the sample associated with this segment.
-     * @param seg Pointer to the AlignmentSegment to be added.
+     * @param seg The AlignmentSegment to be added.
      */
-    void addSegment(string sampleName, AlignmentSegment* seg);
+    void addSegment(const string& sampleName, const AlignmentSegment& seg);
 
     /**
      * @brief Perform alignment using segments of known retention times, where
      * the rt values in-between these known (aligned) segments will be simply
      * interpolated.
+     * @details The segment of every scan is found by binary search over the
+     * segments of its sample, and samples are updated in parallel.
      */
     void performSegmentedAlignment();
 
@@ -78,6 +185,14 @@ class Aligner {
      */
     void setSamples(vector<mzSample*> set) { samples = set; }
 
+    /**
+     * @brief Set the state kept between alignments of the current samples.
+     * Without one, only samples found in the alignment cache are skipped and
+     * the OBI-Warp reference is rebuilt for every alignment.
+     * @param state State owned by the caller, or nullptr.
+     */
+    void setAlignmentState(AlignmentState* state) { _state = state; }
+
 public:
     boost::signals2::signal< void (const string&,unsigned int , int ) > setAlignmentProgress;
 
@@ -85,7 +200,44 @@ public:
     vector<PeakGroup*> allgroups;
     int maxIterations;
     int polynomialDegree;
-    map<string,vector<AlignmentSegment*>> _alignmentSegments;
+    map<string,vector<AlignmentSegment>> _alignmentSegments;
+
+    /**
+     * @brief Peaks of every sample in `samples`, as (group index, peak) pairs
+     * ordered by group index, so that samples need not search each group.
+     * As with PeakGroup::getPeak, only a sample's first peak in a group is
+     * listed.
+     */
+    vector<vector<pair<unsigned int, Peak*>>> _peaksBySample();
+
+    AlignmentState* _state;
+
+    /**
+     * @brief Restore aligned retention times of samples from the alignment
+     * state, or else from the cache. If no reference sample is set, the
+     * sample stored as aligned to itself becomes the reference.
+     * @param hashes Filled with content hashes of the samples, if there is a
+     * state or cache to restore from. The reference's hash is added if
+     * missing.
+     * @return Samples without a stored alignment to the reference, which
+     * are left untouched. All samples if no reference could be found or
+     * there is neither a state nor a cache.
+     */
+    vector<mzSample*> _restoreFromCache(const AlignmentCache& cache,
+                                        const vector<mzSample*>& samples,
+                                        map<mzSample*, uint64_t>& hashes,
+                                        const string& parameters);
+
+    /**
+     * @brief Store the current retention times of samples, aligned to the
+     * reference sample, in the alignment state and the cache.
+     * @param hashes Content hashes of the samples, taken before alignment.
+     * The reference's hash is added if missing.
+     */
+    void _saveToCache(const AlignmentCache& cache,
+                      const vector<mzSample*>& samples,
+                      map<mzSample*, uint64_t>& hashes,
+                      const string& parameters);
 };
 
 
@@ -797,3 +797,168 @@ void cxfree(void *ptr)
 	free(ptr);
     }
 }
+
+namespace {
+    // largest sigma that will be reported by GaussianFitter
+    const double maxSigma = 20.0;
+
+    // the earlier grid search explored 20, 20/1.25, ..., 20/1.25^20
+    const double gridRatio = 1.25;
+    const int gridSteps = 20;
+}
+
+double GaussianFitter::_residual(double s, double* jtr, double* jtj)
+{
+    // exp(k * d^2) for every distance d from the middle, with a single exp:
+    // consecutive values differ by q^(2d + 1) where q = exp(k)
+    double k = -0.5 / (s * s);
+    double q = exp(k);
+    double q2 = q * q;
+    double g = 1;
+    double ratio = q;
+    for (size_t d = 0; d < _g.size(); d++) {
+        _g[d] = g;
+        g *= ratio;
+        ratio *= q2;
+    }
+
+    double rsqr = 0;
+    double sumJr = 0;
+    double sumJj = 0;
+    double s3 = s * s * s;
+    for (size_t i = 0; i < _y.size(); i++) {
+        double gi = _g[_distance[i]];
+        double r = gi - _y[i];
+        rsqr += r * r;
+        if (jtr) {
+            double jacobian = gi * _x2[i] / s3;
+            sumJr += jacobian * r;
+            sumJj += jacobian * jacobian;
+        }
+    }
+    if (jtr) {
+        *jtr = sumJr;
+        *jtj = sumJj;
+    }
+    return rsqr;
+}
+
+void GaussianFitter::_refine(double& s, double& rsqr, double minSigma)
+{
+    double lambda = 1e-3;
+    double jtr = 0;
+    double jtj = 0;
+    _residual(s, &jtr, &jtj);
+    for (int iter = 0; iter < 20; iter++) {
+        if (jtj <= 0)
+            break;
+
+        bool improved = false;
+        while (lambda < 1e10) {
+            double step = -jtr / (jtj * (1.0 + lambda));
+            double next = std::min(std::max(s + step, minSigma), maxSigma);
+            double nextJtr = 0;
+            double nextJtj = 0;
+            double nextRsqr = _residual(next, &nextJtr, &nextJtj);
+            if (nextRsqr <= rsqr) {
+                improved = std::abs(next - s) > 1e-3 * s;
+                s = next;
+                rsqr = nextRsqr;
+                jtr = nextJtr;
+                jtj = nextJtj;
+                lambda = std::max(lambda / 10.0, 1e-7);
+                break;
+            }
+            lambda *= 10.0;
+        }
+        if (!improved)
+            break;
+    }
+}
+
+void GaussianFitter::fit(const float *yobs, int n, float *sigma, float *R2)
+{
+    if (n < 3)
+        return;
+
+    int midpoint = n / 2;
+    double ymax = std::max(std::max(yobs[midpoint], yobs[midpoint - 1]),
+                           yobs[midpoint + 1]);
+    double ymin = std::min(yobs[0], yobs[n - 1]);
+
+    // x values are centered around 0, for example -2, -1, 0, 1, 2
+    _x2.resize(n);
+    _y.resize(n);
+    _distance.resize(n);
+    _g.resize(std::max(midpoint, n - 1 - midpoint) + 1);
+    int greaterZeroCount = 0;
+    for (int i = 0; i < n; i++) {
+        double x = i - midpoint;
+        _x2[i] = x * x;
+        _distance[i] = std::abs(i - midpoint);
+        if (yobs[i] > ymin)
+            greaterZeroCount++;
+        _y[i] = (yobs[i] - ymin) / (ymax - ymin);
+        if (_y[i] < 0)
+            _y[i] = 0;
+    }
+    if (greaterZeroCount <= 3)
+        return;
+
+    // the smallest sigma explored by the original grid search
+    const double minSigma = maxSigma / pow(gridRatio, gridSteps);
+
+    // closed-form initial estimate: ln(y) = -x^2 / (2 * sigma^2), fitted
+    // through the origin with y^2 weights to damp the noisy tails
+    double sxy = 0;
+    double sxx = 0;
+    for (int i = 0; i < n; i++) {
+        if (_y[i] <= 0.05 || _y[i] > 1.0 || _x2[i] == 0)
+            continue;
+        double w = _y[i] * _y[i];
+        sxy += w * _x2[i] * log(_y[i]);
+        sxx += w * _x2[i] * _x2[i];
+    }
+    double seed = maxSigma;
+    if (sxx > 0 && sxy < 0)
+        seed = sqrt(-sxx / (2.0 * sxy));
+    seed = std::min(std::max(seed, minSigma), maxSigma);
+    double seedRsqr = _residual(seed);
+
+    // start from the best point of the earlier grid, so that the fit is
+    // never worse than that grid search, which stopped at the first local
+    // minimum it came across
+    double start = maxSigma;
+    double startRsqr = std::numeric_limits<double>::infinity();
+    double gridSigma = maxSigma;
+    for (int step = 0; step <= gridSteps; step++) {
+        double rsqr = _residual(gridSigma);
+        if (rsqr < startRsqr) {
+            start = gridSigma;
+            startRsqr = rsqr;
+        }
+        gridSigma /= gridRatio;
+    }
+    _refine(start, startRsqr, minSigma);
+    double s = start;
+    double rsqr = startRsqr;
+
+    // noisy peaks can have several local minima, refining the seed is only
+    // worthwhile if it lies in another one
+    if (std::abs(log(seed / start)) > log(gridRatio)) {
+        _refine(seed, seedRsqr, minSigma);
+        if (seedRsqr < rsqr) {
+            s = seed;
+            rsqr = seedRsqr;
+        }
+    }
+
+    if (!std::isfinite(rsqr)) {
+        *sigma = 0;
+        *R2 = std::numeric_limits<float>::infinity();
+        return;
+    }
+
+    *sigma = s;
+    *R2 = rsqr / (n * n);
+}
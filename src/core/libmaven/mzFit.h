@@ -15,6 +15,65 @@ void leasqu(int n, double *x, double *y, int degree, double *w, int wdim,
             double *r);
 void stasum(double *x, int n, double *xbar, double *sd, int flag);
 
+/**
+ * @brief Fits the width of a unit-height Gaussian, centered on the middle
+ * point, to the intensities of a chromatographic peak.
+ *
+ * @details Intensities are first scaled to [0, 1] using the apex (maximum of
+ * the three middle points) and the lower of the two end points. Sigma is
+ * refined by a few Levenberg-Marquardt steps, using the analytic derivative
+ * of the residuals, from two starting points: the best of a coarse grid over
+ * the whole range, and a closed-form estimate from a weighted least squares
+ * fit of a parabola to the log-intensities. Noisy peaks can have several
+ * local minima, and the better of the two refined fits is kept.
+ * Sigma is bounded to the range that the older grid search over
+ * 20, 20/1.25, ..., 20/1.25^20 could explore, and the reported R2 is the
+ * residual sum of squares divided by the squared number of points, as
+ * before.
+ *
+ * A fitter keeps its scratch buffers between calls, so a single instance
+ * should be reused for all peaks processed on a thread.
+ */
+class GaussianFitter
+{
+  public:
+    /**
+     * @brief Fit a Gaussian to the given intensities.
+     * @param yobs Pointer to intensity values, apex expected at the middle.
+     * @param n Number of intensity values.
+     * @param sigma Set to the fitted sigma (in number of points). Left
+     * unchanged if there are too few non-zero points to fit.
+     * @param R2 Set to the corrected residual of the fit. Left unchanged if
+     * there are too few non-zero points to fit.
+     */
+    void fit(const float *yobs, int n, float *sigma, float *R2);
+
+  private:
+    /**
+     * @brief Sum of squared residuals of the Gaussian with the given sigma.
+     * @param jtr If given, set to the gradient term J^T r of the residuals.
+     * @param jtj If given, set to J^T J of the residuals.
+     */
+    double _residual(double s, double* jtr = nullptr, double* jtj = nullptr);
+
+    /**
+     * @brief Levenberg-Marquardt refinement of sigma, which is never moved to
+     * a larger residual.
+     * @param s Starting sigma, set to the refined one.
+     * @param rsqr Residual at the starting sigma, set to the refined one.
+     * @param minSigma Smallest sigma allowed.
+     */
+    void _refine(double& s, double& rsqr, double minSigma);
+
+    std::vector<double> _x2;
+    std::vector<double> _y;
+
+    // distance of every point from the middle, and the Gaussian evaluated at
+    // every distance
+    std::vector<int> _distance;
+    std::vector<double> _g;
+};
+
 ////kiran TODO:function not used
 //int linear_regression(int n, double *x, double *y, double *fitted);
 //
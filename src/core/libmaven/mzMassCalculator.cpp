@@ -7,9 +7,26 @@
 #include "mzSample.h"
 #include "mzUtils.h"
 
+#include <mutex>
+#include <tuple>
+#include <unordered_map>
+
 using namespace mzUtils;
 using namespace std;
 
+namespace {
+    // Memoised results of formula parsing and isotope enumeration. Compound
+    // formulae are looked up over and over again (per sample, per slice, per
+    // export), but they only ever need to be parsed once. All caches are
+    // shared across threads and guarded by the same mutex.
+    typedef tuple<string, bool, bool, bool, bool> IsotopeKey;
+
+    std::mutex cacheMutex;
+    unordered_map<string, map<string, int>> compositionCache;
+    unordered_map<string, double> neutralMassCache;
+    map<IsotopeKey, vector<Isotope>> isotopeCache;
+}
+
 MassCalculator::IonizationType MassCalculator::ionizationType = MassCalculator::ESI;
 Adduct* MassCalculator::PlusHAdduct  = new Adduct("[M-H]+",  PROTON_MASS , 1, 1);
 Adduct* MassCalculator::MinusHAdduct = new Adduct("[M-H]-", -PROTON_MASS, -1, 1);
@@ -24,9 +41,31 @@ double MassCalculator::getElementMass(string elmnt) {
     return val_atome;
 }
 
+vector<pair<double, double>> MassCalculator::getElementIsotopes(const string& element) {
+    auto isotopes = elementMass.elementIsotopeMap.find(element);
+    if (isotopes != elementMass.elementIsotopeMap.end())
+        return isotopes->second;
+    return vector<pair<double, double>>(1, make_pair(getElementMass(element), 1.0));
+}
+
 
 
 map<string, int> MassCalculator::getComposition(string formula) {
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        auto cached = compositionCache.find(formula);
+        if (cached != compositionCache.end())
+            return cached->second;
+    }
+
+    map<string, int> atoms = parseComposition(formula);
+
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    compositionCache[formula] = atoms;
+    return atoms;
+}
+
+map<string, int> MassCalculator::parseComposition(const string& formula) {
 
     /* define some variable */
     int SIZE = formula.length();
@@ -67,6 +106,13 @@ map<string, int> MassCalculator::getComposition(string formula) {
 }
 
 double MassCalculator::computeNeutralMass(string formula) {
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        auto cached = neutralMassCache.find(formula);
+        if (cached != neutralMassCache.end())
+            return cached->second;
+    }
+
     map<string, int> atoms = getComposition(formula);
     map<string, int>::iterator itr;
 
@@ -74,9 +120,19 @@ double MassCalculator::computeNeutralMass(string formula) {
     for (itr = atoms.begin(); itr != atoms.end(); itr++) {
         mass += getElementMass((*itr).first) * (*itr).second;
     }
+
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    neutralMassCache[formula] = mass;
     return mass;
 }
 
+void MassCalculator::clearCache() {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    compositionCache.clear();
+    neutralMassCache.clear();
+    isotopeCache.clear();
+}
+
 double MassCalculator::adjustMass(double mass, int charge) {
     if (mass == 0) return 0;
     if (MassCalculator::ionizationType == EI and charge != 0) {
@@ -104,6 +160,66 @@ vector<Isotope> MassCalculator::computeIsotopes(
     bool S34Flag,
     bool D2Flag
 )
+{
+    // isotope patterns are cached as neutral masses, since abundances do
+    // not depend on the charge (or the current ionization type)
+    IsotopeKey key(formula, C13Flag, N15Flag, S34Flag, D2Flag);
+    vector<Isotope> isotopes;
+    bool found = false;
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        auto cached = isotopeCache.find(key);
+        if (cached != isotopeCache.end()) {
+            isotopes = cached->second;
+            found = true;
+        }
+    }
+
+    if (!found) {
+        isotopes = computeNeutralIsotopes(formula,
+                                          C13Flag,
+                                          N15Flag,
+                                          S34Flag,
+                                          D2Flag);
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        isotopeCache[key] = isotopes;
+    }
+
+    for (unsigned int i = 0; i < isotopes.size(); i++)
+        isotopes[i].mass = adjustMass(isotopes[i].mass, charge);
+
+    return isotopes;
+}
+
+vector<double> MassCalculator::logAbundances(int atomCount,
+                                             double lightAbundance,
+                                             double heavyAbundance)
+{
+    // log(n!) for every n up to the number of atoms
+    vector<double> logFactorial(atomCount + 1, 0.0);
+    for (int i = 2; i <= atomCount; i++)
+        logFactorial[i] = logFactorial[i - 1] + log(static_cast<double>(i));
+
+    double logLight = log(lightAbundance);
+    double logHeavy = log(heavyAbundance);
+    vector<double> logProbability(atomCount + 1);
+    for (int k = 0; k <= atomCount; k++) {
+        logProbability[k] = logFactorial[atomCount]
+                            - logFactorial[k]
+                            - logFactorial[atomCount - k]
+                            + (atomCount - k) * logLight
+                            + k * logHeavy;
+    }
+    return logProbability;
+}
+
+vector<Isotope> MassCalculator::computeNeutralIsotopes(
+    const string& formula,
+    bool C13Flag,
+    bool N15Flag,
+    bool S34Flag,
+    bool D2Flag
+)
 {
     map<string, int> atoms = getComposition(formula);
     int CatomCount = atoms[C_STRING_ID];
@@ -182,24 +298,16 @@ vector<Isotope> MassCalculator::computeIsotopes(
         }
     }
 
+    // binomial probabilities of each heavy atom count, in log-space so that
+    // they neither overflow nor underflow for large molecules
+    vector<double> logC = logAbundances(CatomCount, C12_ABUNDANCE, C13_ABUNDANCE);
+    vector<double> logN = logAbundances(NatomCount, N14_ABUNDANCE, N15_ABUNDANCE);
+    vector<double> logS = logAbundances(SatomCount, S32_ABUNDANCE, S34_ABUNDANCE);
+    vector<double> logH = logAbundances(HatomCount, H_ABUNDANCE, H2_ABUNDANCE);
+
     for (unsigned int i = 0; i < isotopes.size(); i++) {
         Isotope& x = isotopes[i];
-        int c = x.C13;
-        int n = x.N15;
-        int s = x.S34;
-        int d = x.H2;
-
-        isotopes[i].mass = adjustMass(isotopes[i].mass,charge);
-
-        isotopes[i].abundance =
-            mzUtils::nchoosek(CatomCount, c) *
-            pow(C12_ABUNDANCE, CatomCount - c) * pow(C13_ABUNDANCE, c) *
-            mzUtils::nchoosek(NatomCount, n) *
-            pow(N14_ABUNDANCE, NatomCount - n) * pow(N15_ABUNDANCE, n) *
-            mzUtils::nchoosek(SatomCount, s) *
-            pow(S32_ABUNDANCE, SatomCount - s) * pow(S34_ABUNDANCE, s) *
-            mzUtils::nchoosek(HatomCount, d) *
-            pow(H_ABUNDANCE, HatomCount - d) * pow(H2_ABUNDANCE, d);
+        x.abundance = exp(logC[x.C13] + logN[x.N15] + logS[x.S34] + logH[x.H2]);
     }
 
     return isotopes;
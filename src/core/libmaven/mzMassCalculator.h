@@ -77,6 +77,16 @@ class MassCalculator {
         static map<string,int> getComposition(string formula);
 
 
+        /**
+         * [getElementIsotopes masses and natural abundances of the stable
+         * isotopes of an element. Elements without isotope data are treated
+         * as monoisotopic.]
+         * @method getElementIsotopes
+         * @param  element            [element symbol]
+         * @return                    [vector of (mass, abundance) pairs]
+         */
+        static vector<pair<double, double>> getElementIsotopes(const string& element);
+
         /**
          * [prettyName ]
          * @method prettyName
@@ -101,6 +111,15 @@ class MassCalculator {
         void enumerateMasses(double inputMass, double charge, MassCutoff *massCutoff, vector<Match*>& matches);
 
 
+        /**
+         * [computeIsotopes list isotopologues of a formula for the given
+         * labels, with their m/z and natural abundance. Results are memoised
+         * per formula and labels.]
+         * @method computeIsotopes
+         * @param  formula     []
+         * @param  charge      []
+         * @return             [vector of isotopes]
+         */
         static vector<Isotope> computeIsotopes(
             string formula,
             int charge,
@@ -110,6 +129,12 @@ class MassCalculator {
             bool D2Flag 
         );
 
+        /**
+         * [clearCache drop memoised compositions, masses and isotopes]
+         * @method clearCache
+         */
+        static void clearCache();
+
         /**
          * [adjustMass ]
          * @method adjustMass
@@ -142,6 +167,36 @@ class MassCalculator {
         static double getElementMass(string elmnt);
         static void generateElementMassMap(string filename);
 
+        /**
+         * [parseComposition parse a formula without consulting the cache]
+         * @method parseComposition
+         */
+        static map<string,int> parseComposition(const string& formula);
+
+        /**
+         * [computeNeutralIsotopes enumerate isotopes with neutral masses
+         * and abundances, without consulting the cache]
+         * @method computeNeutralIsotopes
+         */
+        static vector<Isotope> computeNeutralIsotopes(const string& formula,
+                                                      bool C13Flag,
+                                                      bool N15Flag,
+                                                      bool S34Flag,
+                                                      bool D2Flag);
+
+        /**
+         * [logAbundances log-probability of finding k heavy atoms among n
+         * atoms of an element, for every k from 0 to n]
+         * @method logAbundances
+         * @param  atomCount       [number of atoms of the element]
+         * @param  lightAbundance  [natural abundance of the light isotope]
+         * @param  heavyAbundance  [natural abundance of the heavy isotope]
+         * @return                 [vector of n+1 log-probabilities]
+         */
+        static vector<double> logAbundances(int atomCount,
+                                            double lightAbundance,
+                                            double heavyAbundance);
+
 };
 
 #endif
@@ -53,6 +53,8 @@ mzSample::~mzSample()
         if (scans[i] != NULL)
             delete (scans[i]);
     scans.clear();
+    _ms2Scans.clear();
+    _ms2PrecursorMzs.clear();
 }
 
 void mzSample::addScan(Scan* s)
@@ -95,10 +97,49 @@ void mzSample::addScan(Scan* s)
     scans.push_back(s);
     s->scannum = scans.size() - 1;
 
-    //recalculate precursorMz of MS2 scans
-    if (s->mslevel == 2 && _numMS1Scans > 0) {
-        float ppm = 10;
-        s->recalculatePrecursorMz(ppm);
+    if (s->mslevel == 2) {
+        _ms2Scans.push_back(s);
+        _ms2PrecursorMzs.push_back(s->precursorMz);
+    }
+}
+
+void mzSample::linkMs2Scans()
+{
+    // link every scan to the closest full scan at or before it
+    Scan* lastFullScan = nullptr;
+    vector<Scan*> fragmentationScans;
+    for (auto scan : scans) {
+        if (scan->mslevel == 1) {
+            lastFullScan = scan;
+        } else {
+            fragmentationScans.push_back(scan);
+        }
+        scan->setLastFullScan(lastFullScan);
+    }
+
+    // recalculate precursorMz of MS2 scans and store their purity at the
+    // tolerances used for fragmentation scoring (10 ppm) and by the scan
+    // tree and project files (20 ppm)
+    #pragma omp parallel for schedule(dynamic, 64)
+    for (int i = 0; i < static_cast<int>(fragmentationScans.size()); i++) {
+        Scan* scan = fragmentationScans[i];
+        scan->recalculatePrecursorMz(10);
+        scan->cachePrecursorPurity(10);
+        scan->cachePrecursorPurity(20);
+    }
+
+    indexMs2Scans();
+}
+
+void mzSample::indexMs2Scans()
+{
+    _ms2Scans.clear();
+    _ms2PrecursorMzs.clear();
+    for (auto scan : scans) {
+        if (scan->mslevel != 2)
+            continue;
+        _ms2Scans.push_back(scan);
+        _ms2PrecursorMzs.push_back(scan->precursorMz);
     }
 }
 
@@ -173,6 +214,9 @@ void mzSample::loadSample(const char* filename)
     // getting the SRM scan type
     enumerateSRMScans();
 
+    // scans may have been reordered while parsing
+    linkMs2Scans();
+
     // set min and max values for rt and mz
     calculateMzRtRange();
 
@@ -1415,6 +1459,55 @@ EIC* mzSample::getEIC(float mzmin,
     return (e);
 }
 
+vector<EIC*> mzSample::getEICs(const vector<pair<float, float>>& mzRanges,
+                              float rtmin,
+                              float rtmax,
+                              int mslevel,
+                              int eicType,
+                              string filterline)
+{
+    if (rtmin < this->minRt)
+        rtmin = this->minRt;
+    if (rtmax > this->maxRt && this->maxRt > rtmin)
+        rtmax = this->maxRt;
+
+    vector<EIC*> eics;
+    eics.reserve(mzRanges.size());
+    for (const auto& range : mzRanges) {
+        float mzmin = range.first;
+        float mzmax = range.second;
+        if (mzmin < this->minMz)
+            mzmin = this->minMz;
+        if (mzmax > this->maxMz && this->maxMz > mzmin)
+            mzmax = this->maxMz;
+
+        EIC* e = new EIC();
+        e->sampleName = sampleName;
+        e->sample = this;
+        e->mzmin = mzmin;
+        e->mzmax = mzmax;
+        e->totalIntensity = 0;
+        e->maxIntensity = 0;
+        eics.push_back(e);
+    }
+
+    if (eics.empty() || scans.size() == 0)
+        return eics;
+
+    bool success = EIC::makeEICSlices(
+        this, eics, rtmin, rtmax, mslevel, eicType, filterline);
+    if (!success)
+        return eics;
+
+    float scale = getNormalizationConstant();
+    for (EIC* e : eics) {
+        e->getRTMinMaxPerScan();
+        e->normalizeIntensityPerScan(scale);
+    }
+
+    return eics;
+}
+
 EIC* mzSample::getTIC(float rtmin, float rtmax, int mslevel)
 {
     // TODO naman unused function
@@ -1827,17 +1920,22 @@ void mzSample::restorePreviousRetentionTimes()
 vector<Scan*> mzSample::getFragmentationEvents(mzSlice* slice)
 {
     vector<Scan*> matchedScans;
-    for (auto scan : scans) {
-        if (scan->mslevel != 2)
-            continue;  // ms2 + scans only
-        if (scan->rt < slice->rtmin)
-            continue;
-        if (scan->rt > slice->rtmax)
+
+    // RTs are read from the scans themselves, since they can change when
+    // samples are aligned
+    auto first = lower_bound(_ms2Scans.begin(),
+                             _ms2Scans.end(),
+                             slice->rtmin,
+                             [](const Scan* scan, float rt) {
+                                 return scan->rt < rt;
+                             });
+
+    for (size_t i = first - _ms2Scans.begin(); i < _ms2Scans.size(); i++) {
+        if (_ms2Scans[i]->rt > slice->rtmax)
             break;
-        if (scan->precursorMz >= slice->mzmin
-            && scan->precursorMz <= slice->mzmax) {
-            matchedScans.push_back(scan);
-        }
+        float precursorMz = _ms2PrecursorMzs[i];
+        if (precursorMz >= slice->mzmin && precursorMz <= slice->mzmax)
+            matchedScans.push_back(_ms2Scans[i]);
     }
     return matchedScans;
 }
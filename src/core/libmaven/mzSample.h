@@ -368,6 +368,26 @@ class mzSample
     */
     EIC *getEIC(float mzmin, float mzmax, float rtmin, float rtmax, int mslevel, int eicType, string filterline);
 
+    /**
+    * @brief Get EICs for several m/z ranges over the same RT range
+    * @details Scans are traversed only once for all m/z ranges.
+    * @param mzRanges Pairs of minimum and maximum m/z
+    * @param rtmin Minimum retention time
+    * @param rtmax Maximum retention time
+    * @param mslevel MS Level. MS Level is 1 for MS data and 2 for MS/MS data
+    * @param eicType Type of EIC (max or sum)
+    * @param filterline selected filterline
+    * @return Vector of EICs, one for each m/z range, in the same order. The
+    * caller owns the returned EICs.
+    * @see EIC
+    */
+    vector<EIC*> getEICs(const vector<pair<float, float>> &mzRanges,
+                         float rtmin,
+                         float rtmax,
+                         int mslevel,
+                         int eicType,
+                         string filterline);
+
     /**
     * @brief Get EIC based on srmId
     * @param srmId Filterline
@@ -540,10 +560,22 @@ class mzSample
 
     /**
      * @brief find all MS2 scans within the slice
+     * @details MS2 scans are looked up in an index sorted by RT, built as
+     * scans are added, so only the scans in the slice's RT window are
+     * visited.
      * @return vector of all matching MS2 scans
      */
     vector<Scan*> getFragmentationEvents(mzSlice* slice);
 
+    /**
+     * @brief Post-load pass over the scans of this sample.
+     * @details Links every scan to its parent full scan, recalculates the
+     * precursor m/z of MS2 scans against it and stores their precursor
+     * purity, in parallel across scans. Parsers only add scans, so this has
+     * to be called once all scans are in place (loadSample does so).
+     */
+    void linkMs2Scans();
+
     /**
                           * [C13Labeled?]
                           * @method C13Labeled
@@ -714,6 +746,18 @@ class mzSample
     unsigned int _numMS1Scans;
     unsigned int _numMS2Scans;
 
+    /**
+     * @brief MS2 scans of this sample, in acquisition (and therefore RT)
+     * order.
+     */
+    vector<Scan*> _ms2Scans;
+
+    /**
+     * @brief Precursor m/z of every scan in _ms2Scans, stored contiguously
+     * so that precursor range checks do not have to dereference scans.
+     */
+    vector<float> _ms2PrecursorMzs;
+
     void sampleNaming(const char *filename);
     void checkSampleBlank(const char *filename);
 
@@ -737,6 +781,11 @@ class mzSample
 
     void loadAnySample(const char *filename);
 
+    /**
+     * @brief Rebuild the index of MS2 scans from all scans of this sample.
+     */
+    void indexMs2Scans();
+
     //TODO: This should be moved
     static string getFileName(const string &filename);
     static int filter_minIntensity;
@@ -2,6 +2,7 @@
 #include "SavGolSmoother.h"
 #include "csvparser.h"
 #include "masscutofftype.h"
+#include "mzFit.h"
 #include "RealFirFilter.h"
 #include <boost/iostreams/copy.hpp>
 #include <boost/iostreams/filter/zlib.hpp>
@@ -577,55 +578,8 @@ Series:  Prentice-Hall Series in Automatic Computation
 
     /*peak fitting function*/
     void gaussFit(const vector<float>&ycoord, float* sigma, float* R2) {
-
-        float s = 20;
-        float min_s = 0;
-        float minR = 1e99;
-
-        //find best fit
-        if (ycoord.size()<3) return;
-        vector<float>yobs=ycoord;
-        int ysize=yobs.size();
-        int midpoint  = int(ysize/2);
-        //find maximum point ( assuming it somewhere around midpoint of the yobs);
-        float ymax = max(max(yobs[midpoint], yobs[midpoint-1]),yobs[midpoint+1]);
-        float ymin = min( yobs[0], yobs[ysize-1]);
-
-        //initialize x vector, values centered around 0, forxample  -2, -1, 0, 1, 2
-        int xinit = int(ysize/2)*-1;
-        vector<float>x(ysize,0);
-        int greaterZeroCount=0;
-
-        for(int i=0; i<ysize; i++ ) {
-            x[i] = xinit+i;
-            if ( yobs[i] > ymin ) greaterZeroCount++;
-            yobs[i] = (yobs[i]-ymin)/(ymax-ymin);
-            if(yobs[i]<0) yobs[i]=0;
-        }
-
-        /*
-           cerr << "fitting yobs:" << endl; for(int i=0; i < ysize; i++ )
-           cerr << setprecision(2) << yobs[i] << ", "; cerr << endl;
-           */
-
-        bool converged = false;
-        int ittr = 0;
-
-        if (greaterZeroCount <= 3 ) return;
-        while (!converged ) {
-            if ( ittr++ > 20 ) break;
-            float Rsqr=0;
-            for(int i=0; i < ysize; i++ )  { Rsqr += POW2(exp(-0.5*POW2(x[i]/s)) - yobs[i]); }
-            //       cerr << "\t\ts=" << s << " Rsqr=" << Rsqr << endl;
-            if ( Rsqr < minR || ittr == 0 ) { minR = Rsqr; min_s = s; }
-            else if ( Rsqr > minR ) break;
-            else if ( Rsqr - minR == 0 ) break;
-            s /= 1.25;
-        }
-
-        *sigma = min_s;
-        *R2 = minR/(ysize*ysize);	//corrected R2
-        //cerr << "fit() s=" << *sigma << " R2=" << *R2 << endl;
+        static thread_local GaussianFitter fitter;
+        fitter.fit(ycoord.data(), ycoord.size(), sigma, R2);
     }
 
 
@@ -204,11 +204,13 @@ namespace mzUtils {
     float correlation(const vector<float>& a, const vector<float>& b);
 
     /**
-     * [gaussFit ]
+     * [gaussFit fit a gaussian curve to the intensities of a peak, using a
+     * per-thread GaussianFitter]
      * @method gaussFit
-     * @param  yobs     []
-     * @param  sigmal   []
-     * @param  R2       []
+     * @param  yobs     [intensities, with the apex at the middle]
+     * @param  sigmal   [fitted sigma]
+     * @param  R2       [residual of the fit]
+     * @see GaussianFitter
      */
     void gaussFit(const vector<float>& yobs, float* sigmal, float* R2);
 
@@ -577,6 +579,25 @@ namespace mzUtils {
             //	my_vector.shrink_to_fit();
         }
 
+    /**
+     * @brief Keep only those elements of a vector whose entry in the given
+     * mask is true, preserving their relative order.
+     * @details Unlike repeated calls to `erase`, this compacts the vector in a
+     * single linear pass.
+     * @param items Vector to be compacted in place.
+     * @param keep Mask of the same length as `items`.
+     */
+    template <typename T>
+        void retainMasked(vector<T>& items, const vector<bool>& keep) {
+            size_t kept = 0;
+            for (size_t i = 0; i < items.size(); ++i) {
+                if (!keep[i]) continue;
+                if (kept != i) items[kept] = std::move(items[i]);
+                ++kept;
+            }
+            items.erase(items.begin() + kept, items.end());
+        }
+
         /**
          * @brief Zeroth-order modified bessel function of the first kind.
          * @param x Argument for the modified bessel function.
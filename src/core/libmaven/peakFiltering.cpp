@@ -2,6 +2,8 @@
 #include "EIC.h"
 #include "Peak.h"
 #include "mavenparameters.h"
+#include "mzUtils.h"
+#include "datastructures/peakTable.h"
 
 
 PeakFiltering::PeakFiltering(MavenParameters *mavenParameters, bool isIsotope)
@@ -25,43 +27,35 @@ void PeakFiltering::filter(EIC *eic)
     filter(eic->peaks);
 }
 
-// TODO: Erasing takes linear time. We can make copy
-// of filtered peaks and return these to caller method
-// or should do something else.
 void PeakFiltering::filter(vector<Peak> &peaks)
 {
+    // compact in a single pass, reading only the quality of every peak
+    peaks.erase(remove_if(peaks.begin(),
+                          peaks.end(),
+                          [this](const Peak& peak) {
+                              return _isFiltered(peak.quality);
+                          }),
+                peaks.end());
+}
 
-    unsigned int i = 0;
-    while (i < peaks.size())
-    {
-        if (filter(peaks[i]))
-        {
-            peaks.erase(peaks.begin() + i);
-        }
-        else
-        {
-            ++i;
-        }
-    }
+vector<bool> PeakFiltering::keepMask(const PeakTable &table)
+{
+    const float* quality = table.quality.data();
+    vector<bool> keep(table.size());
+    for (size_t i = 0; i < table.size(); ++i)
+        keep[i] = !_isFiltered(quality[i]);
+
+    return keep;
 }
 
 bool PeakFiltering::filter(Peak &peak)
 {
+    return _isFiltered(peak.quality);
+}
 
-    if (_isIsotope)
-    {
-        if (_mavenParameters->minIsotopicPeakQuality > peak.quality)
-        {
-            return true;
-        }
-    }
-    else
-    {
-        if (_mavenParameters->minPeakQuality > peak.quality)
-        {
-            return true;
-        }
-    }
-
-    return false;
+bool PeakFiltering::_isFiltered(float quality) const
+{
+    float minQuality = _isIsotope ? _mavenParameters->minIsotopicPeakQuality
+                                  : _mavenParameters->minPeakQuality;
+    return minQuality > quality;
 }
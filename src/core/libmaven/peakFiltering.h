@@ -5,6 +5,7 @@
 #include "standardincludes.h"
 
 class Peak;
+class PeakTable;
 class EIC;
 class MavenParameters;
 
@@ -49,9 +50,24 @@ class PeakFiltering
 	 */
 	bool filter(Peak &peak);
 
+	/**
+	 * @brief Evaluate the peak filters over all rows of a peak table
+	 * @param table Columnar view of the peaks to be filtered
+	 * @return Mask with true for every row (peak) that should be kept
+	 * @see PeakTable
+	 */
+	vector<bool> keepMask(const PeakTable &table);
+
   private:
 	bool _isIsotope;
 	MavenParameters *_mavenParameters;
+
+	/**
+	 * @brief Returns true if a peak of the given quality is filtered. Every
+	 * filter method applies this predicate.
+	 * @param quality Quality of the peak
+	 */
+	bool _isFiltered(float quality) const;
 };
 
 #endif //PEAKFILTERING_H
@@ -0,0 +1,254 @@
+#include <unordered_set>
+
+#include "Fragment.h"
+#include "mzSample.h"
+#include "mzUtils.h"
+#include "Scan.h"
+#include "spectraClustering.h"
+
+namespace {
+    // spacing of nominal masses, accounting for the average mass defect
+    const float binWidth = 1.0005079;
+
+    // a random pair of spectra shares an 8-bit band with probability 1/256;
+    // the number of bands is then chosen for the minimum score
+    const int bitsPerBand = 8;
+    const int maxBands = 128;
+
+    // probability of two spectra at the minimum score sharing a band
+    const double minRecall = 0.99;
+
+    /**
+     * @brief Pseudo-random 64 bits for a given key (splitmix64 finaliser).
+     * Every bit serves as the sign of one hyperplane's component.
+     */
+    uint64_t mix(uint64_t key)
+    {
+        key += 0x9e3779b97f4a7c15ULL;
+        key = (key ^ (key >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        key = (key ^ (key >> 27)) * 0x94d049bb133111ebULL;
+        return key ^ (key >> 31);
+    }
+
+    /**
+     * @brief Union-find over spectrum indices.
+     */
+    class DisjointSets
+    {
+      public:
+        DisjointSets(unsigned int size) : _parents(size)
+        {
+            for (unsigned int i = 0; i < size; i++)
+                _parents[i] = i;
+        }
+
+        unsigned int find(unsigned int i)
+        {
+            while (_parents[i] != i) {
+                _parents[i] = _parents[_parents[i]];
+                i = _parents[i];
+            }
+            return i;
+        }
+
+        void join(unsigned int i, unsigned int j)
+        {
+            i = find(i);
+            j = find(j);
+            if (i < j) _parents[j] = i;
+            else if (j < i) _parents[i] = j;
+        }
+
+      private:
+        vector<unsigned int> _parents;
+    };
+}
+
+SpectraClustering::SpectraClustering(float precursorPpm,
+                                     float productPpm,
+                                     float minScore,
+                                     string scoringAlgo)
+{
+    _precursorPpm = precursorPpm;
+    _productPpm = productPpm;
+    _minScore = minScore;
+    _scoringAlgo = scoringAlgo;
+    _scoredPairs = 0;
+
+    // a signature bit agrees for two spectra with probability 1 - angle / pi,
+    // so a band of r bits is shared with probability p^r and at least one of
+    // b bands with 1 - (1 - p^r)^b. The correlation scores are bounded by
+    // the cosine of the binned spectra; other scores have no cosine
+    // equivalent and get bands for a moderate cosine of 0.5.
+    double cosine = 0.5;
+    if (scoringAlgo == "DotProduct" || scoringAlgo == "WeightedDotProduct")
+        cosine = max(0.0, min(1.0, static_cast<double>(minScore)));
+    double bandRecall = pow(1.0 - acos(cosine) / M_PI, bitsPerBand);
+    if (bandRecall >= 1.0) {
+        _numBands = 1;
+    } else {
+        double bands = log(1.0 - minRecall) / log(1.0 - bandRecall);
+        _numBands = max(1, min(maxBands, static_cast<int>(ceil(bands))));
+    }
+}
+
+SpectraClustering::~SpectraClustering()
+{
+    _clear();
+}
+
+void SpectraClustering::_clear()
+{
+    mzUtils::delete_all(_clusters);
+    _clusterScans.clear();
+    _scoredPairs = 0;
+}
+
+vector<uint8_t> SpectraClustering::_signature(Fragment* fragment) const
+{
+    vector<pair<int, float>> bins;
+    for (unsigned int i = 0; i < fragment->nobs(); i++) {
+        int bin = static_cast<int>(fragment->mzValues[i] / binWidth);
+        bins.push_back(make_pair(bin, fragment->intensityValues[i]));
+    }
+
+    // project the binned spectrum onto random hyperplanes, keeping the sign
+    // of each projection; 64 hyperplane components are drawn at a time
+    int numBits = _numBands * bitsPerBand;
+    vector<double> projections(numBits, 0.0);
+    for (auto& bin : bins) {
+        for (int word = 0; word * 64 < numBits; word++) {
+            uint64_t signs = mix(static_cast<uint64_t>(bin.first) * maxBands
+                                 + word);
+            for (int b = word * 64; b < min(numBits, word * 64 + 64); b++) {
+                if ((signs >> (b % 64)) & 1ULL)
+                    projections[b] += bin.second;
+                else
+                    projections[b] -= bin.second;
+            }
+        }
+    }
+
+    vector<uint8_t> bands(_numBands, 0);
+    for (int b = 0; b < numBits; b++) {
+        if (projections[b] > 0)
+            bands[b / bitsPerBand] |= (1 << (b % bitsPerBand));
+    }
+    return bands;
+}
+
+vector<pair<unsigned int, unsigned int>> SpectraClustering::_candidatePairs(
+    const vector<vector<uint8_t>>& signatures,
+    const vector<float>& precursorMzs) const
+{
+    unordered_set<uint64_t> seen;
+    vector<pair<unsigned int, unsigned int>> pairs;
+
+    // spectra of each band bucket, sorted by precursor m/z
+    vector<pair<uint8_t, unsigned int>> keys(signatures.size());
+    for (int band = 0; band < _numBands; band++) {
+        for (unsigned int i = 0; i < signatures.size(); i++)
+            keys[i] = make_pair(signatures[i][band], i);
+        sort(keys.begin(),
+             keys.end(),
+             [&precursorMzs](const pair<uint8_t, unsigned int>& a,
+                             const pair<uint8_t, unsigned int>& b) {
+                 if (a.first != b.first)
+                     return a.first < b.first;
+                 return precursorMzs[a.second] < precursorMzs[b.second];
+             });
+
+        for (size_t k = 0; k < keys.size(); k++) {
+            unsigned int i = keys[k].second;
+            float mzmax = precursorMzs[i] * (1 + _precursorPpm / 1e6);
+            for (size_t l = k + 1; l < keys.size(); l++) {
+                if (keys[l].first != keys[k].first)
+                    break;
+                unsigned int j = keys[l].second;
+                if (precursorMzs[j] > mzmax)
+                    break;
+
+                unsigned int first = min(i, j);
+                unsigned int second = max(i, j);
+                uint64_t pairKey = (static_cast<uint64_t>(first) << 32)
+                                   | second;
+                if (seen.insert(pairKey).second)
+                    pairs.push_back(make_pair(first, second));
+            }
+        }
+    }
+
+    sort(pairs.begin(), pairs.end());
+    return pairs;
+}
+
+void SpectraClustering::cluster(const vector<mzSample*>& samples,
+                                float minFractionalIntensity,
+                                float minSigNoiseRatio,
+                                int maxFragmentSize)
+{
+    _clear();
+
+    vector<Scan*> scans;
+    for (auto sample : samples) {
+        for (auto scan : sample->scans) {
+            if (scan->mslevel == 2)
+                scans.push_back(scan);
+        }
+    }
+
+    vector<Fragment*> fragments(scans.size());
+    vector<vector<uint8_t>> signatures(scans.size());
+    vector<float> precursorMzs(scans.size());
+
+    #pragma omp parallel for schedule(dynamic, 64)
+    for (int i = 0; i < static_cast<int>(scans.size()); i++) {
+        fragments[i] = new Fragment(scans[i],
+                                    minFractionalIntensity,
+                                    minSigNoiseRatio,
+                                    maxFragmentSize);
+        signatures[i] = _signature(fragments[i]);
+        precursorMzs[i] = scans[i]->precursorMz;
+    }
+
+    // score candidates exactly; pairs already in the same cluster need not
+    // be scored again since linking them would not change the clusters
+    DisjointSets sets(scans.size());
+    for (auto& pair : _candidatePairs(signatures, precursorMzs)) {
+        if (sets.find(pair.first) == sets.find(pair.second))
+            continue;
+
+        // score from the smaller spectrum, as the library side
+        Fragment* a = fragments[pair.first];
+        Fragment* b = fragments[pair.second];
+        if (b->nobs() < a->nobs())
+            swap(a, b);
+        FragmentationMatchScore score = a->scoreMatch(b,
+                                                      _productPpm,
+                                                      _scoringAlgo);
+        _scoredPairs++;
+        if (score.mergedScore >= _minScore)
+            sets.join(pair.first, pair.second);
+    }
+
+    // the first spectrum of every cluster holds the others as brothers
+    map<unsigned int, unsigned int> clusterIndex;
+    for (unsigned int i = 0; i < scans.size(); i++) {
+        unsigned int root = sets.find(i);
+        auto itr = clusterIndex.find(root);
+        if (itr == clusterIndex.end()) {
+            clusterIndex[root] = _clusters.size();
+            _clusters.push_back(fragments[i]);
+            _clusterScans.push_back(vector<Scan*>(1, scans[i]));
+        } else {
+            _clusters[itr->second]->addBrotherFragment(fragments[i]);
+            _clusterScans[itr->second].push_back(scans[i]);
+        }
+    }
+
+    #pragma omp parallel for schedule(dynamic)
+    for (int c = 0; c < static_cast<int>(_clusters.size()); c++) {
+        _clusters[c]->buildConsensus(_productPpm);
+        _clusters[c]->consensus->sortByMz();
+    }
+}
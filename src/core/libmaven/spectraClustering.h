@@ -0,0 +1,117 @@
+#ifndef SPECTRACLUSTERING_H
+#define SPECTRACLUSTERING_H
+
+#include <stdint.h>
+
+#include "standardincludes.h"
+
+class Fragment;
+class mzSample;
+class Scan;
+
+using namespace std;
+
+/**
+ * @brief Clusters MS2 spectra of many samples by precursor m/z and fragment
+ * similarity, and builds a consensus spectrum for every cluster.
+ *
+ * @details Comparing every pair of spectra quickly becomes infeasible for
+ * large DDA cohorts, so candidate pairs are found with locality-sensitive
+ * hashing first. Each spectrum is binned at nominal mass resolution and
+ * reduced to a signature of random hyperplane projections (SimHash), where
+ * the probability of two signature bits agreeing grows with the cosine
+ * similarity of the binned spectra. Signatures are split into 8-bit bands,
+ * as many as needed for pairs at the minimum score to share a band with
+ * 99% probability, and only spectra sharing a band, and whose precursors are within the precursor
+ * tolerance, are scored exactly with Fragment::scoreMatch. Spectra scoring at
+ * least the minimum score are linked, and clusters are the connected
+ * components of these links.
+ *
+ * Clusters own their fragments: the first spectrum of a cluster holds all
+ * other spectra as brothers, along with the consensus built from them.
+ *
+ * This is a library API for now; neither the GUI nor peakdetector call it.
+ */
+class SpectraClustering
+{
+  public:
+    /**
+     * @brief Constructor of class SpectraClustering.
+     * @param precursorPpm Tolerance for precursor m/z of spectra in the same
+     * cluster.
+     * @param productPpm Tolerance for fragment m/z used for scoring and for
+     * building consensus spectra.
+     * @param minScore Minimum score for two spectra to be linked.
+     * @param scoringAlgo Score used for linking, any of
+     * FragmentationMatchScore::getScoringAlgorithmNames.
+     */
+    SpectraClustering(float precursorPpm = 10,
+                      float productPpm = 20,
+                      float minScore = 0.7,
+                      string scoringAlgo = "DotProduct");
+
+    ~SpectraClustering();
+
+    /**
+     * @brief Cluster all MS2 scans of the given samples. Clusters from a
+     * previous call are discarded.
+     * @param samples Samples whose MS2 scans are to be clustered.
+     * @param minFractionalIntensity Fragment peaks below this fraction of
+     * the base peak are ignored.
+     * @param minSigNoiseRatio Fragment peaks below this S/N are ignored.
+     * @param maxFragmentSize Maximum number of peaks kept per spectrum.
+     */
+    void cluster(const vector<mzSample*>& samples,
+                 float minFractionalIntensity = 0.05,
+                 float minSigNoiseRatio = 0,
+                 int maxFragmentSize = 25);
+
+    /**
+     * @brief Clusters of the last call to cluster. The consensus of each
+     * cluster is available as its consensus member.
+     */
+    inline const vector<Fragment*>& clusters() const { return _clusters; }
+
+    /**
+     * @brief Scans of each cluster, in the same order as clusters.
+     */
+    inline const vector<vector<Scan*>>& clusterScans() const
+    {
+        return _clusterScans;
+    }
+
+    /**
+     * @brief Number of pairs scored exactly in the last call to cluster.
+     */
+    inline size_t scoredPairs() const { return _scoredPairs; }
+
+  private:
+    float _precursorPpm;
+    float _productPpm;
+    float _minScore;
+    string _scoringAlgo;
+
+    vector<Fragment*> _clusters;
+    vector<vector<Scan*>> _clusterScans;
+    size_t _scoredPairs;
+
+    int _numBands;
+
+    /**
+     * @brief SimHash signature of a spectrum's binned intensities, as one
+     * bucket per band.
+     */
+    vector<uint8_t> _signature(Fragment* fragment) const;
+
+    /**
+     * @brief Pairs of spectra sharing at least one signature band and
+     * having precursors within tolerance, as (i, j) with i < j.
+     */
+    vector<pair<unsigned int, unsigned int>> _candidatePairs(
+        const vector<vector<uint8_t>>& signatures,
+        const vector<float>& precursorMzs) const;
+
+    void _clear();
+};
+
+#endif // SPECTRACLUSTERING_H
@@ -0,0 +1,244 @@
+#include "masscutofftype.h"
+#include "mzSample.h"
+#include "mzUtils.h"
+#include "Scan.h"
+#include "spectralSearch.h"
+
+namespace {
+    /**
+     * @brief A peak near one of the query's fragments.
+     */
+    struct FragmentMatch
+    {
+        unsigned int scan;
+        unsigned int fragment;
+        float intensity;
+    };
+
+    bool compScanFragment(const FragmentMatch& a, const FragmentMatch& b)
+    {
+        if (a.scan != b.scan)
+            return a.scan < b.scan;
+        return a.fragment < b.fragment;
+    }
+
+    bool compScore(const SpectralSearchHit& a, const SpectralSearchHit& b)
+    {
+        return a.score > b.score;
+    }
+}
+
+SpectralSearch::SpectralSearch(const vector<mzSample*>& samples,
+                               int msLevel,
+                               float binWidth)
+{
+    _binWidth = binWidth;
+    _minMz = FLT_MAX;
+    float maxMz = 0;
+    size_t peakCount = 0;
+
+    for (auto sample : samples) {
+        for (auto scan : sample->scans) {
+            if (msLevel > 0 && scan->mslevel != msLevel)
+                continue;
+            _scans.push_back(scan);
+            _totalIntensities.push_back(scan->totalIntensity());
+            peakCount += scan->nobs();
+            for (auto mz : scan->mz) {
+                _minMz = min(_minMz, mz);
+                maxMz = max(maxMz, mz);
+            }
+        }
+    }
+
+    // precursor index
+    vector<unsigned int> order(_scans.size());
+    for (unsigned int i = 0; i < order.size(); i++)
+        order[i] = i;
+    sort(order.begin(), order.end(), [this](unsigned int a, unsigned int b) {
+        return _scans[a]->precursorMz < _scans[b]->precursorMz;
+    });
+    _precursorMzs.reserve(order.size());
+    _precursorScans.reserve(order.size());
+    for (auto i : order) {
+        _precursorMzs.push_back(_scans[i]->precursorMz);
+        _precursorScans.push_back(i);
+    }
+
+    if (peakCount == 0) {
+        _minMz = 0;
+        _binOffsets.assign(1, 0);
+        return;
+    }
+
+    // fragment index, filled with a counting sort so that postings of each
+    // bin are ordered by scan and then by m/z
+    size_t binCount = _bin(maxMz) + 1;
+    _binOffsets.assign(binCount + 1, 0);
+    for (auto scan : _scans) {
+        for (auto mz : scan->mz)
+            _binOffsets[_bin(mz) + 1]++;
+    }
+    for (size_t b = 0; b < binCount; b++)
+        _binOffsets[b + 1] += _binOffsets[b];
+
+    _postingScans.resize(peakCount);
+    _postingMzs.resize(peakCount);
+    _postingIntensities.resize(peakCount);
+    vector<size_t> next(_binOffsets.begin(), _binOffsets.end() - 1);
+    for (unsigned int i = 0; i < _scans.size(); i++) {
+        Scan* scan = _scans[i];
+        for (unsigned int k = 0; k < scan->nobs(); k++) {
+            size_t pos = next[_bin(scan->mz[k])]++;
+            _postingScans[pos] = i;
+            _postingMzs[pos] = scan->mz[k];
+            _postingIntensities[pos] = scan->intensity[k];
+        }
+    }
+}
+
+long SpectralSearch::_bin(float mz) const
+{
+    return static_cast<long>(floor((mz - _minMz) / _binWidth));
+}
+
+vector<unsigned int> SpectralSearch::_precursorMatches(
+    float precursorMz,
+    MassCutoff* precursorCutoff) const
+{
+    // candidates are taken from a slightly wider window and then checked
+    // with the exact distance
+    double tolerance = precursorCutoff->massCutoffValue(precursorMz) * 1.01;
+    auto first = lower_bound(_precursorMzs.begin(),
+                             _precursorMzs.end(),
+                             precursorMz - tolerance);
+    auto last = upper_bound(_precursorMzs.begin(),
+                            _precursorMzs.end(),
+                            precursorMz + tolerance);
+
+    vector<unsigned int> matches;
+    for (auto it = first; it != last; it++) {
+        double dist = mzUtils::massCutoffDist((double)precursorMz,
+                                              (double)*it,
+                                              precursorCutoff);
+        if (dist > precursorCutoff->getMassCutoff())
+            continue;
+        matches.push_back(_precursorScans[it - _precursorMzs.begin()]);
+    }
+    sort(matches.begin(), matches.end());
+    return matches;
+}
+
+vector<SpectralSearchHit> SpectralSearch::search(const SpectralQuery& query,
+                                                 MassCutoff* precursorCutoff,
+                                                 MassCutoff* productCutoff,
+                                                 int minMatches) const
+{
+    vector<SpectralSearchHit> hits;
+    unsigned int numFragments = query.mzs.size();
+    if (numFragments == 0 || _postingMzs.empty())
+        return hits;
+
+    bool checkPrecursor = query.precursorMz > 0;
+    vector<unsigned int> precursorMatches;
+    if (checkPrecursor) {
+        precursorMatches = _precursorMatches(query.precursorMz,
+                                             precursorCutoff);
+        if (precursorMatches.empty())
+            return hits;
+    }
+
+    // collect all peaks near each of the fragments
+    long binCount = _binOffsets.size() - 1;
+    vector<FragmentMatch> matches;
+    for (unsigned int i = 0; i < numFragments; i++) {
+        float mz = query.mzs[i];
+        float mzmin = mz - productCutoff->massCutoffValue(mz);
+        float mzmax = mz + productCutoff->massCutoffValue(mz);
+        long firstBin = max(0L, _bin(mzmin));
+        long lastBin = min(binCount - 1, _bin(mzmax));
+        for (long b = firstBin; b <= lastBin; b++) {
+            for (size_t p = _binOffsets[b]; p < _binOffsets[b + 1]; p++) {
+                float peakMz = _postingMzs[p];
+                if (peakMz < mzmin || peakMz > mzmax)
+                    continue;
+                unsigned int scan = _postingScans[p];
+                if (checkPrecursor
+                    && !binary_search(precursorMatches.begin(),
+                                      precursorMatches.end(),
+                                      scan))
+                    continue;
+                matches.push_back(
+                    FragmentMatch{scan, i, _postingIntensities[p]});
+            }
+        }
+    }
+
+    // peaks of a scan are visited in m/z order, so a stable sort keeps the
+    // first of equally intense peaks, just like Scan::findHighestIntensityPos
+    stable_sort(matches.begin(), matches.end(), compScanFragment);
+
+    bool hasIntensities = !query.intensities.empty();
+    vector<float> matchedIntensities(numFragments);
+    size_t m = 0;
+    while (m < matches.size()) {
+        unsigned int scan = matches[m].scan;
+        fill(matchedIntensities.begin(), matchedIntensities.end(), 0.0f);
+        for (; m < matches.size() && matches[m].scan == scan; m++) {
+            float& best = matchedIntensities[matches[m].fragment];
+            if (matches[m].intensity > best)
+                best = matches[m].intensity;
+        }
+
+        float score = 0;
+        int matchCount = 0;
+        vector<float> x;
+        vector<float> y;
+        for (unsigned int i = 0; i < numFragments; i++) {
+            if (matchedIntensities[i] > 0) {
+                matchCount++;
+                if (!hasIntensities) {
+                    score += log(matchedIntensities[i]);
+                } else {
+                    x.push_back(query.intensities[i]);
+                    y.push_back(matchedIntensities[i]
+                                / _totalIntensities[scan]);
+                }
+            } else {
+                if (!hasIntensities) {
+                    score--;
+                } else {
+                    x.push_back(query.intensities[i]);
+                    y.push_back(-query.intensities[i]);
+                }
+            }
+        }
+
+        if (hasIntensities)
+            score = mzUtils::correlation(x, y);
+
+        if (score > 0 && matchCount > minMatches)
+            hits.push_back(SpectralSearchHit{0, _scans[scan], score, matchCount});
+    }
+
+    stable_sort(hits.begin(), hits.end(), compScore);
+    return hits;
+}
+
+vector<vector<SpectralSearchHit>> SpectralSearch::search(
+    const vector<SpectralQuery>& queries,
+    MassCutoff* precursorCutoff,
+    MassCutoff* productCutoff,
+    int minMatches) const
+{
+    vector<vector<SpectralSearchHit>> hits(queries.size());
+
+    #pragma omp parallel for schedule(dynamic)
+    for (int q = 0; q < static_cast<int>(queries.size()); q++) {
+        hits[q] = search(queries[q], precursorCutoff, productCutoff, minMatches);
+        for (auto& hit : hits[q])
+            hit.queryIndex = q;
+    }
+
+    return hits;
+}
@@ -0,0 +1,150 @@
+#ifndef SPECTRALSEARCH_H
+#define SPECTRALSEARCH_H
+
+#include "standardincludes.h"
+
+class MassCutoff;
+class mzSample;
+class Scan;
+
+using namespace std;
+
+/**
+ * @brief A fragment pattern to be searched for in the indexed spectra.
+ */
+struct SpectralQuery
+{
+    /**
+     * @brief Precursor m/z that matching scans must have. Set to zero to
+     * match scans regardless of their precursor.
+     */
+    float precursorMz = 0;
+
+    /**
+     * @brief m/z values of the fragments.
+     */
+    vector<float> mzs;
+
+    /**
+     * @brief Expected intensities of the fragments, either empty or of the
+     * same size as mzs.
+     */
+    vector<float> intensities;
+};
+
+/**
+ * @brief A scan matching a query.
+ */
+struct SpectralSearchHit
+{
+    /**
+     * @brief Index of the matched query in the batch.
+     */
+    size_t queryIndex;
+
+    Scan* scan;
+
+    float score;
+
+    /**
+     * @brief Number of query fragments found in the scan.
+     */
+    int matchCount;
+};
+
+/**
+ * @brief Searches fragment patterns across the spectra of many samples.
+ *
+ * @details Two indices are built over all scans of the selected MS level:
+ * one of precursor m/z values, sorted, and an inverted index mapping m/z bins
+ * to the (scan, m/z, intensity) triplets of all peaks falling into them.
+ * A query then only looks at peaks near its fragments, instead of scanning
+ * every spectrum. Since a scan needs at least one matching fragment to score
+ * positively, no hits are lost by not visiting the remaining scans.
+ *
+ * Scans are scored the same way as the fragment search of the spectra
+ * matching dialog: if the query has no intensities, the score is the sum of
+ * log intensities of matched fragments minus one for every missing fragment;
+ * otherwise it is the correlation between expected intensities and matched
+ * intensities relative to the scan's total intensity (with missing fragments
+ * counted as negative expected intensities).
+ *
+ * The index keeps pointers to the samples' scans, so it must not outlive
+ * them. Searches only read from the index and may run concurrently.
+ */
+class SpectralSearch
+{
+  public:
+    /**
+     * @brief Index the scans of the given samples.
+     * @param samples Samples whose scans are to be indexed.
+     * @param msLevel Only scans of this MS level are indexed. Zero indexes
+     * scans of all levels.
+     * @param binWidth Width of m/z bins of the fragment index, in Da.
+     */
+    SpectralSearch(const vector<mzSample*>& samples,
+                   int msLevel,
+                   float binWidth = 0.1);
+
+    /**
+     * @brief Find scans matching a query.
+     * @param query Fragment pattern to be searched.
+     * @param precursorCutoff Tolerance for precursor m/z.
+     * @param productCutoff Tolerance for fragment m/z.
+     * @param minMatches Scans need more than these many matching fragments
+     * to be reported.
+     * @return Hits with a positive score, best scoring first.
+     */
+    vector<SpectralSearchHit> search(const SpectralQuery& query,
+                                     MassCutoff* precursorCutoff,
+                                     MassCutoff* productCutoff,
+                                     int minMatches) const;
+
+    /**
+     * @brief Find scans matching each of a batch of queries. Queries are
+     * searched in parallel.
+     * @return Hits for each query, in the order of queries.
+     */
+    vector<vector<SpectralSearchHit>> search(
+        const vector<SpectralQuery>& queries,
+        MassCutoff* precursorCutoff,
+        MassCutoff* productCutoff,
+        int minMatches) const;
+
+    /**
+     * @brief Number of indexed scans.
+     */
+    inline size_t scanCount() const { return _scans.size(); }
+
+  private:
+    float _binWidth;
+    float _minMz;
+
+    vector<Scan*> _scans;
+    vector<float> _totalIntensities;
+
+    // precursor m/z of scans, sorted, along with the scan each belongs to
+    vector<float> _precursorMzs;
+    vector<unsigned int> _precursorScans;
+
+    // inverted fragment index; postings of bin b are stored in the range
+    // [_binOffsets[b], _binOffsets[b + 1])
+    vector<size_t> _binOffsets;
+    vector<unsigned int> _postingScans;
+    vector<float> _postingMzs;
+    vector<float> _postingIntensities;
+
+    /**
+     * @brief Bin of the fragment index that an m/z value falls into.
+     */
+    long _bin(float mz) const;
+
+    /**
+     * @brief Sorted indices of scans whose precursor matches the query's,
+     * used to restrict the fragment search.
+     */
+    vector<unsigned int> _precursorMatches(float precursorMz,
+                                           MassCutoff* precursorCutoff) const;
+};
+
+#endif // SPECTRALSEARCH_H
@@ -158,6 +158,7 @@ void AlignmentDialog::restorDefaultValues(bool checked)
 	gapExtend->setValue(3.4);
 	gapInit->setValue(0.2);
 	binSizeObiWarp->setValue(0.6);
+	maxRtShiftObiWarp->setValue(0);
 	responseObiWarp->setValue(20);
 	noStdNormal->setChecked(false);
 	local->setChecked(false);
@@ -176,7 +177,8 @@ void AlignmentDialog::showAdvanceParameters(bool checked)
 
 void AlignmentDialog::algoChanged()
 {
-    bool obiWarp = (alignAlgo->currentIndex() == 0);
+    // only Poly-fit can align samples without MS1 scans
+    bool polyFit = (alignAlgo->currentIndex() == 1);
     showAdvanceParameters(showAdvanceParams->isChecked());
 
     auto samples = _mw->getSamples();
@@ -189,7 +191,7 @@ void AlignmentDialog::algoChanged()
             break;
         }
     }
-    if (!mrmData || !obiWarp) {
+    if (!mrmData || polyFit) {
         alignButton->setDisabled(false);
         setProgressBar("Status", 0, 1);
     }
@@ -16,6 +16,7 @@
 #include "database.h"
 #include "grouprtwidget.h"
 #include "isotopeDetection.h"
+#include "landmarkAligner.h"
 #include "mainwindow.h"
 #include "masscutofftype.h"
 #include "mavenparameters.h"
@@ -284,6 +285,8 @@ void BackgroundPeakUpdate::run(void) {
                 computePeaks();
         } else if(runFunction == "alignWithObiWarp" ){
                 alignWithObiWarp();
+        } else if (runFunction == "alignWithLandmarks") {
+                alignWithLandmarks();
         } else {
                 qDebug() << "Unknown Function " << runFunction.c_str();
         }
@@ -302,17 +305,46 @@ void BackgroundPeakUpdate::alignWithObiWarp()
                                          mainwindow->alignmentDialog->initPenalty->value(),
                                          mainwindow->alignmentDialog->responseObiWarp->value(),
                                          mainwindow->alignmentDialog->noStdNormal->isChecked(),
-                                         mainwindow->alignmentDialog->binSizeObiWarp->value());
+                                         mainwindow->alignmentDialog->binSizeObiWarp->value(),
+                                         mainwindow->alignmentDialog->maxRtShiftObiWarp->value());
 
     Q_EMIT(updateProgressBar("Aligning samples…", 0, 100));
 
     Aligner aligner;
+    aligner.setAlignmentState(mainwindow->alignmentState);
     aligner.setAlignmentProgress.connect(boost::bind(&BackgroundPeakUpdate::qtSlot,
                                                      this, _1, _2, _3));
 
     _stopped = aligner.alignWithObiWarp(mavenParameters->samples, obiParams, mavenParameters);
     delete obiParams;
 
+    finishAlignment();
+}
+
+void BackgroundPeakUpdate::alignWithLandmarks()
+{
+    LandmarkAligner landmarkAligner(
+        mainwindow->alignmentDialog->maxLandmarks->value(),
+        mainwindow->alignmentDialog->landmarkPpm->value(),
+        mainwindow->alignmentDialog->maxRtShiftLandmarks->value(),
+        mainwindow->alignmentDialog->landmarkRtTolerance->value());
+
+    Q_EMIT(updateProgressBar("Aligning samples…", 0, 100));
+
+    Aligner aligner;
+    aligner.setAlignmentState(mainwindow->alignmentState);
+    aligner.setAlignmentProgress.connect(boost::bind(&BackgroundPeakUpdate::qtSlot,
+                                                     this, _1, _2, _3));
+
+    _stopped = aligner.alignWithLandmarks(mavenParameters->samples,
+                                          landmarkAligner,
+                                          mavenParameters);
+
+    finishAlignment();
+}
+
+void BackgroundPeakUpdate::finishAlignment()
+{
     if (_stopped) {
         Q_EMIT(restoreAlignment());
         //restore previous RTs
@@ -152,6 +152,13 @@ private:
 	void align();
 	void alignUsingDatabase();
 	void alignWithObiWarp();
+	void alignWithLandmarks();
+
+	/**
+	 * [restore retention times if alignment was stopped, otherwise plot
+	 * the aligned samples]
+	 */
+	void finishAlignment();
 
 	/**
 	 * [write CSV Report]
@@ -32,6 +32,7 @@
 #include "masscutofftype.h"
 #include "mavenparameters.h"
 #include "messageBoxResize.h"
+#include "mzAligner.h"
 #include "mzfileio.h"
 #include "mzSample.h"
 #include "note.h"
@@ -224,6 +225,7 @@ using namespace mzUtils;
 
 	clsf = new ClassifierNeuralNet();    //clsf = new ClassifierNaiveBayes();
 		mavenParameters = new MavenParameters(QString(QStandardPaths::writableLocation(QStandardPaths::GenericConfigLocation) + QDir::separator() + "lastRun.xml").toStdString());
+	mavenParameters->alignmentCacheDir = QString(QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QDir::separator() + "El-MAVEN" + QDir::separator() + "alignments").toStdString();
 	_massCutoffWindow = new MassCutoff();
 
 
@@ -442,6 +444,7 @@ using namespace mzUtils;
 
 	//alignment dialog
 	alignmentDialog = new AlignmentDialog(this);
+	alignmentState = new AlignmentState();
 	alignmentDialog->setMainWindow(this);
 	connect(alignmentDialog->alignButton, SIGNAL(clicked()), SLOT(Align()));
 	connect(alignmentDialog->UndoAlignment, SIGNAL(clicked()),
@@ -730,6 +733,7 @@ MainWindow::~MainWindow()
 {
 	analytics->sessionEnd();
     delete mavenParameters;
+    delete alignmentState;
 }
 
 void MainWindow::saveSettingsToLog() {
@@ -3310,9 +3314,17 @@ void MainWindow::Align()
 
     BackgroundPeakUpdate* workerThread;
 
-    if (alignmentDialog->alignAlgo->currentIndex() == 0) {
-        analytics->hitEvent("Alignment", "Obi-Warp");
-        workerThread = newWorkerThread("alignWithObiWarp");
+    // OBI-Warp and landmark alignment work on the samples' scans directly,
+    // without detecting groups first
+    int alignAlgo = alignmentDialog->alignAlgo->currentIndex();
+    if (alignAlgo == 0 || alignAlgo == 2) {
+        if (alignAlgo == 0) {
+            analytics->hitEvent("Alignment", "Obi-Warp");
+            workerThread = newWorkerThread("alignWithObiWarp");
+        } else {
+            analytics->hitEvent("Alignment", "Landmarks");
+            workerThread = newWorkerThread("alignWithLandmarks");
+        }
         workerThread->setMavenParameters(mavenParameters);
         alignmentDialog->setWorkerThread(workerThread);
         connect(workerThread,
@@ -28,6 +28,7 @@ class PeakDetectionDialog;
 class PollyElmavenInterfaceDialog;
 class AwsBucketCredentialsDialog;
 class AlignmentDialog;
+class AlignmentState;
 class SpectraWidget;
 class GroupRtWidget;
 class AlignmentVizAllGroupsWidget;
@@ -162,6 +163,11 @@ public:
 	PollyElmavenInterfaceDialog *pollyElmavenInterfaceDialog;
 	AwsBucketCredentialsDialog *awsBucketCredentialsDialog;
 	AlignmentDialog* alignmentDialog;
+
+	// kept between alignments, so that samples added later are aligned
+	// on their own; cleared when samples are removed
+	AlignmentState* alignmentState;
+
 	// RconsoleWidget* rconsoleDockWidget;
 	mzFileIO*             fileLoader; //TODO: Sahil, Added while merging projectdockwidget
     //Added when merged with Maven776 - Kiran
@@ -199,7 +199,9 @@ void MassCalcWidget::setPeakGroup(PeakGroup* grp) {
 
         if(grp->fragmentationPattern.nobs() != 0) {
             m->fragScore = cpd->scoreCompoundHit(&(grp->fragmentationPattern),
-                                                 fragPpm->value());
+                                                 fragPpm->value(),
+                                                 false,
+                                                 "HyperGeomScore");
         }
 
         if (cpd->expectedRt > 0)
@@ -224,8 +226,10 @@ void MassCalcWidget::setFragmentationScan(Scan* scan) {
 
     for(auto& m : matches ) {
         Compound* cpd = m->compoundLink;
-        m->fragScore = cpd->scoreCompoundHit(&f, fragPpm->value(), false);
-        m->fragScore.mergedScore = m->fragScore.hypergeomScore;
+        m->fragScore = cpd->scoreCompoundHit(&f,
+                                             fragPpm->value(),
+                                             false,
+                                             "HyperGeomScore");
     }
     showTable();
 }
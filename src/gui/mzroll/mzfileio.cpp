@@ -397,6 +397,7 @@ mzSample* mzFileIO::parseMzData(QString fileName) {
     }
 
     data.close();
+    if (currentSample) currentSample->linkMs2Scans();
     return currentSample;
 }
 
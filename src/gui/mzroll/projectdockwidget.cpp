@@ -11,12 +11,14 @@
 #include "ligandwidget.h"
 #include "mainwindow.h"
 #include "mavenparameters.h"
+#include "mzAligner.h"
 #include "mzfileio.h"
 #include "mzSample.h"
 #include "numeric_treewidgetitem.h"
 #include "projectdockwidget.h"
 #include "Scan.h"
 #include "samplertwidget.h"
+#include "spectramatching.h"
 #include "spectrawidget.h"
 #include "tabledockwidget.h"
 #include "treedockwidget.h"
@@ -343,6 +345,9 @@ void ProjectDockWidget::unloadSelectedSamples() {
       QList<QTreeWidgetItem*>selected = _treeWidget->selectedItems();
       if(selected.size() == 0) return;
 
+      //the spectral search index points into the scans of these samples
+      _mainwindow->spectraMatchingForm->clearIndex();
+
      //reverse loop as size will decrease on deleting sample
      for (int index = selected.size() - 1; index >= 0; --index)
       {
@@ -933,6 +938,9 @@ void ProjectDockWidget::unloadSample(mzSample* sample) {
     sample->isSelected=false;
     delete_all(sample->scans);
 
+    //earlier alignments may have used this sample as their reference
+    _mainwindow->alignmentState->clear();
+
     QList< QPointer<TableDockWidget> > peaksTableList = _mainwindow->getPeakTableList();
     peaksTableList.prepend(_mainwindow->getBookmarkedPeaks());
     TableDockWidget* peaksTable;
@@ -122,7 +122,8 @@ void SampleRtWidget::plotIndividualGraph(mzSample* sample)
     if(alignAlgo == 1)
         prepareGraphDataPolyFit(xAxis, yAxis, sample);
 
-    if(alignAlgo == 0)
+    // landmark alignment shifts scans the same way OBI-Warp does
+    if(alignAlgo == 0 || alignAlgo == 2)
         prepareGraphDataObiWarp(xAxis, yAxis, sample);
 
     if(!xAxis.isEmpty() && !yAxis.isEmpty()){
@@ -4,6 +4,7 @@
 #include "mzUtils.h"
 #include "numeric_treewidgetitem.h"
 #include "Scan.h"
+#include "spectralSearch.h"
 #include "spectramatching.h"
 #include "spectrawidget.h"
 
@@ -15,6 +16,18 @@ SpectraMatching::SpectraMatching(MainWindow *w): QDialog(w) {
     connect(exportButton, SIGNAL(clicked(bool)), SLOT(exportMatches()));
     resultTable->setSortingEnabled(true);
     bound_checking_pattern=false;
+    _index = nullptr;
+    _indexedScanType = -1;
+}
+
+SpectraMatching::~SpectraMatching() {
+    delete _index;
+}
+
+void SpectraMatching::clearIndex() {
+    delete _index;
+    _index = nullptr;
+    _indexedSamples.clear();
 }
 
 void SpectraMatching::findMatches() { 
@@ -149,22 +162,19 @@ void SpectraMatching::doSearch() {
 
     QString _algorithm = this->algorithm->currentText();
 
-    for(int i=0; i < samples.size(); i++) {
-        int nscans = samples[i]->scanCount();
-        for(int j=0; j< nscans; j++) {
-            Scan* scan = samples[i]->scans[j];
-	    //if (scan->scannum != 7925) continue;
-            double score=0;
-            if(_algorithm == "Isotopic Pattern Search") {
-               score = matchPattern(scan);
-            } else if ( _algorithm == "Fragment Search") {
-               score = scoreScan(scan);
+    if (_algorithm == "Fragment Search") {
+        findFragments(samples);
+    } else if (_algorithm == "Isotopic Pattern Search") {
+        for(int i=0; i < samples.size(); i++) {
+            int nscans = samples[i]->scanCount();
+            for(int j=0; j< nscans; j++) {
+                Scan* scan = samples[i]->scans[j];
+                matchPattern(scan);
+
+                //update progress
+                if(j % 10 || j+1 == nscans) progressBar->setValue((j+1)/nscans*100);
             }
-
-            //update progress
-            if(j % 10 || j+1 == nscans) progressBar->setValue((j+1)/nscans*100);
         }
-
     }
 
     for(int i=0; i <matches.size(); i++ ) {
@@ -222,48 +232,40 @@ void SpectraMatching::addHit(double score, float precursormz, QString samplename
        matches.push_back(hit);
 }
 
-double SpectraMatching::scoreScan(Scan* scan) {
-
-    if (_msScanType  > 0 && scan->mslevel != _msScanType) return 0;
-    if (_precursorMz > 0 && mzUtils::massCutoffDist(_precursorMz,(double)scan->precursorMz,_precursorMassCutoff) > _precursorMassCutoff->getMassCutoff()) return 0;
-
-   float score=0;
-   int matchCount=0;
-   int N = _mzsList.size();
-   int Nc = _intensityList.size();
-   int minMatches = minPeakMatches->value();
-
-   float totalIntensity = scan->totalIntensity();
-
-
-   QVector<float> x;
-   QVector<float> y;
-   for(int i=0; i < N; i++ ) {
-       int pos = scan->findHighestIntensityPos(_mzsList[i],_productMassCutoff);
-       if (pos >= 0) {
-           matchCount++;
-            if(Nc==0) { score += log(scan->intensity[pos]); }
-            else { 
-                x.push_back(_intensityList[i]); 
-                y.push_back(scan->intensity[pos]/totalIntensity); 
-            }
-       } else { 
-            if(Nc==0) { score--; } 
-            else { 
-                x.push_back(_intensityList[i]); 
-                y.push_back(-_intensityList[i]);
-            }
-      }
-   }
-
-   if(Nc) score=mzUtils::correlation(x.toStdVector(),y.toStdVector());
+SpectralSearch* SpectraMatching::spectralIndex(vector<mzSample*>& samples) {
+    //samples are identified along with their scan counts, so that a sample
+    //reloaded at the same address is not mistaken for an indexed one
+    vector<pair<mzSample*, size_t>> indexedSamples;
+    for(auto sample : samples) indexedSamples.push_back(make_pair(sample, sample->scans.size()));
+
+    if (_index == nullptr || indexedSamples != _indexedSamples || _msScanType != _indexedScanType) {
+        delete _index;
+        _index = new SpectralSearch(samples, _msScanType);
+        _indexedSamples = indexedSamples;
+        _indexedScanType = _msScanType;
+    }
+    return _index;
+}
 
-   if (score > 0 and matchCount > minMatches ) {
-       QString sampleName(scan->sample->sampleName.c_str());
-       float precursorMz = _mzsList[0];
-       addHit(score,precursorMz,sampleName,matchCount,scan,_mzsList,_intensityList);
-   }
-   return score;
+void SpectraMatching::findFragments(vector<mzSample*>& samples) {
+    const SpectralSearch& index = *spectralIndex(samples);
+    progressBar->setValue(50);
+
+    SpectralQuery query;
+    query.precursorMz = _precursorMz;
+    for(int i=0; i < _mzsList.size(); i++) query.mzs.push_back(_mzsList[i]);
+    for(int i=0; i < _intensityList.size(); i++) query.intensities.push_back(_intensityList[i]);
+
+    vector<SpectralSearchHit> hits = index.search(query,
+                                                  _precursorMassCutoff,
+                                                  _productMassCutoff,
+                                                  minPeakMatches->value());
+    for(auto& hit : hits) {
+        QString sampleName(hit.scan->sample->sampleName.c_str());
+        float precursorMz = _mzsList[0];
+        addHit(hit.score,precursorMz,sampleName,hit.matchCount,hit.scan,_mzsList,_intensityList);
+    }
+    progressBar->setValue(100);
 }
 
 double SpectraMatching::matchPattern(Scan* scan) {
@@ -8,12 +8,16 @@
 class MainWindow;
 class Scan;
 class MassCutoff;
+class mzSample;
+class SpectralSearch;
 
 class SpectraMatching : public QDialog, public Ui_SpectraMatchingForm
 {
     Q_OBJECT
     public:
         SpectraMatching(MainWindow *w);
+        ~SpectraMatching();
+        void clearIndex(); //drop the index, needed before indexed samples are deleted
 
         public Q_SLOTS:
         void getFormValues();
@@ -21,7 +25,6 @@ class SpectraMatching : public QDialog, public Ui_SpectraMatchingForm
         void showScan();
         void doSearch();
         void exportMatches();
-        double scoreScan(Scan* scan);
         double matchPattern(Scan* scan);
 
 
@@ -40,6 +43,15 @@ class SpectraMatching : public QDialog, public Ui_SpectraMatchingForm
 	StatisticsVector<float>allscores;
 
         QList<SpectralHit> matches;
+
+        //index over the scans of the last searched samples, kept between
+        //searches and rebuilt only when the samples or the scan type change
+        SpectralSearch* _index;
+        vector<pair<mzSample*, size_t>> _indexedSamples;
+        int _indexedScanType;
+
+        void findFragments(vector<mzSample*>& samples); //indexed search for fragment patterns
+        SpectralSearch* spectralIndex(vector<mzSample*>& samples); //index for the given samples and current scan type
         void addHit(double score, float precursormz, QString samplename, int matchCount, Scan* scan, QVector<double>&mzs, QVector<double>&ints); //add hit to matches
 
 };
@@ -4,6 +4,7 @@
 Cursor::Cursor(sqlite3_stmt* statement)
 {
     _statement = statement;
+    _hasRow = false;
 }
 
 Cursor::~Cursor()
@@ -22,8 +23,8 @@ bool Cursor::execute()
 bool Cursor::next()
 {
     int status = sqlite3_step(_statement);
-    _extractValues();
-    return status == SQLITE_ROW;
+    _hasRow = status == SQLITE_ROW;
+    return _hasRow;
 }
 
 bool Cursor::bind(const std::string& param, int value)
@@ -54,56 +55,76 @@ bool Cursor::bind(const std::string& param, const std::string value)
                              SQLITE_TRANSIENT) == SQLITE_OK;
 }
 
-int Cursor::integerValue(const std::string& param)
+int Cursor::columnIndex(const std::string& name)
+{
+    if (_columnIndexes.empty()) {
+        int columnCount = sqlite3_column_count(_statement);
+        for (int column = 0; column < columnCount; ++column) {
+            auto columnName = sqlite3_column_name(_statement, column);
+            // if name was pointing to NULL
+            if (!columnName)
+                columnName = "";
+
+            // duplicate names refer to the first such column
+            _columnIndexes.emplace(columnName, column);
+        }
+    }
+
+    auto entry = _columnIndexes.find(name);
+    if (entry == _columnIndexes.end())
+        return -1;
+    return entry->second;
+}
+
+int Cursor::integerValue(int column)
 {
-    auto val = _currentResult[param];
-    if (val.empty())
+    if (!_hasRow || column < 0)
         return 0;
-    return std::stoi(val);
+    return sqlite3_column_int(_statement, column);
 }
 
-double Cursor::doubleValue(const std::string& param)
+double Cursor::doubleValue(int column)
 {
-    auto val = _currentResult[param];
-    if (val.empty())
+    if (!_hasRow || column < 0)
         return 0.0;
-    return std::stod(_currentResult[param]);
+    return sqlite3_column_double(_statement, column);
 }
 
-float Cursor::floatValue(const std::string& param)
+float Cursor::floatValue(int column)
 {
-    double dval = doubleValue(param);
+    double dval = doubleValue(column);
     return static_cast<float>(dval);
 }
 
-std::string Cursor::stringValue(const std::string& param)
+std::string Cursor::stringValue(int column)
 {
-    return _currentResult[param];
+    if (!_hasRow || column < 0)
+        return "";
+
+    auto value =
+        reinterpret_cast<const char*>(sqlite3_column_text(_statement, column));
+    // if value was pointing to NULL
+    if (!value)
+        return "";
+    return std::string(value, sqlite3_column_bytes(_statement, column));
 }
 
-void Cursor::_extractValues()
+int Cursor::integerValue(const std::string& param)
 {
-    _currentResult.clear();
-    int valueCount = sqlite3_data_count(_statement);
-
-    while (valueCount) {
-        // column indexing goes from 0 to (valueCount - 1), so decrement first
-        --valueCount;
+    return integerValue(columnIndex(param));
+}
 
-        auto param =
-            reinterpret_cast<const char*>(sqlite3_column_name(_statement,
-                                                              valueCount));
-        // if param was pointing to NULL
-        if (!param)
-            param = "";
+double Cursor::doubleValue(const std::string& param)
+{
+    return doubleValue(columnIndex(param));
+}
 
-        auto value =
-            reinterpret_cast<const char*>(sqlite3_column_text(_statement,
-                                                              valueCount));
-        // if value was pointing to NULL
-        if (!value)
-            value = "";
+float Cursor::floatValue(const std::string& param)
+{
+    return floatValue(columnIndex(param));
+}
 
-        _currentResult[param] = value;
-    }
+std::string Cursor::stringValue(const std::string& param)
+{
+    return stringValue(columnIndex(param));
 }
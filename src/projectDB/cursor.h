@@ -2,7 +2,7 @@
 #define CURSOR_H
 
 #include <iostream>
-#include <map>
+#include <unordered_map>
 #include <sqlite3.h>
 
 class Connection;
@@ -14,6 +14,12 @@ class Connection;
  * database. It hides details of construction, execution, extraction of values
  * and finalization of SQL statements in the SQLite library by providing a
  * simpler C++ interface.
+ *
+ * Values of the current row are read directly from the statement in their
+ * native type. They can be looked up by column name, or by a column index
+ * obtained once from `columnIndex`, which saves resolving the name again for
+ * every row of large result sets. Values of NULL or missing columns read as
+ * zero or an empty string.
  */
 class Cursor
 {
@@ -40,8 +46,7 @@ public:
      * @details While this method, like `execute` also uses the "step" SQLite
      * function, its semantically meant to be used for iterating over rows
      * returned from a suitable SQL operation (most commonly SELECT statements).
-     * Moreover, the `_extracValues` method is called to extract values stored
-     * in current row of the result set.
+     * Values of the current row remain readable until the next call.
      * @return True if the `next` method can be further called upon this Cursor.
      */
     bool next();
@@ -78,6 +83,42 @@ public:
      */
     bool bind(const std::string& param, const std::string value);
 
+    /**
+     * @brief Find the index of a result column.
+     * @param name Name of the column, as given by the statement.
+     * @return Index of the first column with this name, or -1 if the result
+     * has no such column.
+     */
+    int columnIndex(const std::string& name);
+
+    /**
+     * @brief Obtain values for integers in the form of a int type.
+     * @param column Index of the column, from `columnIndex`.
+     * @return Value of the column converted to integer.
+     */
+    int integerValue(int column);
+
+    /**
+     * @brief Obtain values for real numbers in the form of a double type.
+     * @param column Index of the column, from `columnIndex`.
+     * @return Value of the column converted to double.
+     */
+    double doubleValue(int column);
+
+    /**
+     * @brief Obtain values for real numbers in the form of a float type.
+     * @param column Index of the column, from `columnIndex`.
+     * @return Value of the column converted to float.
+     */
+    float floatValue(int column);
+
+    /**
+     * @brief Obtain textual values in the form of a string type.
+     * @param column Index of the column, from `columnIndex`.
+     * @return Value of the column converted to string.
+     */
+    std::string stringValue(int column);
+
     /**
      * @brief Obtain values for integers in the form of a int type.
      * @param param Name of parameter whose value is needed.
@@ -113,10 +154,15 @@ private:
     sqlite3_stmt* _statement;
 
     /**
-     * @brief A map storing values for the current result, in case the query
-     * is of a row returning type (i.e., "SELECT" statements).
+     * @brief Whether the last call to `next` moved to a row whose values can
+     * be read.
      */
-    std::map<std::string, std::string> _currentResult;
+    bool _hasRow;
+
+    /**
+     * @brief Indexes of result columns by name, filled on first lookup.
+     */
+    std::unordered_map<std::string, int> _columnIndexes;
 
     /**
      * @brief Constructor that can only be accessed by friend classes.
@@ -136,15 +182,6 @@ private:
      * Cursor will attempt to destruct it when it is itself destroyed.
      */
     ~Cursor();
-
-    /**
-     * @brief Extract values from the current iteration of result set and store
-     * it in `_currentResult` as a mapping of parameter names to their values
-     * as strings. These values are converted to the corresponding type when
-     * any of the `integerValue`, `doubleValue`, `floatValue` or `stringValue`
-     * methods are called.
-     */
-    void _extractValues();
 };
 
 #endif // CURSOR_H
@@ -880,50 +880,97 @@ vector<PeakGroup*> ProjectDatabase::loadGroups(const vector<mzSample*>& loaded)
 
     vector<PeakGroup*> groups;
     map<PeakGroup*, int> childParentMap;
+
+    // groups in the order they were read, along with their parent's ID
+    vector<pair<PeakGroup*, int>> loadedGroups;
+    unordered_map<int, PeakGroup*> groupsById;
+
+    // resolve columns once, their values are then read by index
+    int groupIdColumn = groupsQuery->columnIndex("group_id");
+    int parentGroupIdColumn = groupsQuery->columnIndex("parent_group_id");
+    int tagStringColumn = groupsQuery->columnIndex("tag_string");
+    int metaGroupIdColumn = groupsQuery->columnIndex("meta_group_id");
+    int expectedMzColumn = groupsQuery->columnIndex("expected_mz");
+    int expectedRtDiffColumn = groupsQuery->columnIndex("expected_rt_diff");
+    int expectedAbundanceColumn =
+        groupsQuery->columnIndex("expected_abundance");
+    int groupRankColumn = groupsQuery->columnIndex("group_rank");
+    int labelColumn = groupsQuery->columnIndex("label");
+    int ms2EventCountColumn = groupsQuery->columnIndex("ms2_event_count");
+    int ms2ScoreColumn = groupsQuery->columnIndex("ms2_score");
+    int fragmentationFractionMatchedColumn =
+        groupsQuery->columnIndex("fragmentation_fraction_matched");
+    int fragmentationMzFragErrorColumn =
+        groupsQuery->columnIndex("fragmentation_mz_frag_error");
+    int fragmentationHypergeomScoreColumn =
+        groupsQuery->columnIndex("fragmentation_hypergeom_score");
+    int fragmentationMvhScoreColumn =
+        groupsQuery->columnIndex("fragmentation_mvh_score");
+    int fragmentationDotProductColumn =
+        groupsQuery->columnIndex("fragmentation_dot_product");
+    int fragmentationWeightedDotProductColumn =
+        groupsQuery->columnIndex("fragmentation_weighted_dot_product");
+    int fragmentationSpearmanRankCorrColumn =
+        groupsQuery->columnIndex("fragmentation_spearman_rank_corr");
+    int fragmentationTicMatchedColumn =
+        groupsQuery->columnIndex("fragmentation_tic_matched");
+    int fragmentationNumMatchesColumn =
+        groupsQuery->columnIndex("fragmentation_num_matches");
+    int typeColumn = groupsQuery->columnIndex("type");
+    int tableNameColumn = groupsQuery->columnIndex("table_name");
+    int minQualityColumn = groupsQuery->columnIndex("min_quality");
+    int compoundIdColumn = groupsQuery->columnIndex("compound_id");
+    int compoundDbColumn = groupsQuery->columnIndex("compound_db");
+    int compoundNameColumn = groupsQuery->columnIndex("compound_name");
+    int adductNameColumn = groupsQuery->columnIndex("adduct_name");
+    int srmIdColumn = groupsQuery->columnIndex("srm_id");
+    int sampleIdsColumn = groupsQuery->columnIndex("sample_ids");
+
     while (groupsQuery->next()) {
         PeakGroup* group = new PeakGroup();
-        group->groupId = groupsQuery->integerValue("group_id");
-        int parentGroupId = groupsQuery->integerValue("parent_group_id");
-        group->tagString = groupsQuery->stringValue("tag_string");
-        group->metaGroupId = groupsQuery->integerValue("meta_group_id");
-        group->expectedMz = groupsQuery->floatValue("expected_mz");
-        group->expectedRtDiff = groupsQuery->floatValue("expected_rt_diff");
+        group->groupId = groupsQuery->integerValue(groupIdColumn);
+        int parentGroupId = groupsQuery->integerValue(parentGroupIdColumn);
+        group->tagString = groupsQuery->stringValue(tagStringColumn);
+        group->metaGroupId = groupsQuery->integerValue(metaGroupIdColumn);
+        group->expectedMz = groupsQuery->floatValue(expectedMzColumn);
+        group->expectedRtDiff = groupsQuery->floatValue(expectedRtDiffColumn);
         group->expectedAbundance =
-            groupsQuery->floatValue("expected_abundance");
-        group->groupRank = groupsQuery->floatValue("group_rank");
-        group->label = groupsQuery->stringValue("label")[0];
-        group->ms2EventCount = groupsQuery->integerValue("ms2_event_count");
+            groupsQuery->floatValue(expectedAbundanceColumn);
+        group->groupRank = groupsQuery->floatValue(groupRankColumn);
+        group->label = groupsQuery->stringValue(labelColumn)[0];
+        group->ms2EventCount = groupsQuery->integerValue(ms2EventCountColumn);
         group->fragMatchScore.mergedScore =
-            groupsQuery->doubleValue("ms2_score");
+            groupsQuery->doubleValue(ms2ScoreColumn);
         group->fragMatchScore.fractionMatched =
-            groupsQuery->doubleValue("fragmentation_fraction_matched");
+            groupsQuery->doubleValue(fragmentationFractionMatchedColumn);
         group->fragMatchScore.mzFragError =
-            groupsQuery->doubleValue("fragmentation_mz_frag_error");
+            groupsQuery->doubleValue(fragmentationMzFragErrorColumn);
         group->fragMatchScore.hypergeomScore =
-            groupsQuery->doubleValue("fragmentation_hypergeom_score");
+            groupsQuery->doubleValue(fragmentationHypergeomScoreColumn);
         group->fragMatchScore.mvhScore =
-            groupsQuery->doubleValue("fragmentation_mvh_score");
+            groupsQuery->doubleValue(fragmentationMvhScoreColumn);
         group->fragMatchScore.dotProduct =
-            groupsQuery->doubleValue("fragmentation_dot_product");
+            groupsQuery->doubleValue(fragmentationDotProductColumn);
         group->fragMatchScore.weightedDotProduct =
-            groupsQuery->doubleValue("fragmentation_weighted_dot_product");
+            groupsQuery->doubleValue(fragmentationWeightedDotProductColumn);
         group->fragMatchScore.spearmanRankCorrelation =
-            groupsQuery->doubleValue("fragmentation_spearman_rank_corr");
+            groupsQuery->doubleValue(fragmentationSpearmanRankCorrColumn);
         group->fragMatchScore.ticMatched =
-            groupsQuery->doubleValue("fragmentation_tic_matched");
+            groupsQuery->doubleValue(fragmentationTicMatchedColumn);
         group->fragMatchScore.numMatches =
-            groupsQuery->doubleValue("fragmentation_num_matches");
+            groupsQuery->doubleValue(fragmentationNumMatchesColumn);
 
-        group->setType(PeakGroup::GroupType(groupsQuery->integerValue("type")));
-        group->searchTableName = groupsQuery->stringValue("table_name");
-        group->minQuality = groupsQuery->doubleValue("min_quality");
+        group->setType(
+            PeakGroup::GroupType(groupsQuery->integerValue(typeColumn)));
+        group->searchTableName = groupsQuery->stringValue(tableNameColumn);
+        group->minQuality = groupsQuery->doubleValue(minQualityColumn);
 
-        string compoundId = groupsQuery->stringValue("compound_id");
-        string compoundDB = groupsQuery->stringValue("compound_db");
-        string compoundName = groupsQuery->stringValue("compound_name");
-        string adductName = groupsQuery->stringValue("adduct_name");
+        string compoundId = groupsQuery->stringValue(compoundIdColumn);
+        string compoundDB = groupsQuery->stringValue(compoundDbColumn);
+        string compoundName = groupsQuery->stringValue(compoundNameColumn);
+        string adductName = groupsQuery->stringValue(adductNameColumn);
 
-        string srmId = groupsQuery->stringValue("srm_id");
+        string srmId = groupsQuery->stringValue(srmIdColumn);
         if (!srmId.empty())
             group->setSrmId(srmId);
 
@@ -951,7 +998,9 @@ vector<PeakGroup*> ProjectDatabase::loadGroups(const vector<mzSample*>& loaded)
         }
 
         vector<string> sample_ids;
-        mzUtils::split(groupsQuery->stringValue("sample_ids"), ';', sample_ids);
+        mzUtils::split(groupsQuery->stringValue(sampleIdsColumn),
+                       ';',
+                       sample_ids);
         for (auto idString : sample_ids) {
             if (idString.empty())
                 continue;
@@ -967,11 +1016,23 @@ vector<PeakGroup*> ProjectDatabase::loadGroups(const vector<mzSample*>& loaded)
             }
         }
 
-        loadGroupPeaks(group, loaded);
+        loadedGroups.push_back(make_pair(group, parentGroupId));
+        groupsById.emplace(group->groupId, group);
+    }
+
+    // peaks of all groups are read at once, instead of querying for every
+    // group separately
+    loadGroupPeaks(groupsById, loaded);
+
+    unordered_map<int, PeakGroup*> parentsById;
+    for (auto& entry : loadedGroups) {
+        auto group = entry.first;
+        int parentGroupId = entry.second;
         group->groupStatistics();
 
         if (parentGroupId == 0) {
             groups.push_back(group);
+            parentsById.emplace(group->groupId, group);
         } else {
             childParentMap[group] = parentGroupId;
         }
@@ -979,18 +1040,15 @@ vector<PeakGroup*> ProjectDatabase::loadGroups(const vector<mzSample*>& loaded)
 
     // assign parents for child groups
     for (auto pair : childParentMap) {
-        bool foundParent = false;
         auto child = pair.first;
-        for (auto parent : groups) {
-            if (parent->groupId == pair.second) {
-                parent->addChild(*child);
-                foundParent = true;
-                break;
-            }
-        }
-        // failed to find a parent group, become a parent
-        if (!foundParent)
+        auto parent = parentsById.find(pair.second);
+        if (parent != parentsById.end()) {
+            parent->second->addChild(*child);
+        } else {
+            // failed to find a parent group, become a parent
             groups.push_back(child);
+            parentsById.emplace(child->groupId, child);
+        }
     }
 
 
@@ -998,8 +1056,9 @@ vector<PeakGroup*> ProjectDatabase::loadGroups(const vector<mzSample*>& loaded)
     return groups;
 }
 
-void ProjectDatabase::loadGroupPeaks(PeakGroup* parentGroup,
-                                     const vector<mzSample*>& loaded)
+void ProjectDatabase::loadGroupPeaks(
+    const unordered_map<int, PeakGroup*>& groups,
+    const vector<mzSample*>& loaded)
 {
     auto peaksQuery = _connection->prepare(
                 "SELECT peaks.*                             \
@@ -1007,67 +1066,133 @@ void ProjectDatabase::loadGroupPeaks(PeakGroup* parentGroup,
                    FROM peaks                               \
                       , samples                             \
                   WHERE peaks.sample_id = samples.sample_id \
-                    AND peaks.group_id = :parent_group_id   ");
-    peaksQuery->bind(":parent_group_id", parentGroup->groupId);
-
+               ORDER BY peaks.group_id                      \
+                      , peaks.peak_id                       ");
+
+    // the first sample with a given name is associated with its peaks
+    unordered_map<string, mzSample*> samplesByName;
+    for (auto sample : loaded)
+        samplesByName.emplace(sample->sampleName, sample);
+
+    // resolve columns once, their values are then read by index
+    int posColumn = peaksQuery->columnIndex("pos");
+    int minposColumn = peaksQuery->columnIndex("minpos");
+    int maxposColumn = peaksQuery->columnIndex("maxpos");
+    int rtColumn = peaksQuery->columnIndex("rt");
+    int rtminColumn = peaksQuery->columnIndex("rtmin");
+    int rtmaxColumn = peaksQuery->columnIndex("rtmax");
+    int mzminColumn = peaksQuery->columnIndex("mzmin");
+    int mzmaxColumn = peaksQuery->columnIndex("mzmax");
+    int scanColumn = peaksQuery->columnIndex("scan");
+    int minscanColumn = peaksQuery->columnIndex("minscan");
+    int maxscanColumn = peaksQuery->columnIndex("maxscan");
+    int peakAreaColumn = peaksQuery->columnIndex("peak_area");
+    int peakSplineAreaColumn = peaksQuery->columnIndex("peak_spline_area");
+    int peakAreaCorrectedColumn =
+        peaksQuery->columnIndex("peak_area_corrected");
+    int peakAreaTopColumn = peaksQuery->columnIndex("peak_area_top");
+    int peakAreaTopCorrectedColumn =
+        peaksQuery->columnIndex("peak_area_top_corrected");
+    int peakAreaFractionalColumn =
+        peaksQuery->columnIndex("peak_area_fractional");
+    int peakRankColumn = peaksQuery->columnIndex("peak_rank");
+    int peakIntensityColumn = peaksQuery->columnIndex("peak_intensity");
+    int peakBaselineLevelColumn =
+        peaksQuery->columnIndex("peak_baseline_level");
+    int peakMzColumn = peaksQuery->columnIndex("peak_mz");
+    int medianMzColumn = peaksQuery->columnIndex("median_mz");
+    int baseMzColumn = peaksQuery->columnIndex("base_mz");
+    int qualityColumn = peaksQuery->columnIndex("quality");
+    int widthColumn = peaksQuery->columnIndex("width");
+    int gaussFitSigmaColumn = peaksQuery->columnIndex("gauss_fit_sigma");
+    int gaussFitR2Column = peaksQuery->columnIndex("gauss_fit_r2");
+    int groupIdColumn = peaksQuery->columnIndex("group_id");
+    int noNoiseObsColumn = peaksQuery->columnIndex("no_noise_obs");
+    int noNoiseFractionColumn = peaksQuery->columnIndex("no_noise_fraction");
+    int symmetryColumn = peaksQuery->columnIndex("symmetry");
+    int signalBaselineRatioColumn =
+        peaksQuery->columnIndex("signal_baseline_ratio");
+    int groupOverlapColumn = peaksQuery->columnIndex("group_overlap");
+    int groupOverlapFracColumn = peaksQuery->columnIndex("group_overlap_frac");
+    int localMaxFlagColumn = peaksQuery->columnIndex("local_max_flag");
+    int fromBlankSampleColumn = peaksQuery->columnIndex("from_blank_sample");
+    int labelColumn = peaksQuery->columnIndex("label");
+    int sampleNameColumn = peaksQuery->columnIndex("sample_name");
+
+    // peaks of a group come in sequence, so the group is looked up only when
+    // the group ID changes
+    int currentGroupId = 0;
+    PeakGroup* currentGroup = nullptr;
+    bool firstPeak = true;
     while (peaksQuery->next()) {
+        int groupId = peaksQuery->integerValue(groupIdColumn);
+        if (firstPeak || groupId != currentGroupId) {
+            auto group = groups.find(groupId);
+            currentGroup = group != groups.end() ? group->second : nullptr;
+            currentGroupId = groupId;
+            firstPeak = false;
+        }
+        if (!currentGroup)
+            continue;
+
         Peak peak;
-        peak.pos = static_cast<unsigned int>(peaksQuery->integerValue("pos"));
+        peak.pos =
+            static_cast<unsigned int>(peaksQuery->integerValue(posColumn));
         peak.minpos =
-            static_cast<unsigned int>(peaksQuery->integerValue("minpos"));
+            static_cast<unsigned int>(peaksQuery->integerValue(minposColumn));
         peak.maxpos =
-            static_cast<unsigned int>(peaksQuery->integerValue("maxpos"));
-        peak.rt = peaksQuery->floatValue("rt");
-        peak.rtmin = peaksQuery->floatValue("rtmin");
-        peak.rtmax = peaksQuery->floatValue("rtmax");
-        peak.mzmin = peaksQuery->floatValue("mzmin");
-        peak.mzmax = peaksQuery->floatValue("mzmax");
-        peak.scan = static_cast<unsigned int>(peaksQuery->integerValue("scan"));
+            static_cast<unsigned int>(peaksQuery->integerValue(maxposColumn));
+        peak.rt = peaksQuery->floatValue(rtColumn);
+        peak.rtmin = peaksQuery->floatValue(rtminColumn);
+        peak.rtmax = peaksQuery->floatValue(rtmaxColumn);
+        peak.mzmin = peaksQuery->floatValue(mzminColumn);
+        peak.mzmax = peaksQuery->floatValue(mzmaxColumn);
+        peak.scan =
+            static_cast<unsigned int>(peaksQuery->integerValue(scanColumn));
         peak.minscan =
-            static_cast<unsigned int>(peaksQuery->integerValue("minscan"));
+            static_cast<unsigned int>(peaksQuery->integerValue(minscanColumn));
         peak.maxscan =
-            static_cast<unsigned int>(peaksQuery->integerValue("maxscan"));
-        peak.peakArea = peaksQuery->floatValue("peak_area");
-        peak.peakSplineArea = peaksQuery->floatValue("peak_spline_area");
-        peak.peakAreaCorrected = peaksQuery->floatValue("peak_area_corrected");
-        peak.peakAreaTop = peaksQuery->floatValue("peak_area_top");
+            static_cast<unsigned int>(peaksQuery->integerValue(maxscanColumn));
+        peak.peakArea = peaksQuery->floatValue(peakAreaColumn);
+        peak.peakSplineArea = peaksQuery->floatValue(peakSplineAreaColumn);
+        peak.peakAreaCorrected =
+            peaksQuery->floatValue(peakAreaCorrectedColumn);
+        peak.peakAreaTop = peaksQuery->floatValue(peakAreaTopColumn);
         peak.peakAreaTopCorrected =
-            peaksQuery->floatValue("peak_area_top_corrected");
+            peaksQuery->floatValue(peakAreaTopCorrectedColumn);
         peak.peakAreaFractional =
-            peaksQuery->floatValue("peak_area_fractional");
-        peak.peakRank = peaksQuery->floatValue("peak_rank");
-        peak.peakIntensity = peaksQuery->floatValue("peak_intensity");
-        peak.peakBaseLineLevel = peaksQuery->floatValue("peak_baseline_level");
-        peak.peakMz = peaksQuery->floatValue("peak_mz");
-        peak.medianMz = peaksQuery->floatValue("median_mz");
-        peak.baseMz = peaksQuery->floatValue("base_mz");
-        peak.quality = peaksQuery->floatValue("quality");
+            peaksQuery->floatValue(peakAreaFractionalColumn);
+        peak.peakRank = peaksQuery->floatValue(peakRankColumn);
+        peak.peakIntensity = peaksQuery->floatValue(peakIntensityColumn);
+        peak.peakBaseLineLevel =
+            peaksQuery->floatValue(peakBaselineLevelColumn);
+        peak.peakMz = peaksQuery->floatValue(peakMzColumn);
+        peak.medianMz = peaksQuery->floatValue(medianMzColumn);
+        peak.baseMz = peaksQuery->floatValue(baseMzColumn);
+        peak.quality = peaksQuery->floatValue(qualityColumn);
         peak.width =
-            static_cast<unsigned int>(peaksQuery->integerValue("width"));
-        peak.gaussFitSigma = peaksQuery->floatValue("gauss_fit_sigma");
-        peak.gaussFitR2 = peaksQuery->floatValue("gauss_fit_r2");
-        peak.groupNum = peaksQuery->integerValue("group_id");
+            static_cast<unsigned int>(peaksQuery->integerValue(widthColumn));
+        peak.gaussFitSigma = peaksQuery->floatValue(gaussFitSigmaColumn);
+        peak.gaussFitR2 = peaksQuery->floatValue(gaussFitR2Column);
+        peak.groupNum = groupId;
         peak.noNoiseObs =
-            static_cast<unsigned int>(peaksQuery->integerValue("no_noise_obs"));
-        peak.noNoiseFraction = peaksQuery->floatValue("no_noise_fraction");
-        peak.symmetry = peaksQuery->floatValue("symmetry");
+            static_cast<unsigned int>(
+                peaksQuery->integerValue(noNoiseObsColumn));
+        peak.noNoiseFraction = peaksQuery->floatValue(noNoiseFractionColumn);
+        peak.symmetry = peaksQuery->floatValue(symmetryColumn);
         peak.signalBaselineRatio =
-            peaksQuery->floatValue("signal_baseline_ratio");
-        peak.groupOverlap = peaksQuery->floatValue("group_overlap");
-        peak.groupOverlapFrac = peaksQuery->floatValue("group_overlap_frac");
-        peak.localMaxFlag = peaksQuery->integerValue("local_max_flag");
-        peak.fromBlankSample = peaksQuery->integerValue("from_blank_sample");
-        peak.label = peaksQuery->stringValue("label")[0];
-
-        string sampleName = peaksQuery->stringValue("sample_name");
-
-        for (auto sample : loaded) {
-            if (sample->sampleName == sampleName) {
-                peak.setSample(sample);
-                break;
-            }
-        }
-        parentGroup->addPeak(peak);
+            peaksQuery->floatValue(signalBaselineRatioColumn);
+        peak.groupOverlap = peaksQuery->floatValue(groupOverlapColumn);
+        peak.groupOverlapFrac = peaksQuery->floatValue(groupOverlapFracColumn);
+        peak.localMaxFlag = peaksQuery->integerValue(localMaxFlagColumn);
+        peak.fromBlankSample = peaksQuery->integerValue(fromBlankSampleColumn);
+        peak.label = peaksQuery->stringValue(labelColumn)[0];
+
+        auto sample =
+            samplesByName.find(peaksQuery->stringValue(sampleNameColumn));
+        if (sample != samplesByName.end())
+            peak.setSample(sample->second);
+        currentGroup->addPeak(peak);
     }
 }
 
@@ -1089,14 +1214,36 @@ vector<Compound*> ProjectDatabase::loadCompounds(const string databaseName)
 
     MassCalculator mcalc;
     int loadCount = 0;
+    // resolve columns once, their values are then read by index
+    int compoundIdColumn = compoundsQuery->columnIndex("compound_id");
+    int nameColumn = compoundsQuery->columnIndex("name");
+    int formulaColumn = compoundsQuery->columnIndex("formula");
+    int chargeColumn = compoundsQuery->columnIndex("charge");
+    int massColumn = compoundsQuery->columnIndex("mass");
+    int dbNameColumn = compoundsQuery->columnIndex("db_name");
+    int expectedRtColumn = compoundsQuery->columnIndex("expected_rt");
+    int precursorMzColumn = compoundsQuery->columnIndex("precursor_mz");
+    int productMzColumn = compoundsQuery->columnIndex("product_mz");
+    int collisionEnergyColumn = compoundsQuery->columnIndex("collision_energy");
+    int smileStringColumn = compoundsQuery->columnIndex("smile_string");
+    int logPColumn = compoundsQuery->columnIndex("log_p");
+    int ionizationModeColumn = compoundsQuery->columnIndex("ionization_mode");
+    int noteColumn = compoundsQuery->columnIndex("note");
+    int categoryColumn = compoundsQuery->columnIndex("category");
+    int fragmentMzsColumn = compoundsQuery->columnIndex("fragment_mzs");
+    int fragmentIntensityColumn =
+        compoundsQuery->columnIndex("fragment_intensity");
+    int fragmentIonTypesColumn =
+        compoundsQuery->columnIndex("fragment_ion_types");
+
     while (compoundsQuery->next()) {
-        string id = compoundsQuery->stringValue("compound_id");
-        string name = compoundsQuery->stringValue("name");
-        string formula = compoundsQuery->stringValue("formula");
-        int charge = compoundsQuery->integerValue("charge");
-        float mass = compoundsQuery->floatValue("mass");
-        string db = compoundsQuery->stringValue("db_name");
-        float expectedRt = compoundsQuery->floatValue("expected_rt");
+        string id = compoundsQuery->stringValue(compoundIdColumn);
+        string name = compoundsQuery->stringValue(nameColumn);
+        string formula = compoundsQuery->stringValue(formulaColumn);
+        int charge = compoundsQuery->integerValue(chargeColumn);
+        float mass = compoundsQuery->floatValue(massColumn);
+        string db = compoundsQuery->stringValue(dbNameColumn);
+        float expectedRt = compoundsQuery->floatValue(expectedRtColumn);
 
         // skip if compound already exists in internal database
         if (_compoundIdMap.find(id + name + db) != end(_compoundIdMap))
@@ -1115,14 +1262,15 @@ vector<Compound*> ProjectDatabase::loadCompounds(const string databaseName)
                     static_cast<float>(mcalc.computeNeutralMass(formula));
         }
 
-        compound->precursorMz = compoundsQuery->floatValue("precursor_mz");
-        compound->productMz = compoundsQuery->floatValue("product_mz");
+        compound->precursorMz = compoundsQuery->floatValue(precursorMzColumn);
+        compound->productMz = compoundsQuery->floatValue(productMzColumn);
         compound->collisionEnergy =
-                compoundsQuery->floatValue("collision_energy");
-        compound->smileString = compoundsQuery->stringValue("smile_string");
-        compound->logP = compoundsQuery->floatValue("log_p");
-        compound->ionizationMode = compoundsQuery->floatValue("ionization_mode");
-        compound->note = compoundsQuery->stringValue("note");
+                compoundsQuery->floatValue(collisionEnergyColumn);
+        compound->smileString = compoundsQuery->stringValue(smileStringColumn);
+        compound->logP = compoundsQuery->floatValue(logPColumn);
+        compound->ionizationMode =
+            compoundsQuery->floatValue(ionizationModeColumn);
+        compound->note = compoundsQuery->stringValue(noteColumn);
 
         // mark compound as decoy if names contains DECOY string
         if (compound->name.find("DECOY") != string::npos)
@@ -1138,27 +1286,28 @@ vector<Compound*> ProjectDatabase::loadCompounds(const string databaseName)
             return separated;
         };
 
-        string categories = compoundsQuery->stringValue("category");
+        string categories = compoundsQuery->stringValue(categoryColumn);
         for (auto category : split(categories, ';')) {
             if (!category.empty())
                 compound->category.push_back(category);
         }
 
-        string fragmentMzValues = compoundsQuery->stringValue("fragment_mzs");
+        string fragmentMzValues =
+            compoundsQuery->stringValue(fragmentMzsColumn);
         for (string fragMz : split(fragmentMzValues, ';')) {
             if (!fragMz.empty())
                 compound->fragmentMzValues.push_back(stof(fragMz));
         }
 
         string fragmentIntensities =
-                compoundsQuery->stringValue("fragment_intensity");
+                compoundsQuery->stringValue(fragmentIntensityColumn);
         for (string fragIntensity : split(fragmentIntensities, ';')) {
             if (!fragIntensity.empty())
                 compound->fragmentIntensities.push_back(stof(fragIntensity));
         }
 
         vector<string> fragmentIonTypes =
-            split(compoundsQuery->stringValue("fragment_ion_types"), ';');
+            split(compoundsQuery->stringValue(fragmentIonTypesColumn), ';');
         for (size_t i = 0; i < fragmentIonTypes.size(); ++i) {
             string fragIonType = fragmentIonTypes[i];
             if (!fragIonType.empty())
@@ -1205,7 +1354,8 @@ void ProjectDatabase::loadAndPerformAlignment(const vector<mzSample*>& loaded)
 
     Aligner aligner;
     aligner.setSamples(loaded);
-    AlignmentSegment* lastSegment = nullptr;
+    AlignmentSegment lastSegment = {0, 0, 0, 0};
+    string lastSampleName;
     int segCount = 0;
 
     while (alignmentQuery->next()) {
@@ -1231,20 +1381,20 @@ void ProjectDatabase::loadAndPerformAlignment(const vector<mzSample*>& loaded)
         } else {
             // perform segmented alignment
             segCount++;
-            AlignmentSegment* seg = new AlignmentSegment();
-            seg->sampleName = sampleName;
-            seg->segStart = 0;
-            seg->segEnd   = alignmentQuery->floatValue("rt_original");
-            seg->newStart = 0;
-            seg->newEnd   = alignmentQuery->floatValue("rt_updated");
-
-            if (lastSegment and lastSegment->sampleName == seg->sampleName) {
-                seg->segStart = lastSegment->segEnd;
-                seg->newStart = lastSegment->newEnd;
+            AlignmentSegment seg;
+            seg.segStart = 0;
+            seg.segEnd   = alignmentQuery->floatValue("rt_original");
+            seg.newStart = 0;
+            seg.newEnd   = alignmentQuery->floatValue("rt_updated");
+
+            if (lastSampleName == sampleName) {
+                seg.segStart = lastSegment.segEnd;
+                seg.newStart = lastSegment.newEnd;
             }
 
             aligner.addSegment(sampleName, seg);
             lastSegment = seg;
+            lastSampleName = sampleName;
         }
     }
 
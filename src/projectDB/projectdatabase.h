@@ -4,6 +4,7 @@
 #include <iostream>
 #include <map>
 #include <set>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -202,12 +203,16 @@ public:
     vector<PeakGroup*> loadGroups(const vector<mzSample*>& loaded);
 
     /**
-     * @brief Load peaks for a given peak group.
-     * @param group The PeakGroup for which peaks are to be loaded.
-     * @param loaded A vector of loaded mzSample objects that will be iterated
-     * through to associate each peak with.
+     * @brief Load peaks for a set of peak groups.
+     * @details All peaks are read with a single query, ordered by their group
+     * IDs, and added to the group they belong to. Peaks of groups not in the
+     * given set are skipped.
+     * @param groups A map of PeakGroup objects, for which peaks are to be
+     * loaded, keyed by their group IDs.
+     * @param loaded A vector of loaded mzSample objects that will be
+     * associated with each peak.
      */
-    void loadGroupPeaks(PeakGroup* group,
+    void loadGroupPeaks(const unordered_map<int, PeakGroup*>& groups,
                         const vector<mzSample*>& loaded);
 
     /**
@@ -21,7 +21,7 @@ QMAKE_CXXFLAGS += -fopenmp
 INCLUDEPATH +=  $$top_srcdir/src/core/libmaven  $$top_srcdir/3rdparty/pugixml/src $$top_srcdir/3rdparty/libneural $$top_srcdir/3rdparty/libpls \
 				$$top_srcdir/3rdparty/libcsvparser $$top_srcdir/src/cli/peakdetector $$top_srcdir/3rdparty/libdate $$top_srcdir/3rdparty/libcdfread \
                 $$top_srcdir/3rdparty/obiwarp $$top_srcdir/src/pollyCLI \
-                $$top_srcdir/3rdparty/Eigen $$top_srcdir/src/
+                $$top_srcdir/3rdparty/Eigen $$top_srcdir/src/ $$top_srcdir/src/projectDB
 macx {
 
     DYLIBPATH = $$system(source ~/.bash_profile ; echo $LDFLAGS)
@@ -33,7 +33,7 @@ macx {
 }
 QMAKE_LFLAGS += -L$$top_builddir/libs/
 
-LIBS += -lmaven -lpugixml -lneural -lcsvparser -lpls -lErrorHandling -lLogger -lcdfread -lz -lnetcdf -lobiwarp -lpollyCLI -lcommon
+LIBS += -lmaven -lpugixml -lneural -lcsvparser -lpls -lErrorHandling -lLogger -lcdfread -lz -lnetcdf -lobiwarp -lpollyCLI -lcommon -lprojectDB -lsqlite3
 !macx: LIBS += -fopenmp
 
 macx {
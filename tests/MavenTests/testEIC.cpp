@@ -1,4 +1,5 @@
 #include "testEIC.h"
+#include "datastructures/memoryArena.h"
 #include "datastructures/mzSlice.h"
 #include "EIC.h"
 #include "masscutofftype.h"
@@ -405,3 +406,66 @@ void TestEIC:: testeicMerge() {
     QVERIFY(17.039 < m->rtmax < 17.040);
 }
 
+
+void TestEIC::testMemoryArena()
+{
+    // small blocks, so that the second allocation needs a new block
+    MemoryArena arena(1024);
+    QVERIFY(arena.capacity() == 0);
+    double* first = arena.allocateArray<double>(100);
+    float* second = arena.allocateArray<float>(300);
+    QVERIFY(reinterpret_cast<uintptr_t>(first) % alignof(double) == 0);
+    QVERIFY(reinterpret_cast<uintptr_t>(second) % alignof(float) == 0);
+    QVERIFY(arena.allocationCount() == 2);
+    QVERIFY(arena.blockAllocations() == 2);
+    QVERIFY(arena.bytesInUse() >= 100 * sizeof(double) + 300 * sizeof(float));
+    for (int i = 0; i < 100; i++)
+        first[i] = i;
+    for (int i = 0; i < 300; i++)
+        second[i] = -1;
+    for (int i = 0; i < 100; i++)
+        QVERIFY(first[i] == i);
+
+    // a reset keeps the high-water mark and coalesces the blocks into one
+    // that holds it, so the same workload needs no more blocks
+    size_t highWaterMark = arena.highWaterMark();
+    QVERIFY(highWaterMark == arena.bytesInUse());
+    arena.reset();
+    QVERIFY(arena.bytesInUse() == 0);
+    QVERIFY(arena.allocationCount() == 0);
+    QVERIFY(arena.highWaterMark() == highWaterMark);
+    QVERIFY(arena.capacity() >= highWaterMark);
+    size_t blockAllocations = arena.blockAllocations();
+    for (int round = 0; round < 3; round++) {
+        arena.allocateArray<double>(100);
+        arena.allocateArray<float>(300);
+        arena.reset();
+    }
+    QVERIFY(arena.blockAllocations() == blockAllocations);
+
+    // EIC buffers come from the current arena, and from the heap otherwise;
+    // deleting the EICs only frees the heap buffers
+    EIC* arenaEic = new EIC();
+    EIC* heapEic = new EIC();
+    for (int i = 0; i < 50; i++) {
+        float intensity = 100 * exp(-(i - 25) * (i - 25) / 20.0f);
+        arenaEic->intensity.push_back(intensity);
+        heapEic->intensity.push_back(intensity);
+    }
+    {
+        MemoryArena::Scope scope(&arena);
+        QVERIFY(MemoryArena::current() == &arena);
+        arenaEic->computeSpline(5);
+    }
+    QVERIFY(MemoryArena::current() == nullptr);
+    QVERIFY(arena.bytesInUse() >= 50 * sizeof(float));
+    size_t bytesInUse = arena.bytesInUse();
+    heapEic->computeSpline(5);
+    QVERIFY(arena.bytesInUse() == bytesInUse);
+    for (int i = 0; i < 50; i++)
+        QVERIFY(arenaEic->spline[i] == heapEic->spline[i]);
+    delete arenaEic;
+    delete heapEic;
+    arena.reset();
+    QVERIFY(arena.bytesInUse() == 0);
+}
@@ -35,6 +35,7 @@ class TestEIC : public QObject {
         void testGetPeakDetails();
         void testgroupPeaks();
         void testeicMerge();
+        void testMemoryArena();
 };
 
 #endif // TESTEIC_H
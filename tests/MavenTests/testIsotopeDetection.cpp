@@ -2,12 +2,18 @@
 #include "Compound.h"
 #include "constants.h"
 #include "classifierNeuralNet.h"
+#include "EIC.h"
 #include "isotopeDetection.h"
+#include "isotopeDistribution.h"
 #include "masscutofftype.h"
 #include "mavenparameters.h"
+#include "mzMassCalculator.h"
 #include "mzSample.h"
+#include "Peak.h"
 #include "PeakDetector.h"
+#include "peakFiltering.h"
 #include "PeakGroup.h"
+#include "Scan.h"
 #include "utilities.h"
 
 TestIsotopeDetection::TestIsotopeDetection() {
@@ -244,3 +250,231 @@ void TestIsotopeDetection::testpullIsotopes() {
     QVERIFY(D2_BPE == 0);
     QVERIFY(C13_BPE > 0);
 }
+
+void TestIsotopeDetection::testWindowedIsotopeSearch() {
+    // a glucose parent eluting at 5 min in a run of MS1 scans 0.01 min
+    // apart, with its C13 isotopologues at the parent's apex, just inside
+    // either edge of the isotope RT window and just outside it. Every trace
+    // also has a larger peak far from the parent over a flat floor.
+    string formula = "C6H12O6";
+    vector<Isotope> masslist =
+        MassCalculator::computeIsotopes(formula, -1, true, false, false, false);
+
+    MavenParameters* mavenparameters = new MavenParameters();
+    mavenparameters->compoundMassCutoffWindow->setMassCutoffAndType(10, "ppm");
+    mavenparameters->clsf = new ClassifierNeuralNet();
+    mavenparameters->ionizationMode = -1;
+    mavenparameters->avgScanTime = 0.01;
+    mavenparameters->maxIsotopeScanDiff = 10;
+    mavenparameters->minIsotopicCorrelation = -1;
+    mavenparameters->eic_smoothingWindow = 5;
+    mavenparameters->eic_smoothingAlgorithm = 1;
+    mavenparameters->baseline_smoothingWindow = 5;
+    mavenparameters->baseline_dropTopX = 80;
+    float maxRtDiff = mavenparameters->maxIsotopeScanDiff
+                      * mavenparameters->avgScanTime;
+
+    map<string, float> apexes;
+    for (unsigned int k = 0; k < masslist.size(); k++) {
+        string name = masslist[k].name;
+        float apex = 5.0f;
+        if (name == "C13-label-2")
+            apex += maxRtDiff - 0.01f;
+        else if (name == "C13-label-3")
+            apex -= maxRtDiff - 0.01f;
+        else if (name == "C13-label-4")
+            apex += maxRtDiff + 0.05f;
+        apexes[name] = apex;
+    }
+
+    mzSample* sample = new mzSample();
+    sample->sampleName = "sample";
+    for (int i = 0; i < 1000; i++) {
+        float rt = i * 0.01f;
+        Scan* scan = new Scan(sample, i, 1, rt, 0, -1);
+        for (unsigned int k = 0; k < masslist.size(); k++) {
+            float apex = apexes[masslist[k].name];
+            float d = (rt - apex) / 0.02f;
+            float decoy = (rt - 2.0f) / 0.02f;
+            float intensity = 1e5f / (k + 1) * exp(-d * d / 2)
+                              + 5e5f * exp(-decoy * decoy / 2)
+                              + 50;
+            scan->mz.push_back(masslist[k].mass);
+            scan->intensity.push_back(intensity);
+        }
+        sample->addScan(scan);
+    }
+    sample->calculateMzRtRange();
+    mavenparameters->samples.push_back(sample);
+
+    // the parent peak, nearest to 5 min, and its group
+    Isotope& parentIsotope = masslist[0];
+    float parentMzTolr = mavenparameters->compoundMassCutoffWindow
+                             ->massCutoffValue(parentIsotope.mass);
+    EIC* parentEic = sample->getEIC(parentIsotope.mass - parentMzTolr,
+                                    parentIsotope.mass + parentMzTolr,
+                                    sample->minRt,
+                                    sample->maxRt,
+                                    1,
+                                    mavenparameters->eicType,
+                                    mavenparameters->filterline);
+    parentEic->setBaselineSmoothingWindow(mavenparameters->baseline_smoothingWindow);
+    parentEic->setBaselineDropTopX(mavenparameters->baseline_dropTopX);
+    parentEic->getPeakPositions(mavenparameters->eic_smoothingWindow);
+    PeakGroup parentgroup;
+    for (Peak& peak : parentEic->peaks) {
+        if (abs(peak.rt - 5.0f) < 0.05f)
+            parentgroup.addPeak(peak);
+    }
+    QVERIFY(parentgroup.peaks.size() == 1);
+    parentgroup.groupStatistics();
+    delete parentEic;
+
+    IsotopeDetection isotopeDetection(mavenparameters,
+                                      IsotopeDetection::PeakDetection,
+                                      true,
+                                      false,
+                                      false,
+                                      false);
+    map<string, PeakGroup> isotopes =
+        isotopeDetection.getIsotopes(&parentgroup, masslist);
+
+    // the nearest peak within maxRtDiff, picked from an EIC of the whole
+    // run, as isotopes were looked for before the search was windowed
+    Peak* parentPeak = parentgroup.getPeak(sample);
+    map<string, Peak> fullScanPeaks;
+    for (unsigned int k = 0; k < masslist.size(); k++) {
+        Isotope& x = masslist[k];
+        float mzTolr = mavenparameters->compoundMassCutoffWindow
+                           ->massCutoffValue(x.mass);
+        pair<float, float> isotope = isotopeDetection.getIntensity(
+            parentPeak->getScan(), x.mass - mzTolr, x.mass + mzTolr);
+        if (isotope.first == 0 || isotope.second == 0)
+            continue;
+        EIC* eic = sample->getEIC(x.mass - mzTolr,
+                                  x.mass + mzTolr,
+                                  sample->minRt,
+                                  sample->maxRt,
+                                  1,
+                                  mavenparameters->eicType,
+                                  mavenparameters->filterline);
+        eic->setSmootherType(
+            (EIC::SmootherType) mavenparameters->eic_smoothingAlgorithm);
+        eic->setBaselineSmoothingWindow(mavenparameters->baseline_smoothingWindow);
+        eic->setBaselineDropTopX(mavenparameters->baseline_dropTopX);
+        eic->setFilterSignalBaselineDiff(
+            mavenparameters->isotopicMinSignalBaselineDifference);
+        eic->getPeakPositions(mavenparameters->eic_smoothingWindow);
+        vector<Peak> allPeaks = eic->peaks;
+        PeakFiltering peakFiltering(mavenparameters, true);
+        peakFiltering.filter(allPeaks);
+        delete eic;
+
+        float d = FLT_MAX;
+        for (Peak& peak : allPeaks) {
+            float dist = abs(peak.rt - isotope.second);
+            if (dist <= maxRtDiff && dist < d) {
+                d = dist;
+                fullScanPeaks[x.name] = peak;
+            }
+        }
+    }
+
+    // the far decoy is never picked and only the isotopologue beyond the
+    // window edge is missed
+    QVERIFY(isotopes.size() == fullScanPeaks.size());
+    QVERIFY(isotopes.count("C13-label-2") == 1);
+    QVERIFY(isotopes.count("C13-label-3") == 1);
+    QVERIFY(isotopes.count("C13-label-4") == 0);
+    for (auto& it : fullScanPeaks) {
+        QVERIFY(isotopes.count(it.first) == 1);
+        Peak& expected = it.second;
+        Peak* peak = isotopes[it.first].getPeak(sample);
+        QVERIFY(peak != NULL);
+        QVERIFY(peak->scan == expected.scan);
+        QVERIFY(peak->minscan == expected.minscan);
+        QVERIFY(peak->maxscan == expected.maxscan);
+        QVERIFY(TestUtils::floatCompare(peak->rt, expected.rt));
+        QVERIFY(TestUtils::floatCompare(peak->peakIntensity,
+                                        expected.peakIntensity));
+        QVERIFY(TestUtils::floatCompare(peak->peakArea, expected.peakArea));
+    }
+}
+
+void TestIsotopeDetection::testNaturalAbundanceCheck() {
+    // glucose's M+1 window at 10 ppm holds the O17 isotopologue as well as
+    // the C13 one
+    string formula = "C6H12O6";
+    MavenParameters* mavenparameters = new MavenParameters();
+    mavenparameters->compoundMassCutoffWindow->setMassCutoffAndType(10, "ppm");
+    mavenparameters->ionizationMode = -1;
+    mavenparameters->charge = 1;
+    mavenparameters->maxNaturalAbundanceErr = 1;
+    mavenparameters->minIsotopicCorrelation = -1;
+    int charge = mavenparameters->getCharge();
+
+    vector<Isotope> masslist =
+        MassCalculator::computeIsotopes(formula, charge, true, false, false, false);
+    Isotope c13;
+    for (Isotope& x : masslist) {
+        if (x.name == "C13-label-1")
+            c13 = x;
+    }
+    QVERIFY(c13.C13 == 1);
+
+    IsotopeDistribution isotopeDistribution;
+    float mzTolr = mavenparameters->compoundMassCutoffWindow->massCutoffValue(c13.mass);
+    double windowAbundance = 0;
+    for (const IsotopePeak& peak : isotopeDistribution.fineStructure(formula, charge)) {
+        if (abs(peak.mass - c13.mass) <= mzTolr)
+            windowAbundance += peak.abundance;
+    }
+    QVERIFY(windowAbundance > c13.abundance * 1.01);
+
+    // a parent and its M+1 co-eluting at the observed natural abundance
+    double parentMass = MassCalculator::computeMass(formula, charge);
+    float parentPeakIntensity = 1e6;
+    float isotopePeakIntensity =
+        windowAbundance * parentPeakIntensity / (1 - windowAbundance);
+    mzSample* sample = new mzSample();
+    for (int i = 0; i < 50; i++) {
+        float d = (i - 25) / 5.0f;
+        Scan* scan = new Scan(sample, i, 1, i * 0.01f, 0, charge);
+        scan->mz.push_back(parentMass);
+        scan->intensity.push_back(parentPeakIntensity * exp(-d * d / 2));
+        scan->mz.push_back(c13.mass);
+        scan->intensity.push_back(isotopePeakIntensity * exp(-d * d / 2));
+        sample->addScan(scan);
+    }
+    sample->calculateMzRtRange();
+    mavenparameters->samples.push_back(sample);
+
+    Compound* compound = new Compound("glc", "glucose", formula, 0);
+    PeakGroup parentgroup;
+    parentgroup.compound = compound;
+    parentgroup.meanMz = parentMass;
+    parentgroup.minRt = sample->minRt;
+    parentgroup.maxRt = sample->maxRt;
+
+    IsotopeDetection isotopeDetection(mavenparameters,
+                                      IsotopeDetection::IsoWidget,
+                                      false,
+                                      false,
+                                      false,
+                                      false);
+
+    // the M+1 passes the natural abundance check against the fine structure
+    // of the parent's formula, but not against the C13 isotopologue alone
+    QVERIFY(!isotopeDetection.filterIsotope(c13,
+                                            isotopePeakIntensity,
+                                            parentPeakIntensity,
+                                            sample,
+                                            &parentgroup));
+    parentgroup.compound = NULL;
+    QVERIFY(isotopeDetection.filterIsotope(c13,
+                                           isotopePeakIntensity,
+                                           parentPeakIntensity,
+                                           sample,
+                                           &parentgroup));
+    delete compound;
+}
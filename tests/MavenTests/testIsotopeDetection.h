@@ -28,6 +28,8 @@ class TestIsotopeDetection : public QObject {
         // this is automatically detected thanks to Qt's meta-information about QObjects
         void testpullIsotopes();
         void testgetIsotopes();
+        void testWindowedIsotopeSearch();
+        void testNaturalAbundanceCheck();
 };
 
 #endif // TESTISOTOPEDETECTION_H
@@ -1,7 +1,10 @@
 #include "testLoadDB.h"
 #include "Compound.h"
+#include "connection.h"
+#include "cursor.h"
 #include "databases.h"
 #include "mzSample.h"
+#include "projectdatabase.h"
 #include "utilities.h"
 
 TestLoadDB::TestLoadDB() {
@@ -179,3 +182,155 @@ void TestLoadDB::testloadCompoundCSVFileWithRep() {
         QVERIFY(numberofCompounds == 7);
 } */
 
+void TestLoadDB::testProjectDBCursor() {
+    Connection connection(":memory:");
+    QVERIFY(connection.executeMulti(
+        "CREATE TABLE values_table (id INTEGER, mz REAL, name TEXT, note TEXT);"
+        "INSERT INTO values_table VALUES (7, 181.0707, 'glucose', NULL);"
+        "INSERT INTO values_table VALUES (-2, 0.5, '', 'isomer');"));
+
+    Cursor* cursor = connection.prepare("SELECT id, mz, name, note"
+                                        " FROM values_table"
+                                        " ORDER BY id DESC");
+    int idColumn = cursor->columnIndex("id");
+    int mzColumn = cursor->columnIndex("mz");
+    int nameColumn = cursor->columnIndex("name");
+    int noteColumn = cursor->columnIndex("note");
+    QVERIFY(idColumn == 0);
+    QVERIFY(mzColumn == 1);
+    QVERIFY(nameColumn == 2);
+    QVERIFY(noteColumn == 3);
+    QVERIFY(cursor->columnIndex("formula") == -1);
+
+    // nothing can be read before the first row
+    QVERIFY(cursor->integerValue(idColumn) == 0);
+    QVERIFY(cursor->stringValue("name") == "");
+
+    QVERIFY(cursor->next());
+    QVERIFY(cursor->integerValue(idColumn) == 7);
+    QVERIFY(cursor->integerValue("id") == 7);
+    QVERIFY(cursor->doubleValue(mzColumn) == 181.0707);
+    QVERIFY(cursor->doubleValue("mz") == 181.0707);
+    QVERIFY(cursor->floatValue("mz") == 181.0707f);
+    QVERIFY(cursor->stringValue(nameColumn) == "glucose");
+    QVERIFY(cursor->stringValue("name") == "glucose");
+
+    // values are converted to the requested type
+    QVERIFY(cursor->stringValue("id") == "7");
+    QVERIFY(cursor->integerValue("mz") == 181);
+    QVERIFY(cursor->doubleValue("id") == 7.0);
+
+    // NULL values and unknown columns read as zero or an empty string
+    QVERIFY(cursor->stringValue(noteColumn) == "");
+    QVERIFY(cursor->integerValue("note") == 0);
+    QVERIFY(cursor->doubleValue("note") == 0.0);
+    QVERIFY(cursor->stringValue("formula") == "");
+    QVERIFY(cursor->integerValue("formula") == 0);
+    QVERIFY(cursor->doubleValue("formula") == 0.0);
+    QVERIFY(cursor->floatValue("formula") == 0.0f);
+
+    QVERIFY(cursor->next());
+    QVERIFY(cursor->integerValue(idColumn) == -2);
+    QVERIFY(cursor->floatValue(mzColumn) == 0.5f);
+    QVERIFY(cursor->stringValue(nameColumn) == "");
+    QVERIFY(cursor->stringValue(noteColumn) == "isomer");
+
+    // nor after the last one
+    QVERIFY(!cursor->next());
+    QVERIFY(cursor->integerValue(idColumn) == 0);
+    QVERIFY(cursor->stringValue(noteColumn) == "");
+}
+
+void TestLoadDB::testLoadGroupPeaks() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    string dbFilename = dir.path().toStdString() + "/groups.emDB";
+
+    vector<mzSample*> samples;
+    for (int i = 0; i < 3; i++) {
+        mzSample* sample = new mzSample();
+        sample->sampleName = "sample" + to_string(i);
+        sample->fileName = sample->sampleName + ".mzXML";
+        samples.push_back(sample);
+    }
+
+    // every peak has a unique rt, which identifies it after loading
+    float nextRt = 1.0f;
+    auto addPeaks = [&](PeakGroup& group, int count) {
+        for (int i = 0; i < count; i++) {
+            Peak peak;
+            peak.setSample(samples[(i + group.groupId) % samples.size()]);
+            peak.rt = nextRt;
+            nextRt += 0.5f;
+            group.addPeak(peak);
+        }
+    };
+
+    ProjectDatabase* project = new ProjectDatabase(dbFilename, "v0.0.0-1");
+    project->saveSamples(samples);
+
+    // the rts and sample names of each saved group, in the order saved
+    map<int, vector<pair<float, string>>> savedPeaks;
+    auto recordPeaks = [&](PeakGroup& group, int groupId) {
+        for (auto& peak : group.peaks) {
+            savedPeaks[groupId].push_back(
+                make_pair(peak.rt, peak.getSample()->sampleName));
+        }
+    };
+
+    vector<int> groupIds;
+    for (int i = 0; i < 20; i++) {
+        PeakGroup group;
+        group.groupId = i;
+        addPeaks(group, 3 + i % 4);
+        int groupId = project->saveGroupAndPeaks(&group);
+        recordPeaks(group, groupId);
+        groupIds.push_back(groupId);
+
+        if (i % 5 == 0) {
+            PeakGroup child;
+            child.groupId = i;
+            addPeaks(child, 2);
+            int childId = project->saveGroupAndPeaks(&child, groupId);
+            recordPeaks(child, childId);
+        }
+
+        // peaks added to an earlier group are stored after those of later
+        // groups
+        if (i % 3 == 2) {
+            PeakGroup extra;
+            extra.groupId = i;
+            addPeaks(extra, 2);
+            int earlierId = groupIds[i / 2];
+            project->saveGroupPeaks(&extra, earlierId);
+            recordPeaks(extra, earlierId);
+        }
+    }
+
+    int loadedGroups = 0;
+    auto checkPeaks = [&](PeakGroup& group) {
+        const auto& expected = savedPeaks[group.groupId];
+        QVERIFY(group.peaks.size() == expected.size());
+        for (size_t i = 0; i < expected.size(); i++) {
+            QVERIFY(group.peaks[i].rt == expected[i].first);
+            QVERIFY(group.peaks[i].getSample()->sampleName
+                    == expected[i].second);
+        }
+        loadedGroups++;
+    };
+
+    auto groups = project->loadGroups(samples);
+    QVERIFY(groups.size() == 20);
+    for (auto group : groups) {
+        checkPeaks(*group);
+        for (auto& child : group->children)
+            checkPeaks(child);
+    }
+    QVERIFY(loadedGroups == savedPeaks.size());
+
+    for (auto group : groups)
+        delete group;
+    delete project;
+    for (auto sample : samples)
+        delete sample;
+}
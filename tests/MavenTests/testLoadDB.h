@@ -30,6 +30,8 @@ class TestLoadDB : public QObject {
         void testExtractCompoundfromEachLineWithCompoundField();
         void testloadCompoundCSVFileWithIssues();
         void testloadCompoundCSVFileWithRep();
+        void testProjectDBCursor();
+        void testLoadGroupPeaks();
         //void testloadCompoundCSVFileWithRepNoId();
 };
 
@@ -1,5 +1,6 @@
 #include "testMassCalculator.h"
 #include "databases.h"
+#include "isotopeDistribution.h"
 #include "mzMassCalculator.h"
 #include "mzSample.h"
 #include "utilities.h"
@@ -135,6 +136,138 @@ void TestMassCalculator::testComputeIsotopes() {
 
 }
 
+namespace {
+    bool sameIsotopes(const vector<Isotope>& a, const vector<Isotope>& b) {
+        if (a.size() != b.size())
+            return false;
+        for (size_t i = 0; i < a.size(); i++) {
+            if (a[i].name != b[i].name
+                || a[i].mass != b[i].mass
+                || a[i].abundance != b[i].abundance)
+                return false;
+        }
+        return true;
+    }
+}
+
+void TestMassCalculator::testCache() {
+    vector<string> formulas = {"C10H12N4O6", "C12H18N4O4PS", "C6H12O6",
+                               "C2H5OH", "C5H9NO4", "HCl"};
+
+    // uncached results, with an ionization charge that differs between
+    // the two isotope lists of every formula
+    MassCalculator::clearCache();
+    vector<map<string, int>> compositions;
+    vector<double> masses;
+    vector<vector<Isotope>> positive;
+    vector<vector<Isotope>> negative;
+    for (auto formula : formulas) {
+        compositions.push_back(MassCalculator::getComposition(formula));
+        masses.push_back(MassCalculator::computeNeutralMass(formula));
+        positive.push_back(MassCalculator::computeIsotopes(formula,
+                                                           +1,
+                                                           true,
+                                                           true,
+                                                           false,
+                                                           false));
+        negative.push_back(MassCalculator::computeIsotopes(formula,
+                                                           -1,
+                                                           true,
+                                                           true,
+                                                           false,
+                                                           false));
+    }
+
+    // cache hits return the same values, and the charge is still applied
+    for (size_t i = 0; i < formulas.size(); i++) {
+        QVERIFY(TestUtils::compareMaps(
+            MassCalculator::getComposition(formulas[i]), compositions[i]));
+        QVERIFY(MassCalculator::computeNeutralMass(formulas[i]) == masses[i]);
+        QVERIFY(sameIsotopes(MassCalculator::computeIsotopes(formulas[i],
+                                                             +1,
+                                                             true,
+                                                             true,
+                                                             false,
+                                                             false),
+                             positive[i]));
+        QVERIFY(sameIsotopes(MassCalculator::computeIsotopes(formulas[i],
+                                                             -1,
+                                                             true,
+                                                             true,
+                                                             false,
+                                                             false),
+                             negative[i]));
+        QVERIFY(positive[i][0].mass > negative[i][0].mass);
+    }
+
+    // concurrent lookups, inserts and clears return the same values
+    int mismatches = 0;
+    #pragma omp parallel for schedule(dynamic) reduction(+:mismatches)
+    for (int k = 0; k < 600; k++) {
+        size_t i = k % formulas.size();
+        if (k % 100 == 0)
+            MassCalculator::clearCache();
+        if (MassCalculator::computeNeutralMass(formulas[i]) != masses[i])
+            mismatches++;
+        if (MassCalculator::getComposition(formulas[i]) != compositions[i])
+            mismatches++;
+        auto isotopes = MassCalculator::computeIsotopes(formulas[i],
+                                                        k % 2 ? -1 : +1,
+                                                        true,
+                                                        true,
+                                                        false,
+                                                        false);
+        if (!sameIsotopes(isotopes, k % 2 ? negative[i] : positive[i]))
+            mismatches++;
+    }
+    QVERIFY(mismatches == 0);
+}
+
+void TestMassCalculator::testIsotopeDistribution() {
+    IsotopeDistribution isotopeDistribution;
+    string formula = "C6H12O6";
+
+    vector<IsotopePeak> coarse = isotopeDistribution.coarseStructure(formula, 0);
+    vector<IsotopePeak> fine = isotopeDistribution.fineStructure(formula, 0);
+
+    //monoisotopic peak comes first and has the neutral mass
+    QVERIFY(coarse[0].shift == 0);
+    QVERIFY(TestUtils::floatCompare(coarse[0].mass,
+                                    MassCalculator::computeNeutralMass(formula)));
+    //M+1 of glucose is about 7.1% of M+0, with MassCalculator's abundances
+    QVERIFY(coarse[1].shift == 1);
+    double ratio = coarse[1].abundance / coarse[0].abundance;
+    QVERIFY(ratio > 0.069 && ratio < 0.072);
+
+    //fine structure resolves C13, H2 and O17 peaks that make up M+1
+    int fineM1 = 0;
+    double fineM1Abundance = 0;
+    for (unsigned int i = 0; i < fine.size(); i++) {
+        if (fine[i].shift == 1) {
+            fineM1++;
+            fineM1Abundance += fine[i].abundance;
+        }
+    }
+    QVERIFY(fineM1 == 3);
+    QVERIFY(abs(fineM1Abundance - coarse[1].abundance) < 1e-6);
+
+    //charged masses match those from MassCalculator
+    vector<IsotopePeak> charged = isotopeDistribution.coarseStructure(formula, -1);
+    QVERIFY(TestUtils::floatCompare(charged[0].mass,
+                                    MassCalculator::computeMass(formula, -1)));
+
+    //shifts are relative to the most abundant isotope of every element, so
+    //54Fe in heme gives an M-2 peak before the one at the neutral mass
+    string heme = "C34H32FeN4O4";
+    vector<IsotopePeak> hemeCoarse = isotopeDistribution.coarseStructure(heme, 0);
+    QVERIFY(hemeCoarse[0].shift == -2);
+    QVERIFY(hemeCoarse[2].shift == 0);
+    QVERIFY(TestUtils::floatCompare(hemeCoarse[2].mass,
+                                    MassCalculator::computeNeutralMass(heme)));
+    ratio = hemeCoarse[0].abundance / hemeCoarse[2].abundance;
+    QVERIFY(ratio > 0.062 && ratio < 0.065);
+}
+
 void TestMassCalculator::testenumerateMasses() {
     //TODO: have to add a test case for ennumurate mass
     // MassCalculator masCal;
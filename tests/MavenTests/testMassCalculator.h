@@ -27,6 +27,8 @@ class TestMassCalculator : public QObject {
         void testNeutralMass();
         void testComputeMass();
         void testComputeIsotopes();
+        void testCache();
+        void testIsotopeDistribution();
         void testenumerateMasses();
 };
 
@@ -1,5 +1,8 @@
 #include "testMzAligner.h"
+#include "alignmentCache.h"
 #include "classifierNeuralNet.h"
+#include "dynprog.h"
+#include "landmarkAligner.h"
 #include "masscutofftype.h"
 #include "mavenparameters.h"
 #include "mzAligner.h"
@@ -7,6 +10,7 @@
 #include "obiwarp.h"
 #include "PeakDetector.h"
 #include "PeakGroup.h"
+#include "PolyAligner.h"
 #include "Scan.h"
 #include "utilities.h"
 
@@ -92,6 +96,334 @@ void TestMzAligner::testObiWarp()
 
 }
 
+void TestMzAligner::testBandedObiWarp()
+{
+    // a noisy diagonal ridge of high scores
+    int rows = 40;
+    int cols = 50;
+    MatF smat(rows, cols);
+    for (int m = 0; m < rows; m++) {
+        for (int n = 0; n < cols; n++) {
+            float d = n - m * (cols - 1) / (float)(rows - 1) - 2;
+            smat(m, n) = exp(-d * d / 4) + ((m * 7 + n * 13) % 10) / 30.0f;
+        }
+    }
+    vector<float> gaps;
+    for (int i = 0; i < rows + cols; i++)
+        gaps.push_back(2.4f * i + 0.2f);
+
+    DynProg full;
+    VecF fullGaps(rows + cols, gaps);
+    full.find_path(smat, fullGaps);
+
+    for (int width : {cols, 1}) {
+        vector<int> start(rows);
+        vector<int> end(rows);
+        for (int m = 0; m < rows; m++) {
+            int center = m * (cols - 1) / (rows - 1);
+            start[m] = center - width;
+            end[m] = center + width + 1;
+        }
+        DynProgBand band;
+        band.set(start, end, cols);
+
+        vector<float> scores(band.size());
+        for (int m = 0; m < rows; m++) {
+            for (int n = band.start[m]; n < band.end[m]; n++)
+                scores[band.index(m, n)] = smat(m, n);
+        }
+        VecF bandScores(band.size(), scores);
+        VecF bandGaps(rows + cols, gaps);
+
+        DynProg banded;
+        bool withinBand = banded.find_path_banded(band, bandScores, bandGaps);
+        if (width == cols) {
+            QVERIFY(withinBand);
+            QVERIFY(banded._mCoords.len() == full._mCoords.len());
+            for (int i = 0; i < full._mCoords.len(); i++) {
+                QVERIFY(banded._mCoords[i] == full._mCoords[i]);
+                QVERIFY(banded._nCoords[i] == full._nCoords[i]);
+            }
+        } else {
+            // the ridge is offset from the band's center
+            QVERIFY(!withinBand);
+        }
+    }
+}
+
+void TestMzAligner::testBandedObiWarpScores()
+{
+    // reference and sample runs of the same compounds, the sample drifting
+    // by up to 6 scans, plus some background
+    int rows = 150;
+    int cols = 30;
+    vector<float> rts;
+    vector<float> mzs;
+    for (int m = 0; m < rows; m++)
+        rts.push_back(m);
+    for (int i = 0; i < cols; i++)
+        mzs.push_back(100 + i);
+    vector<float> reference(rows * cols, 0);
+    vector<float> sample(rows * cols, 0);
+    for (int c = 0; c < 40; c++) {
+        int mz = (c * 7) % cols;
+        float rt = 8 + (c * 37) % (rows - 16);
+        float intensity = 1000 + (c * 131) % 5000;
+        for (int m = 0; m < rows; m++) {
+            float d = m - rt;
+            reference[m * cols + mz] += intensity * exp(-d * d / 8);
+            d = m - (rt + 2 + 0.03f * rt);
+            sample[m * cols + mz] += intensity * exp(-d * d / 8);
+        }
+    }
+    for (int i = 0; i < rows * cols; i++) {
+        reference[i] += (i * 7919) % 100;
+        sample[i] += (i * 104729) % 100;
+    }
+    float maxRtShift = 12;
+
+    MatF referenceMat(rows, cols, reference);
+    MatF sampleMat(rows, cols, sample);
+    VecF gaps;
+    DynProg full;
+    MatF smat;
+    full.score(referenceMat, sampleMat, smat, "cor");
+    VecF fullScores;
+    smat.to_vec(fullScores);
+    double fullMean, fullStdev;
+    fullScores.sample_stats(fullMean, fullStdev);
+    smat.std_normal();
+    full.linear_less_before(3.4, 0.2, 2 * rows, gaps);
+    full.find_path(smat, gaps, 0, 2, 1, 0, 0);
+
+    vector<int> start(rows);
+    vector<int> end(rows);
+    for (int m = 0; m < rows; m++) {
+        start[m] = max(0, static_cast<int>(ceil(m - maxRtShift)));
+        end[m] = min(rows, static_cast<int>(floor(m + maxRtShift)) + 1);
+    }
+    DynProgBand band;
+    band.set(start, end, rows);
+
+    DynProg banded;
+    VecF bandScores;
+    DynProgGram referenceGram;
+    DynProgGram sampleGram;
+    QVERIFY(banded.score_banded(referenceMat, sampleMat, band, bandScores, "cor"));
+    QVERIFY(banded.score_gram(referenceMat, referenceGram, "cor"));
+    QVERIFY(banded.score_gram(sampleMat, sampleGram, "cor"));
+    double mean, stdev;
+    banded.score_moments(referenceGram, sampleGram, mean, stdev);
+    QVERIFY(fabs(mean - fullMean) < 1e-5);
+    QVERIFY(fabs(stdev - fullStdev) < 1e-5);
+
+    bandScores -= static_cast<float>(mean);
+    bandScores /= static_cast<float>(stdev);
+    QVERIFY(banded.find_path_banded(band, bandScores, gaps, 0, 2, 1, 0, 0));
+    QVERIFY(banded._mCoords.len() == full._mCoords.len());
+    for (int i = 0; i < full._mCoords.len(); i++) {
+        QVERIFY(banded._mCoords[i] == full._mCoords[i]);
+        QVERIFY(banded._nCoords[i] == full._nCoords[i]);
+    }
+
+    // the same through ObiWarp, with the default parameters
+    ObiParams fullParams("cor", false, 2, 1, 0.2, 3.4, 0, 20, false, 1);
+    ObiParams bandParams("cor", false, 2, 1, 0.2, 3.4, 0, 20, false, 1, maxRtShift);
+    ObiWarp fullWarp(&fullParams);
+    ObiWarp bandWarp(&bandParams);
+    vector<float> referenceRts = rts;
+    fullWarp.setReferenceData(referenceRts, mzs, reference);
+    referenceRts = rts;
+    bandWarp.setReferenceData(referenceRts, mzs, reference);
+    vector<float> sampleRts = rts;
+    vector<float> fullRts = fullWarp.align(sampleRts, mzs, sample);
+    vector<float> bandRts = bandWarp.align(sampleRts, mzs, sample);
+    QVERIFY(fullRts.size() == rts.size());
+    QVERIFY(bandRts == fullRts);
+
+    // a band that cuts off the path falls back to the full matrix, which
+    // for fewer than 500 rt points is not resampled
+    ObiParams narrowParams("cor", false, 2, 1, 0.2, 3.4, 0, 20, false, 1, 1);
+    ObiWarp narrowWarp(&narrowParams);
+    referenceRts = rts;
+    narrowWarp.setReferenceData(referenceRts, mzs, reference);
+    QVERIFY(narrowWarp.align(sampleRts, mzs, sample) == fullRts);
+}
+
+void TestMzAligner::testLandmarkWarp()
+{
+    // reference rt = rt + 0.3 + 0.1 * sin(rt / 3), with every fifth pair
+    // matched wrongly
+    vector<pair<float, float>> matches;
+    for (int i = 0; i < 200; i++) {
+        float rt = 1 + i * 0.1f;
+        float refRt = rt + 0.3f + 0.1f * sin(rt / 3);
+        if (i % 5 == 0)
+            refRt += 0.5f - (i % 3) * 0.5f;
+        matches.push_back(make_pair(rt, refRt));
+    }
+
+    vector<float> rts;
+    for (int i = 0; i <= 200; i++)
+        rts.push_back(3 + i * 0.08f);
+
+    LandmarkAligner landmarkAligner;
+    vector<float> warped = landmarkAligner.fitWarp(matches, rts);
+    QVERIFY(warped.size() == rts.size());
+    for (unsigned int i = 0; i < rts.size(); i++) {
+        float expected = rts[i] + 0.3f + 0.1f * sin(rts[i] / 3);
+        QVERIFY(fabs(warped[i] - expected) < 0.01f);
+        if (i > 0)
+            QVERIFY(warped[i] >= warped[i - 1]);
+    }
+
+    vector<pair<float, float>> tooFew(matches.begin(), matches.begin() + 5);
+    QVERIFY(landmarkAligner.fitWarp(tooFew, rts).empty());
+}
+
+void TestMzAligner::testLandmarkAlignment()
+{
+    // the same compounds in two runs of MS1 scans 0.01 min apart, eluting
+    // later in the sample by 0.2 + 0.05 * sin(rt / 2) min, and a run of
+    // other compounds that cannot be aligned
+    const float scanInterval = 0.01f;
+    auto drift = [](float rt) { return rt + 0.2f + 0.05f * sin(rt / 2); };
+    mzSample* reference = new mzSample();
+    mzSample* sample = new mzSample();
+    mzSample* unrelated = new mzSample();
+    reference->sampleName = "reference";
+    sample->sampleName = "sample";
+    unrelated->sampleName = "unrelated";
+    for (int i = 0; i < 1000; i++) {
+        float rt = i * scanInterval;
+        Scan* refScan = new Scan(reference, i, 1, rt, 0, 1);
+        Scan* scan = new Scan(sample, i, 1, rt, 0, 1);
+        Scan* unrelatedScan = new Scan(unrelated, i, 1, rt, 0, 1);
+        for (int c = 0; c < 80; c++) {
+            float mz = 100 + c * 7.31f;
+            float apex = 0.5f + c * 0.11f;
+            float intensity = 1e5f * (1 + c % 7);
+            float d = (rt - apex) / 0.03f;
+            float refIntensity = intensity * exp(-d * d / 2);
+            d = (rt - drift(apex)) / 0.03f;
+            float sampleIntensity = intensity * exp(-d * d / 2);
+            if (refIntensity > 1) {
+                refScan->mz.push_back(mz);
+                refScan->intensity.push_back(refIntensity);
+            }
+            if (sampleIntensity > 1) {
+                scan->mz.push_back(mz);
+                scan->intensity.push_back(sampleIntensity);
+                unrelatedScan->mz.push_back(mz + 3.5f);
+                unrelatedScan->intensity.push_back(sampleIntensity);
+            }
+        }
+        reference->scans.push_back(refScan);
+        sample->scans.push_back(scan);
+        unrelated->scans.push_back(unrelatedScan);
+    }
+
+    LandmarkAligner landmarkAligner;
+    vector<Landmark> refLandmarks = landmarkAligner.findLandmarks(reference);
+    vector<Landmark> landmarks = landmarkAligner.findLandmarks(sample);
+    QVERIFY(refLandmarks.size() == 80);
+    QVERIFY(landmarks.size() == 80);
+    QVERIFY(landmarkAligner.matchLandmarks(landmarks, refLandmarks).size()
+            == 80);
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    MavenParameters* mavenparameters = new MavenParameters();
+    mavenparameters->alignmentCacheDir = dir.path().toStdString();
+    Aligner aligner;
+    aligner.setRefSample(reference);
+    vector<mzSample*> samples = {reference, sample, unrelated};
+    QVERIFY(!aligner.alignWithLandmarks(samples,
+                                        landmarkAligner,
+                                        mavenparameters));
+
+    // within the landmarks, a scan must be moved to the reference rt of the
+    // same elution time, found by inverting the drift
+    for (auto scan : sample->scans) {
+        if (scan->originalRt < drift(0.5f) || scan->originalRt > drift(9.2f))
+            continue;
+        float low = scan->originalRt - 1;
+        float high = scan->originalRt;
+        for (int k = 0; k < 30; k++) {
+            float mid = (low + high) / 2;
+            if (drift(mid) < scan->originalRt)
+                low = mid;
+            else
+                high = mid;
+        }
+        QVERIFY(fabs(scan->rt - low) < scanInterval);
+    }
+    for (int i = 0; i < reference->scans.size(); i++) {
+        QVERIFY(reference->scans[i]->rt == i * scanInterval);
+        QVERIFY(unrelated->scans[i]->rt == i * scanInterval);
+    }
+
+    // only samples with a warp are cached
+    AlignmentCache cache(mavenparameters->alignmentCacheDir);
+    uint64_t referenceHash = AlignmentCache::contentHash(reference);
+    string parameters = landmarkAligner.parameters();
+    QVERIFY(cache.contains(referenceHash, referenceHash, parameters));
+    QVERIFY(cache.contains(AlignmentCache::contentHash(sample),
+                           referenceHash,
+                           parameters));
+    QVERIFY(!cache.contains(AlignmentCache::contentHash(unrelated),
+                            referenceHash,
+                            parameters));
+
+    delete mavenparameters;
+    delete reference;
+    delete sample;
+    delete unrelated;
+}
+
+void TestMzAligner::testAlignmentCache()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    AlignmentCache cache(dir.path().toStdString());
+    vector<float> rts = {0.5f, 1.25f, 2.0f, 3.5f};
+    QVERIFY(cache.save(1, 2, "obiwarp score=cor", rts));
+
+    vector<float> cached;
+    QVERIFY(cache.contains(1, 2, "obiwarp score=cor"));
+    QVERIFY(cache.load(1, 2, "obiwarp score=cor", cached));
+    QVERIFY(cached == rts);
+
+    QVERIFY(!cache.load(1, 3, "obiwarp score=cor", cached));
+    QVERIFY(!cache.load(2, 2, "obiwarp score=cor", cached));
+    QVERIFY(!cache.load(1, 2, "obiwarp score=cov", cached));
+
+    AlignmentCache disabled("");
+    QVERIFY(!disabled.enabled());
+    QVERIFY(!disabled.save(1, 2, "obiwarp score=cor", rts));
+
+    // content hashes ignore current retention times, so a sample is still
+    // recognised once aligned, but not once its data changes
+    mzSample* sample = new mzSample();
+    for (int i = 0; i < 20; i++) {
+        Scan* scan = new Scan(sample, i, 1, i * 0.1f, 0, 1);
+        scan->mz = {100.0f + i, 200.0f + i};
+        scan->intensity = {1000.0f, 2000.0f};
+        sample->scans.push_back(scan);
+    }
+    uint64_t hash = AlignmentCache::contentHash(sample);
+    for (auto scan : sample->scans)
+        scan->rt += 0.25f;
+    QVERIFY(AlignmentCache::contentHash(sample) == hash);
+    sample->scans[5]->originalRt += 0.25f;
+    QVERIFY(AlignmentCache::contentHash(sample) != hash);
+    sample->scans[5]->originalRt -= 0.25f;
+    QVERIFY(AlignmentCache::contentHash(sample) == hash);
+    sample->scans[5]->intensity[1] = 2500.0f;
+    QVERIFY(AlignmentCache::contentHash(sample) != hash);
+    delete sample;
+}
+
 void TestMzAligner::testSaveFit(){
 
     vector<mzSample*> samplesToLoad  = maventests::samples.alignmentSamples;
@@ -103,3 +435,253 @@ void TestMzAligner::testSaveFit(){
     QVERIFY(aligner.fit.size());
 
 }
+
+void TestMzAligner::testPolyFit()
+{
+    // the fit as it was done before samples were fitted in parallel: one
+    // sample after another, looking up the sample's peak in every group
+    auto serialPolyFit = [](vector<PeakGroup*>& groups,
+                            vector<mzSample*>& samples,
+                            int degree) {
+        vector<double> groupRts(groups.size());
+        for (unsigned int j = 0; j < groups.size(); j++)
+            groupRts[j] = groups[j]->medianRt();
+
+        for (auto sample : samples) {
+            StatisticsVector<float> subj;
+            StatisticsVector<float> ref;
+            map<int, int> duplicates;
+            for (unsigned int j = 0; j < groups.size(); j++) {
+                Peak* p = groups[j]->getPeak(sample);
+                if (!p || p->rt <= 0 || groupRts[j] <= 0)
+                    continue;
+                int intTime = (int) p->rt * 100;
+                duplicates[intTime]++;
+                if (duplicates[intTime] > 5)
+                    continue;
+                ref.push_back(groupRts[j]);
+                subj.push_back(p->rt);
+            }
+            if (subj.size() < 10)
+                continue;
+
+            PolyAligner polyAligner(subj, ref);
+            AlignmentStats* stats = polyAligner.optimalPolynomial(1, degree, 10);
+            if (stats->transformImproved()) {
+                for (auto scan : sample->scans)
+                    scan->rt = stats->predict(scan->rt);
+                for (auto group : groups) {
+                    Peak* p = group->getPeak(sample);
+                    if (p)
+                        p->rt = stats->predict(p->rt);
+                }
+            }
+            delete stats;
+        }
+    };
+
+    // samples whose peaks drift quadratically with retention time, and one
+    // sample with too few peaks to be fitted
+    auto makeRun = [](vector<mzSample*>& samples,
+                      vector<PeakGroup*>& groups) {
+        for (int s = 0; s < 6; s++) {
+            mzSample* sample = new mzSample();
+            sample->sampleName = "sample" + to_string(s);
+            for (int i = 0; i < 400; i++)
+                sample->scans.push_back(new Scan(sample, i, 1, i * 0.1f, 0, 1));
+            samples.push_back(sample);
+        }
+        for (int j = 0; j < 60; j++) {
+            PeakGroup* group = new PeakGroup();
+            float rt = 1 + j * 0.5f;
+            for (int s = 0; s < 6; s++) {
+                if (s == 5 && j % 10 != 0)
+                    continue;
+                Peak peak;
+                peak.setSample(samples[s]);
+                peak.rt = rt * (1 + 0.01f * (s - 2)) + 0.0005f * s * rt * rt;
+                group->addPeak(peak);
+            }
+            groups.push_back(group);
+        }
+    };
+
+    vector<mzSample*> samples;
+    vector<PeakGroup*> groups;
+    makeRun(samples, groups);
+    vector<mzSample*> serialSamples;
+    vector<PeakGroup*> serialGroups;
+    makeRun(serialSamples, serialGroups);
+
+    Aligner aligner;
+    aligner.setMaxIterations(1);
+    aligner.doAlignment(groups);
+    serialPolyFit(serialGroups, serialSamples, 3);
+
+    for (unsigned int s = 0; s < samples.size(); s++) {
+        for (unsigned int i = 0; i < samples[s]->scans.size(); i++) {
+            QVERIFY(TestUtils::floatCompare(samples[s]->scans[i]->rt,
+                                            serialSamples[s]->scans[i]->rt));
+        }
+    }
+    for (unsigned int j = 0; j < groups.size(); j++) {
+        for (unsigned int k = 0; k < groups[j]->peaks.size(); k++) {
+            QVERIFY(TestUtils::floatCompare(groups[j]->peaks[k].rt,
+                                            serialGroups[j]->peaks[k].rt));
+        }
+    }
+
+    // the fitted samples move much closer together, and the sample with
+    // too few peaks is left as is
+    double spreadBefore = 0;
+    double spreadAfter = 0;
+    for (unsigned int j = 0; j < groups.size(); j++) {
+        Peak* firstPeak = groups[j]->getPeak(samples[0]);
+        for (int s = 1; s < 5; s++) {
+            float rt = 1 + j * 0.5f;
+            spreadBefore += abs(rt * 0.01f * s + 0.0005f * s * rt * rt);
+            spreadAfter += abs(groups[j]->getPeak(samples[s])->rt - firstPeak->rt);
+        }
+    }
+    QVERIFY(spreadAfter < spreadBefore / 20);
+    QVERIFY(aligner.sampleDegree.count(samples[5]) == 0);
+    QVERIFY(samples[5]->scans[100]->rt == 10.0f);
+
+    for (auto group : groups)
+        delete group;
+    for (auto group : serialGroups)
+        delete group;
+    for (auto sample : samples)
+        delete sample;
+    for (auto sample : serialSamples)
+        delete sample;
+}
+
+void TestMzAligner::testSegmentedAlignment()
+{
+    // segments built the way OBI-Warp alignment builds them, from rt 0 to
+    // each aligned time point in turn, for a run whose first scan is at
+    // rt 0; the first segment only covers rt 0
+    mzSample* sample = new mzSample();
+    sample->sampleName = "sample";
+    for (int i = 0; i <= 50; i++)
+        sample->scans.push_back(new Scan(sample, i, 1, i * 0.1f, 0, 1));
+
+    Aligner aligner;
+    AlignmentSegment seg = {0, 0, 0, 0};
+    for (int i = 0; i <= 5; i++) {
+        seg.segStart = seg.segEnd;
+        seg.newStart = seg.newEnd;
+        seg.segEnd = i;
+        seg.newEnd = 0.1f + 1.1f * i;
+        aligner.addSegment(sample->sampleName, seg);
+    }
+    aligner.setSamples({sample});
+    aligner.performSegmentedAlignment();
+
+    for (int i = 0; i <= 50; i++) {
+        float rt = sample->scans[i]->rt;
+        QVERIFY(!std::isnan(rt));
+        QVERIFY(TestUtils::floatCompare(rt, 0.1f + 0.11f * i));
+    }
+
+    delete sample;
+}
+
+void TestMzAligner::testIncrementalAlignment()
+{
+    // a reference and four runs of the same compounds, each eluting later
+    // than in the reference by its own drift
+    const float scanInterval = 0.01f;
+    auto makeSample = [scanInterval](string name, float shift) {
+        mzSample* sample = new mzSample();
+        sample->sampleName = name;
+        for (int i = 0; i < 600; i++) {
+            float rt = i * scanInterval;
+            Scan* scan = new Scan(sample, i, 1, rt, 0, 1);
+            for (int c = 0; c < 50; c++) {
+                float apex = 0.3f + c * 0.1f;
+                float d = (rt - apex - shift - 0.03f * sin(apex)) / 0.03f;
+                float intensity = 1e5f * (1 + c % 7) * exp(-d * d / 2);
+                if (intensity > 1) {
+                    scan->mz.push_back(100 + c * 7.31f);
+                    scan->intensity.push_back(intensity);
+                }
+            }
+            sample->scans.push_back(scan);
+        }
+        return sample;
+    };
+    mzSample* reference = makeSample("reference", 0);
+    vector<mzSample*> samples = {reference};
+    for (int s = 1; s <= 4; s++)
+        samples.push_back(makeSample("sample" + to_string(s), 0.02f * s));
+
+    // without an alignment cache directory
+    MavenParameters* mavenparameters = new MavenParameters();
+    mavenparameters->alignmentCacheDir = "";
+    ObiParams params("cor", false, 2.0, 1.0, 0.20, 3.40, 0.0, 20.0, false, 0.60);
+    AlignmentState state;
+    int samplesToAlign = 0;
+    auto alignSamples = [&](vector<mzSample*> samplesToUse,
+                            AlignmentState* alignmentState) {
+        Aligner aligner;
+        aligner.setRefSample(reference);
+        aligner.setAlignmentState(alignmentState);
+        samplesToAlign = 0;
+        aligner.setAlignmentProgress.connect(
+            [&](const string& message, unsigned int progress, int total) {
+                if (message == "Aligning samples")
+                    samplesToAlign = total;
+            });
+        return aligner.alignWithObiWarp(samplesToUse,
+                                        &params,
+                                        mavenparameters);
+    };
+
+    vector<mzSample*> firstSamples(samples.begin(), samples.end() - 1);
+    QVERIFY(!alignSamples(firstSamples, &state));
+    QVERIFY(samplesToAlign == 3);
+    vector<vector<float>> alignedRts;
+    for (auto sample : samples) {
+        vector<float> rts;
+        for (auto scan : sample->scans)
+            rts.push_back(scan->rt);
+        alignedRts.push_back(rts);
+    }
+    // the first samples were warped
+    QVERIFY(alignedRts[1] != alignedRts[0]);
+
+    // adding a sample only aligns that sample, to the same reference data,
+    // and the others keep their aligned retention times
+    QVERIFY(!alignSamples(samples, &state));
+    QVERIFY(samplesToAlign == 1);
+    for (int s = 0; s < 4; s++) {
+        for (int i = 0; i < samples[s]->scans.size(); i++)
+            QVERIFY(samples[s]->scans[i]->rt == alignedRts[s][i]);
+    }
+    vector<float> newRts;
+    for (auto scan : samples[4]->scans)
+        newRts.push_back(scan->rt);
+    QVERIFY(newRts != alignedRts[4]);
+
+    // the new sample is aligned as it would be with all samples at once
+    for (auto sample : samples) {
+        for (auto scan : sample->scans)
+            scan->rt = scan->originalRt;
+    }
+    QVERIFY(!alignSamples(samples, nullptr));
+    QVERIFY(samplesToAlign == 4);
+    for (int i = 0; i < samples[4]->scans.size(); i++)
+        QVERIFY(samples[4]->scans[i]->rt == newRts[i]);
+
+    // once cleared, all samples are aligned again
+    state.clear();
+    QVERIFY(!alignSamples(samples, &state));
+    QVERIFY(samplesToAlign == 4);
+
+    Aligner::setRefSample(nullptr);
+    delete mavenparameters;
+    for (auto sample : samples)
+        delete sample;
+}
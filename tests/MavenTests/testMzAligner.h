@@ -27,6 +27,30 @@ class TestMzAligner : public QObject {
         void testDoAlignment();
         void testSaveFit();
 
+        /**
+         * @brief Tests polynomial alignment fitted per sample in parallel
+         * @details Aligned retention times of scans and peaks must be the
+         * same as when samples are fitted one after another.
+         */
+        void testPolyFit();
+
+        /**
+         * @brief Tests applying alignment segments to a sample
+         * @details Every scan must be mapped by linear interpolation within
+         * its segment, including a first scan at rt 0 whose segment has no
+         * width.
+         */
+        void testSegmentedAlignment();
+
+        /**
+         * @brief Tests aligning samples added to an aligned set
+         * @details With the state of the previous alignment and no cache
+         * directory, only the added sample must be aligned, as it would be
+         * along with all others, and the others must keep their aligned
+         * retention times.
+         */
+        void testIncrementalAlignment();
+
         /**
          * @brief Tests the functionality of OBI-WARP
          * @details Calculates the rt difference between peaks of reference Sample and the rest
@@ -34,6 +58,47 @@ class TestMzAligner : public QObject {
          */
         void testObiWarp();
 
+        /**
+         * @brief Tests banded dynamic programming of OBI-WARP
+         * @details A band spanning the whole score matrix must give the same
+         * path as the full alignment, and a band whose edges are touched by
+         * the path must be reported so that alignment can fall back.
+         */
+        void testBandedObiWarp();
+
+        /**
+         * @brief Tests banded OBI-WARP on a band narrower than the matrix
+         * @details Band scores must be normalised with the moments of the
+         * full score matrix, so that a band holding the best path finds the
+         * same path, and the same aligned times, as the full alignment. A
+         * band that cuts off the path must fall back to the full alignment.
+         */
+        void testBandedObiWarpScores();
+
+        /**
+         * @brief Tests the warp fitted through paired landmarks
+         * @details The warp must follow a non-linear drift and be unaffected
+         * by landmarks paired with the wrong feature.
+         */
+        void testLandmarkWarp();
+
+        /**
+         * @brief Tests landmark alignment of two samples
+         * @details Landmarks are found and paired in synthetic runs with a
+         * known drift, and aligned retention times must be within a scan
+         * interval of the drift-free ones. A sample that cannot be aligned
+         * must be left as is and not cached.
+         */
+        void testLandmarkAlignment();
+
+        /**
+         * @brief Tests storing and reading aligned retention times
+         * @details Entries must only be found for the same samples and the
+         * same parameters. Content hashes must not change when a sample is
+         * aligned.
+         */
+        void testAlignmentCache();
+
 };
 
 #endif // TESTMZALIGNER_H
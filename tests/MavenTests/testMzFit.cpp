@@ -212,3 +212,105 @@ void TestMzFit::testLeasev() {
 
 
 }
+
+namespace {
+    /**
+     * @brief Corrected R2 reported by the earlier greedy grid search over
+     * sigma = 20, 20/1.25, ..., 20/1.25^20, for comparison. Returns the
+     * largest float for peaks that are not fitted.
+     */
+    float gridSearchR2(const vector<float>& yobs) {
+        int n = yobs.size();
+        int midpoint = n / 2;
+        float ymax = max(max(yobs[midpoint], yobs[midpoint - 1]),
+                         yobs[midpoint + 1]);
+        float ymin = min(yobs[0], yobs[n - 1]);
+        float minR = numeric_limits<float>::max();
+
+        // peaks with too few points above the baseline are not fitted
+        if (count_if(yobs.begin(),
+                     yobs.end(),
+                     [ymin](float y) { return y > ymin; }) <= 3)
+            return minR;
+
+        float s = 20;
+        for (int step = 0; step <= 20; step++) {
+            float rsqr = 0;
+            for (int i = 0; i < n; i++) {
+                float x = i - midpoint;
+                float y = max((yobs[i] - ymin) / (ymax - ymin), 0.0f);
+                float r = exp(-0.5 * (x / s) * (x / s)) - y;
+                rsqr += r * r;
+            }
+            if (rsqr >= minR)
+                break;
+            minR = rsqr;
+            s /= 1.25;
+        }
+        return minR / (n * n);
+    }
+}
+
+void TestMzFit::testGaussianFitter() {
+    // intensities of a clean, a tailing, a broad and a noisy peak, along
+    // with sigma and R2 values reported by the earlier grid-search fit
+    vector<vector<float>> peaks = {
+        {120, 340, 910, 2100, 3650, 4880, 5200, 4790, 3580, 2150, 880, 310,
+         115},
+        {50, 52, 60, 75, 140, 420, 900, 1000, 880, 410, 150, 70, 58, 51, 49},
+        {400, 520, 610, 700, 760, 800, 810, 805, 790, 750, 690, 600, 510},
+        {10, 15, 200, 30, 900, 40, 1000, 35, 850, 20, 210, 12, 9}
+    };
+    vector<float> gridSigmas = {2.14748, 1.37439, 3.35544, 1.71799};
+    vector<float> gridR2s = {5.48341e-05, 0.000138234, 0.00101771, 0.0101483};
+
+    GaussianFitter fitter;
+    for (unsigned int i = 0; i < peaks.size(); i++) {
+        float sigma = 0;
+        float R2 = 0.03;
+        fitter.fit(peaks[i].data(), peaks[i].size(), &sigma, &R2);
+
+        // the fit should be at least as good, and for peaks of a clear shape
+        // sigma should be within the resolution of the earlier grid (steps
+        // of 1.25x); the noisy peak has a better minimum at a narrower sigma
+        // than the one the grid search stopped at
+        QVERIFY(R2 <= gridR2s[i] * 1.001);
+        if (i < 3) {
+            QVERIFY(sigma >= gridSigmas[i] / 1.25
+                    && sigma <= gridSigmas[i] * 1.25);
+        }
+    }
+
+    // noisy peaks of random widths, offsets and lengths should never fit
+    // worse than with the grid search
+    unsigned int state = 12345;
+    auto random = [&state]() {
+        state = state * 1103515245 + 12345;
+        return static_cast<float>((state >> 8) & 0xffff) / 0xffff;
+    };
+    for (int k = 0; k < 2000; k++) {
+        int n = 5 + static_cast<int>(random() * 35);
+        float width = 0.3 + random() * 15;
+        float offset = random() * 4 - 2;
+        float noise = random() * 500;
+        vector<float> peak(n);
+        for (int i = 0; i < n; i++) {
+            float x = i - n / 2 + offset;
+            peak[i] = 1000 * exp(-0.5 * x * x / (width * width))
+                      + noise * random()
+                      + 50;
+        }
+        float sigma = 0;
+        float R2 = 1;
+        fitter.fit(peak.data(), peak.size(), &sigma, &R2);
+        QVERIFY(R2 <= gridSearchR2(peak) * 1.0001 + 1e-9);
+    }
+
+    // too few points above the baseline, outputs must not be modified
+    vector<float> flat = {10, 10, 10, 50, 10, 10, 10};
+    float sigma = 0;
+    float R2 = 0.03;
+    fitter.fit(flat.data(), flat.size(), &sigma, &R2);
+    QVERIFY(sigma == 0);
+    QVERIFY(TestUtils::floatCompare(R2, 0.03));
+}
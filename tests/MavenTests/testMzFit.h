@@ -32,6 +32,7 @@ class TestMzFit : public QObject {
         void testStasum();
         void testLeasqu();
         void testLeasev();
+        void testGaussianFitter();
 };
 
 #endif // TESTMZFIT_H
@@ -1,8 +1,12 @@
 #include "testScan.h"
+#include "Fragment.h"
 #include "masscutofftype.h"
 #include "mavenparameters.h"
 #include "mzSample.h"
+#include "mzUtils.h"
 #include "Scan.h"
+#include "spectraClustering.h"
+#include "spectralSearch.h"
 #include "utilities.h"
 
 TestScan::TestScan() {
@@ -311,3 +315,628 @@ void TestScan::testgetTopPeaks() {
     QVERIFY(TestUtils::floatCompare(selected[0].second,(float) 2.06999993));
     QVERIFY(TestUtils::floatCompare(selected[1].second,(float) 8.8000001));
 }
+
+void TestScan::testSpectralSearch() {
+    mzSample* ms2Sample = new mzSample();
+    float mzs[3][3] = {{100.05, 150.1, 200.2},
+                       {100.05, 175.3, 200.2},
+                       {120.4, 150.1, 210.7}};
+    float precursorMzs[3] = {300.1, 300.1, 250.2};
+    for (int i = 0; i < 3; i++) {
+        Scan* scan = new Scan(ms2Sample, i, 2, i * 0.1, precursorMzs[i], 1);
+        scan->mz.assign(mzs[i], mzs[i] + 3);
+        scan->intensity.assign(3, 1000);
+        ms2Sample->scans.push_back(scan);
+    }
+    vector<mzSample*> samples(1, ms2Sample);
+    SpectralSearch index(samples, 2);
+    QVERIFY(index.scanCount() == 3);
+
+    MassCutoff* massCutoff = new MassCutoff();
+    massCutoff->setMassCutoffAndType(10, "ppm");
+
+    SpectralQuery query;
+    query.mzs = {100.05, 150.1, 200.2};
+    vector<SpectralSearchHit> hits = index.search(query,
+                                                  massCutoff,
+                                                  massCutoff,
+                                                  1);
+    QVERIFY(hits.size() == 2);
+    QVERIFY(hits[0].scan == ms2Sample->scans[0]);
+    QVERIFY(hits[0].matchCount == 3);
+    QVERIFY(TestUtils::floatCompare(hits[0].score, 3 * log(1000.0)));
+    QVERIFY(hits[1].scan == ms2Sample->scans[1]);
+    QVERIFY(hits[1].matchCount == 2);
+
+    query.precursorMz = 250.2;
+    hits = index.search(query, massCutoff, massCutoff, 0);
+    QVERIFY(hits.size() == 1);
+    QVERIFY(hits[0].scan == ms2Sample->scans[2]);
+    QVERIFY(hits[0].matchCount == 1);
+
+    delete massCutoff;
+    delete ms2Sample;
+}
+
+void TestScan::testSpectralSearchMatchesScanScoring() {
+    // scans with some zero-intensity peaks, searched by the index and by
+    // scoring every scan with Scan::findHighestIntensityPos, as the spectra
+    // matching dialog did before it used the index
+    srand(11);
+    mzSample* ms2Sample = new mzSample();
+    float precursorMzs[3] = {300.1, 350.2, 400.3};
+    vector<float> fragmentMzs;
+    for (int i = 0; i < 40; i++)
+        fragmentMzs.push_back(60 + i * 6.07f);
+    for (int i = 0; i < 300; i++) {
+        Scan* scan = new Scan(ms2Sample, i, 2, i * 0.01, precursorMzs[i % 3], 1);
+        for (auto mz : fragmentMzs) {
+            if (rand() % 3 == 0)
+                continue;
+            scan->mz.push_back(mz + (rand() % 20 - 10) * 1e-4f);
+            scan->intensity.push_back(rand() % 4 == 0 ? 0 : rand() % 10000);
+        }
+        ms2Sample->scans.push_back(scan);
+    }
+    vector<mzSample*> samples(1, ms2Sample);
+    SpectralSearch index(samples, 2);
+
+    MassCutoff* precursorCutoff = new MassCutoff();
+    precursorCutoff->setMassCutoffAndType(10, "ppm");
+    MassCutoff* productCutoff = new MassCutoff();
+    productCutoff->setMassCutoffAndType(20, "ppm");
+
+    auto scoreScan = [&](Scan* scan, const SpectralQuery& query, int& matchCount) {
+        matchCount = 0;
+        if (query.precursorMz > 0
+            && mzUtils::massCutoffDist((double)query.precursorMz,
+                                       (double)scan->precursorMz,
+                                       precursorCutoff)
+                   > precursorCutoff->getMassCutoff())
+            return 0.0f;
+        float score = 0;
+        bool hasIntensities = !query.intensities.empty();
+        vector<float> x;
+        vector<float> y;
+        for (unsigned int i = 0; i < query.mzs.size(); i++) {
+            int pos = scan->findHighestIntensityPos(query.mzs[i], productCutoff);
+            if (pos >= 0) {
+                matchCount++;
+                if (!hasIntensities) {
+                    score += log(scan->intensity[pos]);
+                } else {
+                    x.push_back(query.intensities[i]);
+                    y.push_back(scan->intensity[pos] / scan->totalIntensity());
+                }
+            } else {
+                if (!hasIntensities) {
+                    score--;
+                } else {
+                    x.push_back(query.intensities[i]);
+                    y.push_back(-query.intensities[i]);
+                }
+            }
+        }
+        if (hasIntensities)
+            score = mzUtils::correlation(x, y);
+        return score;
+    };
+
+    int zeroIntensityMatches = 0;
+    for (int q = 0; q < 50; q++) {
+        SpectralQuery query;
+        query.precursorMz = q % 2 ? precursorMzs[q % 3] : 0;
+        for (int k = 0; k < 5; k++) {
+            query.mzs.push_back(fragmentMzs[rand() % fragmentMzs.size()]);
+            if (q % 4 >= 2)
+                query.intensities.push_back(rand() % 100);
+        }
+        int minMatches = 2;
+
+        vector<SpectralSearchHit> expected;
+        for (auto scan : ms2Sample->scans) {
+            int matchCount;
+            float score = scoreScan(scan, query, matchCount);
+            if (score > 0 && matchCount > minMatches)
+                expected.push_back(SpectralSearchHit{0, scan, score, matchCount});
+            for (auto mz : query.mzs) {
+                float mzTolr = productCutoff->massCutoffValue(mz);
+                for (unsigned int k = 0; k < scan->nobs(); k++) {
+                    if (scan->intensity[k] == 0 && abs(scan->mz[k] - mz) <= mzTolr)
+                        zeroIntensityMatches++;
+                }
+            }
+        }
+        stable_sort(expected.begin(),
+                    expected.end(),
+                    [](const SpectralSearchHit& a, const SpectralSearchHit& b) {
+                        return a.score > b.score;
+                    });
+
+        vector<SpectralSearchHit> hits = index.search(query,
+                                                      precursorCutoff,
+                                                      productCutoff,
+                                                      minMatches);
+        QVERIFY(hits.size() == expected.size());
+        for (size_t i = 0; i < min(hits.size(), expected.size()); i++) {
+            QVERIFY(hits[i].scan == expected[i].scan);
+            QVERIFY(hits[i].matchCount == expected[i].matchCount);
+            QVERIFY(TestUtils::floatCompare(hits[i].score, expected[i].score));
+        }
+    }
+    // zero-intensity peaks near the query's fragments were not matches
+    // before and are still not
+    QVERIFY(zeroIntensityMatches > 0);
+
+    delete precursorCutoff;
+    delete productCutoff;
+    delete ms2Sample;
+}
+
+void TestScan::testSpectraClustering() {
+    // replicate spectra of compounds sharing a few precursor masses, with
+    // dropped and jittered peaks and some noise
+    srand(7);
+    mzSample* ms2Sample = new mzSample();
+    int scanNum = 0;
+    for (int compound = 0; compound < 60; compound++) {
+        float precursorMz = 400 + 100 * (compound % 3);
+        vector<pair<float, float>> peaks;
+        for (int k = 0; k < 10 + rand() % 10; k++) {
+            float mz = 50 + (rand() % 340000) / 1000.0f;
+            peaks.push_back(make_pair(mz, 100.0f + rand() % 10000));
+        }
+        for (int replicate = 0; replicate < 4; replicate++) {
+            Scan* scan = new Scan(ms2Sample,
+                                  scanNum++,
+                                  2,
+                                  scanNum * 0.01,
+                                  precursorMz,
+                                  1);
+            vector<pair<float, float>> spectrum;
+            for (auto& peak : peaks) {
+                if (rand() % 10 == 0)
+                    continue;
+                spectrum.push_back(
+                    make_pair(peak.first * (1 + (rand() % 20 - 10) * 1e-7f),
+                              peak.second * (0.7f + (rand() % 60) / 100.0f)));
+            }
+            spectrum.push_back(make_pair(50 + (rand() % 340000) / 1000.0f,
+                                         50.0f + rand() % 300));
+            sort(spectrum.begin(), spectrum.end());
+            for (auto& peak : spectrum) {
+                scan->mz.push_back(peak.first);
+                scan->intensity.push_back(peak.second);
+            }
+            ms2Sample->scans.push_back(scan);
+        }
+    }
+    vector<Scan*> scans(ms2Sample->scans.begin(), ms2Sample->scans.end());
+
+    // exhaustive all-pairs scoring within the precursor tolerance
+    vector<Fragment*> fragments;
+    for (auto scan : scans)
+        fragments.push_back(new Fragment(scan, 0.05, 0, 25));
+    vector<int> exhaustive(scans.size());
+    for (size_t i = 0; i < scans.size(); i++)
+        exhaustive[i] = i;
+    size_t windowPairs = 0;
+    for (size_t i = 0; i < scans.size(); i++) {
+        for (size_t j = i + 1; j < scans.size(); j++) {
+            float mzDiff = fabs(scans[i]->precursorMz - scans[j]->precursorMz);
+            if (mzDiff > scans[i]->precursorMz * 10e-6)
+                continue;
+            windowPairs++;
+            Fragment* a = fragments[i];
+            Fragment* b = fragments[j];
+            if (b->nobs() < a->nobs())
+                swap(a, b);
+            if (a->scoreMatch(b, 20, "DotProduct").mergedScore < 0.7)
+                continue;
+            int from = exhaustive[j];
+            int to = exhaustive[i];
+            for (auto& label : exhaustive) {
+                if (label == from)
+                    label = to;
+            }
+        }
+    }
+    for (auto fragment : fragments)
+        delete fragment;
+
+    {
+        SpectraClustering clustering(10, 20, 0.7, "DotProduct");
+        clustering.cluster(vector<mzSample*>(1, ms2Sample));
+        QVERIFY(clustering.scoredPairs() < windowPairs / 2);
+
+        map<Scan*, int> clusterOf;
+        for (size_t c = 0; c < clustering.clusterScans().size(); c++) {
+            for (auto scan : clustering.clusterScans()[c])
+                clusterOf[scan] = c;
+            QVERIFY(clustering.clusters()[c]->consensus != nullptr);
+        }
+        QVERIFY(clusterOf.size() == scans.size());
+        for (size_t i = 0; i < scans.size(); i++) {
+            for (size_t j = i + 1; j < scans.size(); j++) {
+                QVERIFY((clusterOf[scans[i]] == clusterOf[scans[j]])
+                        == (exhaustive[i] == exhaustive[j]));
+            }
+        }
+    }
+
+    delete ms2Sample;
+}
+
+void TestScan::testScoreMatch() {
+    // the scores as they were computed before scoreMatch aligned the spectra
+    // once: ranks from a nested scan over the other spectrum, a dense
+    // binned dot product and one pass over the ranks for every other score
+    auto oldScoreMatch = [](Fragment* a, Fragment* b, float productPpmTolr) {
+        FragmentationMatchScore s;
+        if (a->nobs() < 2 || b->nobs() < 2)
+            return s;
+        s.ppmError = abs((a->precursorMz - b->precursorMz) / a->precursorMz * 1e6);
+        vector<int> ranks(a->nobs(), -1);
+        for (unsigned int i = 0; i < a->nobs(); i++) {
+            for (unsigned int j = 0; j < b->nobs(); j++) {
+                if (mzUtils::ppmDist(a->mzValues[i], b->mzValues[j]) < productPpmTolr) {
+                    ranks[i] = j;
+                    break;
+                }
+            }
+        }
+        for (int rank : ranks) {
+            if (rank != -1)
+                s.numMatches++;
+        }
+        for (unsigned int i = 0; i < ranks.size(); i++)
+            b->annotations[ranks[i]] = a->annotations[i];
+
+        s.fractionMatched = s.numMatches / a->nobs();
+        s.spearmanRankCorrelation = a->spearmanRankCorrelation(ranks);
+        s.ticMatched = a->ticMatched(ranks);
+        s.mzFragError = a->mzErr(ranks, b);
+        if (a->totalIntensity() > 0 && b->totalIntensity() > 0) {
+            s.dotProduct = mzUtils::correlation(a->asDenseVector(100, 2000, 2000),
+                                                b->asDenseVector(100, 2000, 2000));
+        }
+        s.hypergeomScore = a->hyperGeometricScore(s.numMatches, a->nobs(), b->nobs(), 100000)
+                           + s.ticMatched;
+        s.mvhScore = a->MVH(ranks, b);
+        s.weightedDotProduct = a->mzWeightedDotProduct(ranks, b);
+        return s;
+    };
+
+    auto makeFragment = [](const vector<float>& mzs, const vector<float>& intensities) {
+        Fragment* fragment = new Fragment();
+        fragment->precursorMz = 700.3;
+        fragment->mzValues = mzs;
+        fragment->intensityValues = intensities;
+        fragment->obscount = vector<int>(mzs.size(), 1);
+        return fragment;
+    };
+
+    vector<float> libraryMzs = {101.0, 150.05, 203.1, 250.2, 312.3, 400.45, 512.6, 650.7};
+    vector<float> libraryIntensities = {500, 10000, 2500, 800, 6000, 300, 4200, 1500};
+
+    // experimental spectra, in intensity order: the library's peaks jittered
+    // within tolerance; a partial match with extra peaks, two peaks within
+    // tolerance of one library peak and peaks just inside and just outside
+    // the 20 ppm tolerance; a single peak; and peaks beyond the dense
+    // vector's m/z range that match nothing
+    vector<vector<float>> mzs = {
+        {150.0512, 312.2985, 512.6021, 203.1, 650.7095, 250.2, 101.0009, 400.4498},
+        {150.05, 150.0509, 203.1040, 312.3063, 99.5, 512.6, 777.7, 333.3},
+        {150.05},
+        {2100.0, 2200.0, 2300.0}};
+    vector<vector<float>> intensities = {
+        {9000, 7000, 4000, 3000, 1800, 900, 600, 250},
+        {8000, 7500, 2000, 1500, 1200, 900, 600, 100},
+        {1000},
+        {300, 200, 100}};
+
+    float productPpmTolr = 20;
+    vector<string> algorithms = FragmentationMatchScore::getScoringAlgorithmNames();
+    for (unsigned int k = 0; k < mzs.size(); k++) {
+        Fragment* library = makeFragment(libraryMzs, libraryIntensities);
+        library->annotations[1] = "C6H5";
+        library->annotations[4] = "C12H11O2";
+        Fragment* oldExperimental = makeFragment(mzs[k], intensities[k]);
+        Fragment* experimental = makeFragment(mzs[k], intensities[k]);
+
+        FragmentationMatchScore expected = oldScoreMatch(library, oldExperimental, productPpmTolr);
+        FragmentationMatchScore s = library->scoreMatch(experimental, productPpmTolr);
+        QVERIFY(s.numMatches == expected.numMatches);
+        QVERIFY(TestUtils::floatCompare(s.fractionMatched, expected.fractionMatched));
+        QVERIFY(TestUtils::floatCompare(s.ppmError, expected.ppmError));
+        QVERIFY(TestUtils::floatCompare(s.mzFragError, expected.mzFragError));
+        QVERIFY(TestUtils::floatCompare(s.spearmanRankCorrelation,
+                                        expected.spearmanRankCorrelation));
+        QVERIFY(TestUtils::floatCompare(s.ticMatched, expected.ticMatched));
+        QVERIFY(TestUtils::floatCompare(s.dotProduct, expected.dotProduct));
+        QVERIFY(TestUtils::floatCompare(s.hypergeomScore, expected.hypergeomScore));
+        QVERIFY(TestUtils::floatCompare(s.mvhScore, expected.mvhScore));
+        QVERIFY(TestUtils::floatCompare(s.weightedDotProduct,
+                                        expected.weightedDotProduct));
+        QVERIFY(experimental->annotations == oldExperimental->annotations);
+
+        // a single named score is the same as when every score is computed
+        for (auto& algorithm : algorithms) {
+            Fragment* single = makeFragment(mzs[k], intensities[k]);
+            FragmentationMatchScore named = library->scoreMatch(single,
+                                                                productPpmTolr,
+                                                                algorithm);
+            QVERIFY(TestUtils::floatCompare(named.mergedScore,
+                                            expected.getScoreByName(algorithm)));
+            delete single;
+        }
+
+        delete library;
+        delete oldExperimental;
+        delete experimental;
+    }
+}
+
+void TestScan::testBuildConsensus() {
+    // the consensus of brothers as it was built by matching each brother
+    // against the growing consensus with compareRanks, for a fragment that
+    // has the most peaks of its brothers
+    auto oldConsensus = [](Fragment* self, float productPpmTolr) {
+        Fragment* consensusFrag = new Fragment(self);
+        consensusFrag->sortByMz();
+        for (auto brother : self->brothers) {
+            vector<int> ranks = Fragment::compareRanks(brother,
+                                                       consensusFrag,
+                                                       productPpmTolr);
+            for (unsigned int j = 0; j < ranks.size(); j++) {
+                int posA = ranks[j];
+                if (posA >= 0) {
+                    consensusFrag->intensityValues[posA] += brother->intensityValues[j];
+                    consensusFrag->obscount[posA] += 1;
+                } else {
+                    consensusFrag->mzValues.push_back(brother->mzValues[j]);
+                    consensusFrag->intensityValues.push_back(brother->intensityValues[j]);
+                    consensusFrag->obscount.push_back(1);
+                }
+            }
+            consensusFrag->sortByMz();
+        }
+        int N = 1 + self->brothers.size();
+        for (unsigned int i = 0; i < consensusFrag->intensityValues.size(); i++)
+            consensusFrag->intensityValues[i] /= N;
+        consensusFrag->sortByIntensity();
+        float maxValue = consensusFrag->intensityValues[0];
+        for (unsigned int i = 0; i < consensusFrag->intensityValues.size(); i++)
+            consensusFrag->intensityValues[i] = consensusFrag->intensityValues[i] / maxValue * 10000;
+        return consensusFrag;
+    };
+
+    auto makeFragment = [](const vector<float>& mzs, const vector<float>& intensities) {
+        Fragment* fragment = new Fragment();
+        fragment->mzValues = mzs;
+        fragment->intensityValues = intensities;
+        fragment->obscount = vector<int>(mzs.size(), 1);
+        for (unsigned int i = 0; i < mzs.size(); i += 3)
+            fragment->annotations[i] = "peak";
+        return fragment;
+    };
+
+    // peaks within tolerance of the seed's peak on either side join it,
+    // even though they are not within tolerance of each other
+    Fragment* fragment = makeFragment({100.0015, 200, 300}, {1000, 500, 200});
+    fragment->addBrotherFragment(makeFragment({100.0}, {1000}));
+    fragment->addBrotherFragment(makeFragment({100.003}, {1000}));
+    fragment->buildConsensus(20);
+    Fragment* consensus = fragment->consensus;
+    QVERIFY(consensus->nobs() == 3);
+    QVERIFY(consensus->mzValues[0] == 100.0015f);
+    QVERIFY(consensus->obscount[0] == 3);
+
+    // replicate spectra with dropped, jittered and added peaks
+    srand(5);
+    int fragmentCount = 0;
+    for (int t = 0; t < 200; t++) {
+        vector<float> mzs;
+        vector<float> intensities;
+        for (int i = 0; i < 5 + rand() % 30; i++) {
+            mzs.push_back(50 + (rand() % 50000) / 100.0f);
+            intensities.push_back(100 + rand() % 10000);
+        }
+        Fragment* fragment = makeFragment(mzs, intensities);
+        for (int b = 0; b < rand() % 8; b++) {
+            vector<float> brotherMzs;
+            vector<float> brotherIntensities;
+            for (unsigned int i = 0; i < mzs.size(); i++) {
+                if (rand() % 4 == 0)
+                    continue;
+                brotherMzs.push_back(mzs[i] * (1 + (rand() % 40 - 20) * 1e-6f));
+                brotherIntensities.push_back(100 + rand() % 10000);
+            }
+            if (rand() % 2)
+                brotherMzs.push_back(50 + (rand() % 50000) / 100.0f);
+            brotherIntensities.resize(brotherMzs.size(), 500);
+            fragment->addBrotherFragment(makeFragment(brotherMzs, brotherIntensities));
+        }
+
+        bool hasMostPeaks = true;
+        for (auto brother : fragment->brothers) {
+            if (brother->nobs() > fragment->nobs())
+                hasMostPeaks = false;
+        }
+        if (!hasMostPeaks)
+            continue;
+        fragmentCount++;
+
+        Fragment* expected = oldConsensus(fragment, 20);
+        fragment->buildConsensus(20);
+        Fragment* consensus = fragment->consensus;
+        QVERIFY(consensus->mzValues == expected->mzValues);
+        QVERIFY(consensus->intensityValues == expected->intensityValues);
+        QVERIFY(consensus->obscount == expected->obscount);
+        // copies of the seed never carried its annotations
+        QVERIFY(consensus->annotations == expected->annotations);
+        delete expected;
+    }
+    QVERIFY(fragmentCount > 100);
+}
+
+void TestScan::testFragmentationEvents() {
+    // a run alternating MS1 scans with three MS2 scans, whose precursors
+    // repeat every few cycles
+    mzSample* ms2Sample = new mzSample();
+    float precursorMzs[5] = {150.05, 200.1, 250.15, 300.2, 350.25};
+    int scanNum = 0;
+    for (int cycle = 0; cycle < 200; cycle++) {
+        ms2Sample->addScan(new Scan(ms2Sample, 0, 1, scanNum++ * 0.01f, 0, 1));
+        for (int k = 0; k < 3; k++) {
+            float precursorMz = precursorMzs[(cycle + k) % 5];
+            ms2Sample->addScan(new Scan(ms2Sample,
+                                        0,
+                                        2,
+                                        scanNum++ * 0.01f,
+                                        precursorMz,
+                                        1));
+        }
+    }
+
+    // MS2 scans of the slice found by walking every scan of the sample
+    auto linearSearch = [ms2Sample](mzSlice* slice) {
+        vector<Scan*> matchedScans;
+        for (auto scan : ms2Sample->scans) {
+            if (scan->mslevel != 2)
+                continue;
+            if (scan->rt < slice->rtmin || scan->rt > slice->rtmax)
+                continue;
+            if (scan->precursorMz >= slice->mzmin
+                && scan->precursorMz <= slice->mzmax)
+                matchedScans.push_back(scan);
+        }
+        return matchedScans;
+    };
+
+    // a window whose m/z and RT bounds fall exactly on two MS2 scans
+    Scan* first = ms2Sample->scans[101];
+    Scan* last = ms2Sample->scans[203];
+    vector<mzSlice> slices;
+    slices.push_back(mzSlice(min(first->precursorMz, last->precursorMz),
+                             max(first->precursorMz, last->precursorMz),
+                             first->rt,
+                             last->rt));
+    // a window holding a single precursor m/z
+    slices.push_back(mzSlice(200.1, 200.1, 0, 10));
+    // windows just inside and just outside a precursor
+    slices.push_back(mzSlice(200.0999, 200.1001, 0, 10));
+    slices.push_back(mzSlice(200.1001, 250.1499, 0, 10));
+    // empty RT ranges: between two scans, beyond the run and inverted
+    slices.push_back(mzSlice(0, 1000, 1.005, 1.006));
+    slices.push_back(mzSlice(0, 1000, 20, 30));
+    slices.push_back(mzSlice(0, 1000, 3, 2));
+    // a window covering the whole run
+    slices.push_back(mzSlice(0, 1000, -1, 100));
+    srand(7);
+    for (int i = 0; i < 200; i++) {
+        float mzmin = 100 + rand() % 30000 / 100.0f;
+        float rtmin = rand() % 800 / 100.0f;
+        slices.push_back(mzSlice(mzmin,
+                                 mzmin + rand() % 10000 / 100.0f,
+                                 rtmin,
+                                 rtmin + rand() % 300 / 100.0f));
+    }
+
+    for (auto& slice : slices) {
+        vector<Scan*> matchedScans = ms2Sample->getFragmentationEvents(&slice);
+        QVERIFY(matchedScans == linearSearch(&slice));
+    }
+    vector<Scan*> matchedScans = ms2Sample->getFragmentationEvents(&slices[0]);
+    QVERIFY(matchedScans.front() == first);
+    QVERIFY(matchedScans.back() == last);
+    QVERIFY(ms2Sample->getFragmentationEvents(&slices[1]).size() == 120);
+    QVERIFY(ms2Sample->getFragmentationEvents(&slices[2]).size() == 120);
+    QVERIFY(ms2Sample->getFragmentationEvents(&slices[3]).empty());
+    QVERIFY(ms2Sample->getFragmentationEvents(&slices[4]).empty());
+    QVERIFY(ms2Sample->getFragmentationEvents(&slices[5]).empty());
+    QVERIFY(ms2Sample->getFragmentationEvents(&slices[6]).empty());
+    QVERIFY(ms2Sample->getFragmentationEvents(&slices[7]).size() == 600);
+
+    delete ms2Sample;
+}
+
+void TestScan::testLinkMs2Scans() {
+    // MS2 scans before the first MS1 scan, a regular run alternating MS1
+    // scans with three MS2 scans and a long stretch of MS2 scans that ends
+    // up too far from its full scan
+    auto makeSample = []() {
+        mzSample* sample = new mzSample();
+        float precursorMzs[3] = {150.05f, 200.1f, 250.15f};
+        int scanNum = 0;
+        auto addMs1 = [&](int cycle) {
+            Scan* scan = new Scan(sample, 0, 1, scanNum++ * 0.01f, 0, 1);
+            for (float precursorMz : precursorMzs) {
+                scan->mz.push_back(precursorMz - 0.3f);
+                scan->intensity.push_back(1000.0f + cycle * 200);
+                scan->mz.push_back(precursorMz + 0.0008f);
+                scan->intensity.push_back(5000.0f + (cycle % 7) * 100);
+                scan->mz.push_back(precursorMz + 0.2f);
+                scan->intensity.push_back(2000.0f);
+            }
+            sample->addScan(scan);
+        };
+        auto addMs2 = [&](float precursorMz) {
+            sample->addScan(
+                new Scan(sample, 0, 2, scanNum++ * 0.01f, precursorMz, 1));
+        };
+
+        addMs2(precursorMzs[0]);
+        addMs2(precursorMzs[1]);
+        for (int cycle = 0; cycle < 20; cycle++) {
+            addMs1(cycle);
+            for (int k = 0; k < 3; k++)
+                addMs2(precursorMzs[(cycle + k) % 3]);
+        }
+        for (int k = 0; k < 60; k++)
+            addMs2(precursorMzs[k % 3]);
+        addMs1(20);
+        addMs2(precursorMzs[2]);
+        return sample;
+    };
+
+    // the linked sample against one whose scans find their full scan by
+    // walking back through the sample
+    mzSample* linkedSample = makeSample();
+    linkedSample->linkMs2Scans();
+    mzSample* walkedSample = makeSample();
+    for (auto scan : walkedSample->scans)
+        scan->recalculatePrecursorMz(10);
+
+    QVERIFY(linkedSample->scans.size() == walkedSample->scans.size());
+    for (unsigned int i = 0; i < linkedSample->scans.size(); i++) {
+        Scan* linked = linkedSample->scans[i];
+        Scan* walked = walkedSample->scans[i];
+        QVERIFY(linked->precursorMz == walked->precursorMz);
+        for (float ppm : {5.0f, 10.0f, 20.0f}) {
+            QVERIFY(TestUtils::floatCompare(linked->getPrecursorPurity(ppm),
+                                            walked->getPrecursorPurity(ppm)));
+        }
+    }
+
+    // scans without a full scan close enough before them have no purity
+    int lastScan = linkedSample->scans.size() - 1;
+    QVERIFY(linkedSample->scans[0]->getPrecursorPurity(10) == 0);
+    QVERIFY(linkedSample->scans[lastScan - 2]->getPrecursorPurity(10) == 0);
+    QVERIFY(linkedSample->scans[3]->getPrecursorPurity(10) > 0);
+    QVERIFY(linkedSample->scans[lastScan]->getPrecursorPurity(10) > 0);
+
+    // a copy moved to another scan number finds the full scan before its
+    // new position rather than the one the original was linked to
+    Scan* copy = new Scan(nullptr, 0, 0, 0, 0, 0);
+    copy->deepcopy(linkedSample->scans[3]);
+    copy->scannum = 7;
+    QVERIFY(TestUtils::floatCompare(copy->getPrecursorPurity(5),
+                                    linkedSample->scans[7]->getPrecursorPurity(5)));
+    QVERIFY(!TestUtils::floatCompare(copy->getPrecursorPurity(5),
+                                     linkedSample->scans[3]->getPrecursorPurity(5)));
+
+    delete copy;
+    delete linkedSample;
+    delete walkedSample;
+}
@@ -40,6 +40,13 @@ class TestScan : public QObject {
         void testchargeSeries();
         void testdeconvolute();
         void testgetTopPeaks();
+        void testSpectralSearch();
+        void testSpectralSearchMatchesScanScoring();
+        void testSpectraClustering();
+        void testScoreMatch();
+        void testBuildConsensus();
+        void testFragmentationEvents();
+        void testLinkMs2Scans();
 
 };
 